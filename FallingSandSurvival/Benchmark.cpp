@@ -0,0 +1,522 @@
+
+// headless simulation benchmark (the FallingSandSurvivalBenchmark target)
+// runs World::tick/tickTemperature/tickParticles/tickObjects without a GPU_Target or audio engine,
+//   so the simulation can be measured on build machines
+// needs to be run from the game directory like the game itself (textures/objects are loaded from assets/)
+
+#include "world.hpp"
+#include "Settings.hpp"
+#include <box2d/b2_fixture.h>
+#include "RNG.hpp"
+#include "Networking.hpp"
+
+#include "DefaultGenerator.cpp"
+#include "MaterialTestGenerator.cpp"
+
+#include <cxxopts.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+// allocation counting
+// replacing the global operator new counts allocations made by every thread (tick pool included),
+//   but the main thread always waits for the pools so the counts still line up with the phases
+#pragma region
+static std::atomic<unsigned long long> allocCount {0};
+static std::atomic<unsigned long long> allocBytes {0};
+
+void* operator new(size_t size) {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = malloc(size == 0 ? 1 : size);
+    if(p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    return malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t& t) noexcept {
+    return operator new(size, t);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+#pragma endregion
+
+class BenchmarkPhase {
+public:
+    const char* name;
+    double totalMs = 0;
+    double maxMs = 0;
+    int calls = 0;
+    unsigned long long allocs = 0;
+    unsigned long long bytes = 0;
+
+    BenchmarkPhase(const char* name) {
+        this->name = name;
+    }
+
+    template <typename F>
+    void run(F fn) {
+        unsigned long long a = allocCount.load(std::memory_order_relaxed);
+        unsigned long long b = allocBytes.load(std::memory_order_relaxed);
+        auto start = std::chrono::high_resolution_clock::now();
+
+        fn();
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        totalMs += ms;
+        if(ms > maxMs) maxMs = ms;
+        calls++;
+        allocs += allocCount.load(std::memory_order_relaxed) - a;
+        bytes += allocBytes.load(std::memory_order_relaxed) - b;
+    }
+};
+
+class BenchmarkScenario {
+public:
+    const char* name;
+    // called once after the world is loaded
+    std::function<void(World*, RNG&)> setup;
+    // called before every tick (for spouts/explosions/etc)
+    std::function<void(World*, RNG&, int)> script;
+};
+
+// fills a rect of the tick zone (x/y/w/h relative to tickZone)
+static void fillRect(World* world, int x, int y, int w, int h, std::function<MaterialInstance(int, int)> fn) {
+    for(int xx = x; xx < x + w; xx++) {
+        for(int yy = y; yy < y + h; yy++) {
+            int wx = world->tickZone.x + xx;
+            int wy = world->tickZone.y + yy;
+            world->setTile(wx, wy, fn(wx, wy));
+        }
+    }
+}
+
+// puts a stone container (floor + walls) around the tick zone
+// with a generator the scenarios are stamped on top of the generated terrain
+static void makeContainer(World* world) {
+    int w = world->tickZone.w;
+    int h = world->tickZone.h;
+    fillRect(world, 0, h - 16, w, 16, [](int x, int y) { return Tiles::createCobbleStone(x, y); });
+    fillRect(world, 0, 0, 16, h, [](int x, int y) { return Tiles::createCobbleStone(x, y); });
+    fillRect(world, w - 16, 0, 16, h, [](int x, int y) { return Tiles::createCobbleStone(x, y); });
+}
+
+static std::vector<BenchmarkScenario> makeScenarios() {
+    std::vector<BenchmarkScenario> scenarios;
+
+    // a big block of sand collapsing into a pile + a spout pouring onto it
+    scenarios.push_back({"sand", [](World* world, RNG& rng) {
+        makeContainer(world);
+        int w = world->tickZone.w;
+        int h = world->tickZone.h;
+        fillRect(world, w / 2 - w / 8, h / 8, w / 4, h / 2, [](int x, int y) { return Tiles::createTestSand(); });
+    }, [](World* world, RNG& rng, int tick) {
+        if(tick % 2 != 0) return;
+        fillRect(world, world->tickZone.w / 2 - 8 + rng.next() % 5 - 2, 20, 16, 4, [](int x, int y) { return Tiles::createTestSand(); });
+    }});
+
+    // dam break: the left half of the container is full of water
+    scenarios.push_back({"water", [](World* world, RNG& rng) {
+        makeContainer(world);
+        int w = world->tickZone.w;
+        int h = world->tickZone.h;
+        fillRect(world, 16, h / 4, w / 2 - 16, h * 3 / 4 - 16, [](int x, int y) { return Tiles::createWater(); });
+    }, [](World* world, RNG& rng, int tick) {
+        if(tick % 4 != 0) return;
+        fillRect(world, world->tickZone.w - 64 + rng.next() % 9 - 4, 20, 24, 4, [](int x, int y) { return Tiles::createWater(); });
+    }});
+
+    // lava pool on the left, water pouring in from the right (temperature + obsidian/steam reactions)
+    scenarios.push_back({"lava", [](World* world, RNG& rng) {
+        makeContainer(world);
+        int w = world->tickZone.w;
+        int h = world->tickZone.h;
+        fillRect(world, 16, h / 2, w / 2 - 16, h / 2 - 16, [](int x, int y) { return Tiles::createLava(); });
+        fillRect(world, w / 2, h / 4, w / 2 - 16, h / 4, [](int x, int y) { return Tiles::createWater(); });
+    }, [](World* world, RNG& rng, int tick) {
+        if(tick % 3 != 0) return;
+        fillRect(world, world->tickZone.w / 4 + rng.next() % 9 - 4, 20, 16, 4, [](int x, int y) { return Tiles::createWater(); });
+        fillRect(world, world->tickZone.w * 3 / 4 + rng.next() % 9 - 4, 20, 16, 4, [](int x, int y) { return Tiles::createLava(); });
+    }});
+
+    // container full of dirt/sand/water being blown up all the time (particles + rigid body mesh updates)
+    scenarios.push_back({"explosions", [](World* world, RNG& rng) {
+        makeContainer(world);
+        int w = world->tickZone.w;
+        int h = world->tickZone.h;
+        fillRect(world, 16, h / 2, w - 32, h / 2 - 16, [&](int x, int y) {
+            switch(rng.next() % 4) {
+            case 0: return Tiles::createTestSand();
+            case 1: return Tiles::createWater();
+            case 2: return Tiles::createSoftDirt(x, y);
+            default: return Tiles::createCobbleDirt(x, y);
+            }
+        });
+    }, [](World* world, RNG& rng, int tick) {
+        if(tick % 5 != 0) return;
+        int x = world->tickZone.x + 32 + rng.next() % (world->tickZone.w - 64);
+        int y = world->tickZone.y + world->tickZone.h / 2 + rng.next() % (world->tickZone.h / 2 - 32);
+        world->explosion(x, y, 10 + rng.next() % 20);
+    }});
+
+    // a big solid block with fire spreading through it from the top
+    scenarios.push_back({"fire", [](World* world, RNG& rng) {
+        makeContainer(world);
+        int w = world->tickZone.w;
+        int h = world->tickZone.h;
+        fillRect(world, 16, h / 4, w - 32, h * 3 / 4 - 16, [](int x, int y) { return Tiles::createCobbleDirt(x, y); });
+        fillRect(world, 16, h / 4 - 2, w - 32, 2, [](int x, int y) { return Tiles::createFire(); });
+    }, [](World* world, RNG& rng, int tick) {}});
+
+    return scenarios;
+}
+
+static World* makeWorld(std::string generatorName, uint16_t w, uint16_t h, unsigned int seed) {
+    WorldGenerator* generator;
+    if(generatorName == "default") {
+        generator = new DefaultGenerator();
+    } else {
+        // "none" still needs a generator to init, but never loads any chunks from it
+        generator = new MaterialTestGenerator();
+    }
+
+    World* world = new World();
+    world->noSaveLoad = true;
+    world->init("benchmark", w, h, nullptr, nullptr, NetworkMode::SERVER, generator);
+    world->noise.SetSeed(seed);
+    world->noiseSIMD->SetSeed(seed);
+
+    // same as Game::updateFrameLate
+    world->tickZone = {CHUNK_W, CHUNK_H, world->width - CHUNK_W * 2, world->height - CHUNK_H * 2};
+
+    if(generatorName != "none") {
+        // same as Game::loadWorld
+        for(int x = -CHUNK_W * 4; x < world->width + CHUNK_W * 4; x += CHUNK_W) {
+            for(int y = -CHUNK_H * 3; y < world->height + CHUNK_H * 8; y += CHUNK_H) {
+                world->queueLoadChunk(x / CHUNK_W, y / CHUNK_H, true, true);
+            }
+        }
+
+        while(true) {
+            world->frame();
+            if(world->needToTickGeneration) world->tickChunkGeneration();
+            if(world->toLoad.size() == 0 && world->readyToReadyToMerge.size() == 0 && world->readyToMerge.size() == 0 && !world->needToTickGeneration) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    return world;
+}
+
+static const char* tickModeName() {
+    if(Settings::tick_lod) return Settings::tick_cell_kernels ? "cell kernels + distance LOD" : "old tick loop + distance LOD";
+    if(!Settings::tick_cell_kernels) return "old tick loop";
+    if(Settings::tick_liquid_solver && Settings::tick_reactive_set) return "cell kernels + liquid solver + sparse fire";
+    if(Settings::tick_liquid_solver) return "cell kernels + liquid solver";
+    if(Settings::tick_reactive_set) return "cell kernels + sparse fire";
+    return "cell kernels";
+}
+
+class BenchmarkResult {
+public:
+    double simulatedCellsPerSec = 0;
+    // hash of the tick zone's materials at the end, runs that simulated the same thing end up with the same hash
+    uint32_t materialHash = 0;
+};
+
+static BenchmarkResult runScenario(BenchmarkScenario& scenario, std::string generatorName, uint16_t w, uint16_t h, int ticks, unsigned int seed) {
+    printf("== %s (%dx%d, generator %s, %d ticks, seed %u, %s)\n", scenario.name, w, h, generatorName.c_str(), ticks, seed, tickModeName());
+
+    BenchmarkPhase load("load");
+    World* world = nullptr;
+    load.run([&]() {
+        world = makeWorld(generatorName, w, h, seed);
+    });
+
+    RNG rng(seed);
+    RNG::local().setSeed(seed);
+    scenario.setup(world, rng);
+
+    // pretend the screen is the middle 2x2 chunks so --lod has rings to work with
+    world->lodFocus = {world->tickZone.x + world->tickZone.w / 2 - CHUNK_W, world->tickZone.y + world->tickZone.h / 2 - CHUNK_H, CHUNK_W * 2, CHUNK_H * 2};
+
+    BenchmarkPhase script("script");
+    BenchmarkPhase tick("tick");
+    BenchmarkPhase tickTemperature("tickTemperature");
+    BenchmarkPhase tickParticles("tickParticles");
+    BenchmarkPhase tickObjects("tickObjects");
+    BenchmarkPhase updateMesh("updateWorldMesh");
+
+    // tiles that tick() actually looked at (sum of the active rects), vs the whole tick zone
+    unsigned long long simulatedCells = 0;
+    unsigned long long zoneCells = 0;
+    size_t maxParticles = 0;
+
+    // same order as Game::tick
+    for(int i = 0; i < ticks; i++) {
+        script.run([&]() {
+            scenario.script(world, rng, i);
+        });
+
+        for(int j = 0; j < world->activeW * world->activeH; j++) {
+            simulatedCells += (unsigned long long)world->active[j].w * world->active[j].h;
+        }
+        zoneCells += (unsigned long long)world->tickZone.w * world->tickZone.h;
+
+        tick.run([&]() {
+            world->tick();
+        });
+
+        tickParticles.run([&]() {
+            world->tickParticles();
+        });
+        maxParticles = std::max(maxParticles, world->particles.size());
+
+        tickObjects.run([&]() {
+            world->tickObjectBounds();
+            if(Settings::tick_box2d) world->tickObjects();
+            if(i % 10 == 0) world->tickObjectsMesh();
+        });
+
+        if(Settings::tick_temperature) {
+            tickTemperature.run([&]() {
+                world->tickTemperature();
+            });
+        }
+
+        if(Settings::tick_box2d && i % 4 == 0) {
+            updateMesh.run([&]() {
+                world->updateWorldMesh();
+            });
+        }
+    }
+
+    printf("%-16s %8s %10s %9s %9s %12s %12s\n", "phase", "calls", "total ms", "avg ms", "max ms", "allocs", "alloc KB");
+    BenchmarkPhase* phases[] = {&load, &script, &tick, &tickTemperature, &tickParticles, &tickObjects, &updateMesh};
+    double simMs = 0;
+    for(BenchmarkPhase* p : phases) {
+        printf("%-16s %8d %10.2f %9.3f %9.3f %12llu %12llu\n", p->name, p->calls, p->totalMs, p->calls > 0 ? p->totalMs / p->calls : 0.0, p->maxMs, p->allocs, p->bytes / 1024);
+        if(p != &load && p != &script) simMs += p->totalMs;
+    }
+
+    double tickSec = tick.totalMs / 1000.0;
+    printf("simulated cells/s (tick):     %14.0f\n", tickSec > 0 ? simulatedCells / tickSec : 0.0);
+    printf("tick zone cells/s (tick):     %14.0f\n", tickSec > 0 ? zoneCells / tickSec : 0.0);
+    printf("tick zone cells/s (all sim):  %14.0f\n", simMs > 0 ? zoneCells / (simMs / 1000.0) : 0.0);
+    printf("avg sim ms/tick:              %14.3f\n", ticks > 0 ? simMs / ticks : 0.0);
+    printf("max particles:                %14zu\n", maxParticles);
+
+    BenchmarkResult result;
+    result.simulatedCellsPerSec = tickSec > 0 ? simulatedCells / tickSec : 0.0;
+    for(int y = world->tickZone.y; y < world->tickZone.y + world->tickZone.h; y++) {
+        for(int x = world->tickZone.x; x < world->tickZone.x + world->tickZone.w; x++) {
+            result.materialHash = RNG::hash(result.materialHash, world->tiles[x + y * world->width].mat->id);
+        }
+    }
+    printf("material hash:                      %08x\n", result.materialHash);
+    printf("\n");
+
+    delete world;
+
+    return result;
+}
+
+// builds the terrain colliders over the whole tick zone with buildChunkPolys and with buildChunkBoxes,
+//   then drops the same boxes onto each and steps Box2D like tickObjects does
+static void compareColliders(BenchmarkScenario& scenario, std::string generatorName, uint16_t w, uint16_t h, int ticks, unsigned int seed) {
+    printf("== %s colliders (%dx%d, generator %s, %d steps, seed %u)\n", scenario.name, w, h, generatorName.c_str(), ticks, seed);
+
+    World* world = makeWorld(generatorName, w, h, seed);
+    RNG rng(seed);
+    RNG::local().setSeed(seed);
+    scenario.setup(world, rng);
+    world->meshZone = world->tickZone;
+
+    printf("%-16s %10s %9s %10s %9s %9s %12s %12s\n", "colliders", "build ms", "fixtures", "step ms", "avg ms", "max ms", "avg contacts", "max contacts");
+    bool modes[] = {false, true};
+    for(bool boxes : modes) {
+        Settings::tick_box_colliders = boxes;
+
+        // every chunk's mesh was built by the other builder (or not at all), so this rebuilds all of them
+        BenchmarkPhase build("build");
+        build.run([&]() {
+            world->updateWorldMesh();
+        });
+
+        int fixtures = 0;
+        for(RigidBody* cur : world->worldRigidBodies) {
+            for(b2Fixture* f = cur->body->GetFixtureList(); f; f = f->GetNext()) fixtures++;
+        }
+
+        RNG drop(seed);
+        std::vector<b2Body*> bodies;
+        for(int i = 0; i < 200; i++) {
+            b2BodyDef def;
+            def.type = b2_dynamicBody;
+            def.position.Set((float)(world->tickZone.x + 32 + drop.next() % (world->tickZone.w - 64)), (float)(world->tickZone.y + 16 + drop.next() % (world->tickZone.h / 2)));
+            b2Body* body = world->b2world->CreateBody(&def);
+
+            b2PolygonShape sh;
+            sh.SetAsBox((float)(2 + drop.next() % 4), (float)(2 + drop.next() % 4));
+            b2FixtureDef fixtureDef;
+            fixtureDef.shape = &sh;
+            fixtureDef.density = 1;
+            fixtureDef.friction = 0.3f;
+            body->CreateFixture(&fixtureDef);
+            bodies.push_back(body);
+        }
+
+        BenchmarkPhase step("step");
+        unsigned long long contacts = 0;
+        int maxContacts = 0;
+        for(int i = 0; i < ticks; i++) {
+            step.run([&]() {
+                world->b2world->Step(33.0f / 1000.0f, 5, 2);
+            });
+            int c = world->b2world->GetContactCount();
+            contacts += c;
+            maxContacts = std::max(maxContacts, c);
+        }
+
+        for(b2Body* body : bodies) world->b2world->DestroyBody(body);
+
+        printf("%-16s %10.2f %9d %10.2f %9.3f %9.3f %12.1f %12d\n", boxes ? "boxes" : "marching squares", build.totalMs, fixtures,
+               step.totalMs, step.calls > 0 ? step.totalMs / step.calls : 0.0, step.maxMs, ticks > 0 ? (double)contacts / ticks : 0.0, maxContacts);
+    }
+    printf("\n");
+
+    delete world;
+}
+
+int main(int argc, char* argv[]) {
+    cxxopts::Options options("FallingSandSurvivalBenchmark", "Headless World simulation benchmark");
+    options.add_options()
+        ("h,help", "Print this help message")
+        ("scenario", "Scenario to run (\"sand\", \"water\", \"lava\", \"explosions\", \"fire\", \"all\")", cxxopts::value<std::string>()->default_value("all"))
+        ("ticks", "Number of ticks per scenario", cxxopts::value<int>()->default_value("600"))
+        ("generator", "World to run the scenario in (\"none\", \"test\", \"default\")", cxxopts::value<std::string>()->default_value("none"))
+        ("width", "World width in chunks", cxxopts::value<int>()->default_value("8"))
+        ("height", "World height in chunks", cxxopts::value<int>()->default_value("6"))
+        ("seed", "RNG/noise seed", cxxopts::value<unsigned int>()->default_value("1"))
+        ("no-temperature", "Don't run tickTemperature")
+        ("no-box2d", "Don't run tickObjects/updateWorldMesh")
+        ("no-kernels", "Use the old tick loop instead of the per-PhysicsType cell kernels")
+        ("no-liquid-solver", "Tick liquids with everything else instead of in their own substeps")
+        ("no-reactive-set", "Tick fire/temperature reactions with everything else instead of from the sparse set")
+        ("lod", "Tick chunks further from the middle of the world less often (Settings::tick_lod)")
+        ("compare-kernels", "Run every scenario with the old tick loop and with the cell kernels and compare them")
+        ("compare-colliders", "Build every scenario's terrain colliders with marching squares and with boxes, and compare building/stepping them (--ticks steps)")
+        ;
+
+    try {
+        auto result = options.parse(argc, argv);
+
+        if(result.count("help")) {
+            std::cout << options.help() << std::endl;
+            return 0;
+        }
+
+        std::string scenarioName = result["scenario"].as<std::string>();
+        std::string generatorName = result["generator"].as<std::string>();
+        int ticks = result["ticks"].as<int>();
+        uint16_t w = (uint16_t)(std::max(result["width"].as<int>(), 3) * CHUNK_W);
+        uint16_t h = (uint16_t)(std::max(result["height"].as<int>(), 3) * CHUNK_H);
+        unsigned int seed = result["seed"].as<unsigned int>();
+
+        if(generatorName != "none" && generatorName != "test" && generatorName != "default") {
+            std::cerr << "Unknown generator: " << generatorName << std::endl;
+            return -1;
+        }
+
+        Settings::tick_temperature = !result["no-temperature"].as<bool>();
+        Settings::tick_box2d = !result["no-box2d"].as<bool>();
+        Settings::tick_cell_kernels = !result["no-kernels"].as<bool>();
+        Settings::tick_liquid_solver = !result["no-liquid-solver"].as<bool>();
+        bool liquidSolver = Settings::tick_liquid_solver;
+        Settings::tick_reactive_set = !result["no-reactive-set"].as<bool>();
+        bool reactiveSet = Settings::tick_reactive_set;
+        Settings::tick_lod = result["lod"].as<bool>();
+        bool lod = Settings::tick_lod;
+        // rebuilt inline so the hitboxes (and whatever the bodies hit) come out the same every run
+        Settings::tick_hitbox_async = false;
+        bool compareKernels = result["compare-kernels"].as<bool>();
+        bool compareCollidersMode = result["compare-colliders"].as<bool>();
+
+        spdlog::set_level(spdlog::level::warn);
+
+        Materials::init();
+
+        std::vector<BenchmarkScenario> scenarios = makeScenarios();
+        bool ran = false;
+        for(auto& s : scenarios) {
+            if(scenarioName != "all" && scenarioName != s.name) continue;
+            if(compareCollidersMode) {
+                compareColliders(s, generatorName, w, h, ticks, seed);
+            } else if(compareKernels) {
+                // the kernels without the liquid solver have to simulate exactly the same thing as the old loop
+                Settings::tick_cell_kernels = false;
+                Settings::tick_liquid_solver = false;
+                Settings::tick_reactive_set = false;
+                Settings::tick_lod = false;
+                BenchmarkResult old = runScenario(s, generatorName, w, h, ticks, seed);
+                Settings::tick_cell_kernels = true;
+                BenchmarkResult kernels = runScenario(s, generatorName, w, h, ticks, seed);
+
+                printf("-- %s: old tick loop %.0f cells/s, cell kernels %.0f cells/s (%.2fx), %s\n", s.name,
+                       old.simulatedCellsPerSec, kernels.simulatedCellsPerSec,
+                       old.simulatedCellsPerSec > 0 ? kernels.simulatedCellsPerSec / old.simulatedCellsPerSec : 0.0,
+                       old.materialHash == kernels.materialHash ? "same result" : "RESULTS DIFFER");
+
+                // liquids/fire behave a bit differently with the solver/sparse set (and LOD skips ticks), so this one only compares speed
+                if(liquidSolver || reactiveSet || lod) {
+                    Settings::tick_liquid_solver = liquidSolver;
+                    Settings::tick_reactive_set = reactiveSet;
+                    Settings::tick_lod = lod;
+                    BenchmarkResult solver = runScenario(s, generatorName, w, h, ticks, seed);
+                    printf("-- %s: %s %.0f cells/s (%.2fx)\n", s.name, tickModeName(), solver.simulatedCellsPerSec,
+                           old.simulatedCellsPerSec > 0 ? solver.simulatedCellsPerSec / old.simulatedCellsPerSec : 0.0);
+                }
+                printf("\n");
+            } else {
+                runScenario(s, generatorName, w, h, ticks, seed);
+            }
+            ran = true;
+        }
+
+        if(!ran) {
+            std::cerr << "Unknown scenario: " << scenarioName << std::endl;
+            return -1;
+        }
+
+        return 0;
+    } catch(const cxxopts::option_not_exists_exception& e) {
+        std::cerr << "Invalid command line argument: " << e.what() << std::endl;
+        return -1;
+    }
+}
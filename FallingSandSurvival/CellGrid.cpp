@@ -0,0 +1,257 @@
+#include "CellGrid.hpp"
+
+#define BUILD_WITH_EASY_PROFILER
+#include <easy/profiler.h>
+#include "ProfilerConfig.hpp"
+
+Uint8* CellGrid::physicsType = nullptr;
+int* CellGrid::iterations = nullptr;
+float* CellGrid::conductionSelf = nullptr;
+float* CellGrid::conductionOther = nullptr;
+int32_t* CellGrid::addTemp = nullptr;
+CellProps* CellGrid::props = nullptr;
+int CellGrid::interactWords = 0;
+uint32_t* CellGrid::interactBits = nullptr;
+int* CellGrid::interactRow = nullptr;
+CellGrid::InteractPair* CellGrid::interactPairs = nullptr;
+MaterialInteraction* CellGrid::interactRules = nullptr;
+int* CellGrid::reactStart = nullptr;
+MaterialInteraction* CellGrid::reactRules = nullptr;
+
+void CellGrid::initMaterialTables() {
+    if(physicsType) return;
+
+    physicsType = new Uint8[Materials::nMaterials];
+    iterations = new int[Materials::nMaterials];
+    conductionSelf = new float[Materials::nMaterials];
+    conductionOther = new float[Materials::nMaterials];
+    addTemp = new int32_t[Materials::nMaterials];
+    props = new CellProps[Materials::nMaterials];
+
+    compileInteractions();
+
+    for(int i = 0; i < Materials::nMaterials; i++) {
+        Material* mat = Materials::MATERIALS_ARRAY[i];
+        physicsType[i] = (Uint8)mat->physicsType;
+        iterations[i] = mat->iterations;
+        conductionSelf[i] = mat->conductionSelf;
+        conductionOther[i] = mat->conductionOther;
+        addTemp[i] = (int32_t)mat->addTemp;
+
+        props[i].physicsType = (Uint8)mat->physicsType;
+        props[i].iterations = (Uint8)std::min(std::max(mat->iterations, 0), 255);
+        props[i].slipperyness = (Uint8)std::min(std::max(mat->slipperyness, 0), 255);
+        props[i].flags = (interactRow[i + 1] > interactRow[i] ? CELL_INTERACT : 0) | (reactStart[i + 1] > reactStart[i] ? CELL_REACT : 0);
+        props[i].density = mat->density;
+    }
+}
+
+void CellGrid::compileInteractions() {
+    int n = Materials::nMaterials;
+    interactWords = (n + 31) / 32;
+    interactBits = new uint32_t[n * interactWords];
+    memset(interactBits, 0, n * interactWords * sizeof(uint32_t));
+    interactRow = new int[n + 1];
+    reactStart = new int[n + 1];
+
+    // count first so everything is allocated exactly once
+    int nPairs = 0;
+    int nRules = 0;
+    int nReactRules = 0;
+    for(int i = 0; i < n; i++) {
+        Material* mat = Materials::MATERIALS_ARRAY[i];
+        if(mat->interact && mat->interactions) {
+            for(int j = 0; j < n; j++) {
+                int cnt = std::min(mat->nInteractions[j], (int)mat->interactions[j].size());
+                if(cnt <= 0) continue;
+                nPairs++;
+                nRules += cnt;
+            }
+        }
+        if(mat->react) nReactRules += std::min(mat->nReactions, (int)mat->reactions.size());
+    }
+
+    // one extra pair so interactPairs[k + 1].start is always valid
+    interactPairs = new InteractPair[nPairs + 1];
+    interactRules = new MaterialInteraction[std::max(nRules, 1)];
+    reactRules = new MaterialInteraction[std::max(nReactRules, 1)];
+
+    int pair = 0;
+    int rule = 0;
+    int reactRule = 0;
+    for(int i = 0; i < n; i++) {
+        Material* mat = Materials::MATERIALS_ARRAY[i];
+
+        interactRow[i] = pair;
+        if(mat->interact && mat->interactions) {
+            for(int j = 0; j < n; j++) {
+                int cnt = std::min(mat->nInteractions[j], (int)mat->interactions[j].size());
+                if(cnt <= 0) continue;
+                interactBits[i * interactWords + (j >> 5)] |= 1u << (j & 31);
+                interactPairs[pair].other = j;
+                interactPairs[pair].start = rule;
+                pair++;
+                for(int k = 0; k < cnt; k++) interactRules[rule++] = mat->interactions[j][k];
+            }
+        }
+
+        reactStart[i] = reactRule;
+        if(mat->react) {
+            int cnt = std::min(mat->nReactions, (int)mat->reactions.size());
+            for(int k = 0; k < cnt; k++) reactRules[reactRule++] = mat->reactions[k];
+        }
+    }
+    interactRow[n] = pair;
+    interactPairs[pair].other = n;
+    interactPairs[pair].start = rule;
+    reactStart[n] = reactRule;
+}
+
+const MaterialInteraction* CellGrid::interactionRules(int mat, int other, int* n) {
+    // rows are a handful of pairs at most, and only looked at after hasInteraction says there's something
+    int lo = interactRow[mat];
+    int hi = interactRow[mat + 1];
+    while(lo < hi) {
+        int mid = (lo + hi) / 2;
+        if(interactPairs[mid].other < other) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if(lo == interactRow[mat + 1] || interactPairs[lo].other != other) {
+        *n = 0;
+        return nullptr;
+    }
+    *n = interactPairs[lo + 1].start - interactPairs[lo].start;
+    return &interactRules[interactPairs[lo].start];
+}
+
+void CellGrid::init(int w, int h) {
+    initMaterialTables();
+
+    if(ownsPlanes) {
+        if(material) delete[] material;
+        if(color) delete[] color;
+        if(temperature) delete[] temperature;
+    }
+    if(conduction) delete[] conduction;
+    ownsPlanes = true;
+
+    width = w;
+    height = h;
+    material = new Uint16[w * h];
+    color = new Uint32[w * h];
+    temperature = new int32_t[w * h];
+    conduction = new float[w * h];
+
+    memset(material, 0, w * h * sizeof(Uint16));
+    memset(color, 0, w * h * sizeof(Uint32));
+    memset(temperature, 0, w * h * sizeof(int32_t));
+    memset(conduction, 0, w * h * sizeof(float));
+}
+
+void CellGrid::wrap(int w, int h, Uint16* material, Uint32* color, int32_t* temperature) {
+    initMaterialTables();
+
+    if(ownsPlanes) {
+        if(this->material) delete[] this->material;
+        if(this->color) delete[] this->color;
+        if(this->temperature) delete[] this->temperature;
+    }
+    if(conduction) delete[] conduction;
+    conduction = nullptr;
+    ownsPlanes = false;
+
+    width = w;
+    height = h;
+    this->material = material;
+    this->color = color;
+    this->temperature = temperature;
+}
+
+size_t CellGrid::planesSize(int w, int h) {
+    return (size_t)w * h * (sizeof(Uint16) + sizeof(Uint32) + sizeof(int32_t));
+}
+
+void CellGrid::gather(const MaterialInstance* tiles, int stride, int x, int y, int w, int h) {
+    EASY_FUNCTION();
+    for(int yy = y; yy < y + h; yy++) {
+        const MaterialInstance* src = &tiles[x + yy * stride];
+        int dst = x + yy * width;
+        for(int xx = 0; xx < w; xx++) {
+            material[dst + xx] = (Uint16)src[xx].mat->id;
+            color[dst + xx] = src[xx].color;
+            temperature[dst + xx] = src[xx].temperature;
+        }
+    }
+}
+
+void CellGrid::gatherMaterial(const MaterialInstance* tiles, int stride, int x, int y, int w, int h) {
+    for(int yy = y; yy < y + h; yy++) {
+        const MaterialInstance* src = &tiles[x + yy * stride];
+        Uint16* dst = &material[x + yy * width];
+        for(int xx = 0; xx < w; xx++) {
+            dst[xx] = (Uint16)src[xx].mat->id;
+        }
+    }
+}
+
+void CellGrid::gatherMaterial(const MaterialInstance* tiles, int stride, int x, int y, int w, int h, std::vector<int>& solidRemoved) {
+    for(int yy = y; yy < y + h; yy++) {
+        const MaterialInstance* src = &tiles[x + yy * stride];
+        Uint16* dst = &material[x + yy * width];
+        for(int xx = 0; xx < w; xx++) {
+            Uint16 m = (Uint16)src[xx].mat->id;
+            if(dst[xx] != m && props[dst[xx]].physicsType == PhysicsType::SOLID && props[m].physicsType != PhysicsType::SOLID) {
+                solidRemoved.push_back(x + xx + yy * width);
+            }
+            dst[xx] = m;
+        }
+    }
+}
+
+void CellGrid::gatherTemperature(const MaterialInstance* tiles, int stride, int x, int y, int w, int h) {
+    for(int yy = y; yy < y + h; yy++) {
+        const MaterialInstance* src = &tiles[x + yy * stride];
+        int dst = x + yy * width;
+        for(int xx = 0; xx < w; xx++) {
+            material[dst + xx] = (Uint16)src[xx].mat->id;
+            temperature[dst + xx] = src[xx].temperature;
+            conduction[dst + xx] = conductionOther[material[dst + xx]];
+        }
+    }
+}
+
+void CellGrid::scatter(MaterialInstance* tiles, int stride, int x, int y, int w, int h) {
+    EASY_FUNCTION();
+    for(int yy = y; yy < y + h; yy++) {
+        MaterialInstance* dst = &tiles[x + yy * stride];
+        int src = x + yy * width;
+        for(int xx = 0; xx < w; xx++) {
+            // twice as fast to set fields instead of making new ones
+            dst[xx].mat = Materials::MATERIALS_ARRAY[material[src + xx]];
+            dst[xx].color = color[src + xx];
+            dst[xx].temperature = temperature[src + xx];
+            dst[xx].id = MaterialInstance::_curID++;
+        }
+    }
+}
+
+void CellGrid::scatterTemperature(MaterialInstance* tiles, int stride, int x, int y, int w, int h) {
+    for(int yy = y; yy < y + h; yy++) {
+        MaterialInstance* dst = &tiles[x + yy * stride];
+        const int32_t* src = &temperature[x + yy * width];
+        for(int xx = 0; xx < w; xx++) {
+            dst[xx].temperature = src[xx];
+        }
+    }
+}
+
+CellGrid::~CellGrid() {
+    if(conduction) delete[] conduction;
+    if(!ownsPlanes) return;
+    if(material) delete[] material;
+    if(color) delete[] color;
+    if(temperature) delete[] temperature;
+}
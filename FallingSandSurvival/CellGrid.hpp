@@ -0,0 +1,106 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+#ifndef INC_MaterialInstance
+#include "MaterialInstance.hpp"
+#endif // !INC_MaterialInstance
+
+#include <cstdint>
+#include <vector>
+
+#define INC_CellGrid
+
+// CellProps::flags
+#define CELL_INTERACT 0x1 // Material::interact (and has interactions)
+#define CELL_REACT    0x2 // Material::react (and has reactions)
+
+// the Material fields the tick() kernels read, packed into 8 bytes so the whole table stays in cache
+struct CellProps {
+    Uint8 physicsType;
+    Uint8 iterations;
+    Uint8 slipperyness;
+    Uint8 flags;
+    float density;
+};
+
+// structure-of-arrays copy of a MaterialInstance grid
+// MaterialInstance is ~32 bytes, so anything that only needs one field of its neighbors (physics type, temperature)
+//   pulls a lot of unused memory through the cache; these planes let those loops read 2-4 bytes per cell instead
+class CellGrid {
+public:
+    int width = 0;
+    int height = 0;
+
+    Uint16* material = nullptr; // Material::id (index into Materials::MATERIALS_ARRAY)
+    Uint32* color = nullptr;
+    int32_t* temperature = nullptr;
+    float* conduction = nullptr; // conductionOther of each cell's material, only filled by gatherTemperature (not saved)
+
+    // per-material lookup tables indexed by the material plane
+    static Uint8* physicsType;
+    static int* iterations;
+    static float* conductionSelf;
+    static float* conductionOther;
+    static int32_t* addTemp;
+    static CellProps* props;
+
+    // Material::interactions and Material::reactions compiled into flat CSR style tables
+    // interactBits has a row of interactWords words per material, bit `other` is set if it has any interaction with `other`
+    // material m's rows are interactPairs[interactRow[m]] to interactPairs[interactRow[m + 1] - 1] (sorted by other id),
+    //   and pair k's rules are interactRules[interactPairs[k].start] to interactRules[interactPairs[k + 1].start - 1]
+    // reactions of m are reactRules[reactStart[m]] to reactRules[reactStart[m + 1] - 1]
+    struct InteractPair {
+        int other;
+        int start;
+    };
+    static int interactWords;
+    static uint32_t* interactBits;
+    static int* interactRow;
+    static InteractPair* interactPairs;
+    static MaterialInteraction* interactRules;
+    static int* reactStart;
+    static MaterialInteraction* reactRules;
+
+    static void initMaterialTables();
+
+    inline static bool hasInteraction(int mat, int other) {
+        return (interactBits[mat * interactWords + (other >> 5)] >> (other & 31)) & 1;
+    }
+    // the rules for mat touching other (sets n to 0 if there aren't any)
+    static const MaterialInteraction* interactionRules(int mat, int other, int* n);
+    inline static const MaterialInteraction* reactionRules(int mat, int* n) {
+        *n = reactStart[mat + 1] - reactStart[mat];
+        return &reactRules[reactStart[mat]];
+    }
+
+    void init(int w, int h);
+    // use planes owned by someone else (ex. a chunk file buffer)
+    void wrap(int w, int h, Uint16* material, Uint32* color, int32_t* temperature);
+    // bytes needed for all three planes of a w*h grid laid out back to back
+    static size_t planesSize(int w, int h);
+
+    // copy the given rect of a MaterialInstance grid (with row stride `stride`) into the planes
+    void gather(const MaterialInstance* tiles, int stride, int x, int y, int w, int h);
+    void gatherMaterial(const MaterialInstance* tiles, int stride, int x, int y, int w, int h);
+    // same, and appends the index of every cell that was SOLID in the plane but isn't anymore to solidRemoved
+    void gatherMaterial(const MaterialInstance* tiles, int stride, int x, int y, int w, int h, std::vector<int>& solidRemoved);
+    void gatherTemperature(const MaterialInstance* tiles, int stride, int x, int y, int w, int h); // material + temperature + conduction
+
+    // copy the planes back into a MaterialInstance grid
+    // creates new MaterialInstances (new ids), so only use this for grids that aren't being simulated
+    void scatter(MaterialInstance* tiles, int stride, int x, int y, int w, int h);
+    void scatterTemperature(MaterialInstance* tiles, int stride, int x, int y, int w, int h);
+
+    inline int physicsAt(int index) const {
+        return physicsType[material[index]];
+    }
+
+    ~CellGrid();
+
+private:
+    static void compileInteractions();
+
+    bool ownsPlanes = true;
+};
+
@@ -1,5 +1,7 @@
 
 #include "Chunk.hpp"
+#include "CellGrid.hpp"
+#include "Region.hpp"
 #include <string>
 #include <vector>
 #include <sstream>
@@ -20,7 +22,7 @@ Chunk::Chunk(int x, int y, char* worldName) {
     this->x = x;
     this->y = y;
 
-    this->fname = std::string(worldName) + "/chunks/chunk_" + std::to_string(x) + "_" + std::to_string(y);
+    this->worldName = std::string(worldName);
 }
 
 Chunk::~Chunk() {
@@ -31,19 +33,18 @@ Chunk::~Chunk() {
 }
 
 void Chunk::loadMeta() {
-    string line;
-    ifstream myfile(fname);
-    if(myfile.is_open()) {
-        getline(myfile, line, '\n');
-
-        int phase = stoi(line);
-        generationPhase = phase;
+    Regions::read(worldName, x, y, [&](const char* data, uint32_t size) {
+        if(size < 1) return;
+        generationPhase = (int8_t)data[0];
         hasMeta = true;
-    }
+    });
 }
 
 //MaterialInstanceData* Chunk::readBuf = (MaterialInstanceData*)malloc(CHUNK_W * CHUNK_H * 2 * sizeof(MaterialInstanceData));
 
+// [generationPhase][src_size][compressed_size][src_size2][compressed_size2][compressed tiles/layer2][compressed background]
+#define CHUNK_HEADER_SIZE (sizeof(int8_t) + sizeof(int) * 4)
+
 void Chunk::read() {
     EASY_FUNCTION();
 
@@ -59,140 +60,115 @@ void Chunk::read() {
     Uint32* background = new Uint32[CHUNK_W * CHUNK_H];
     EASY_END_BLOCK;
 
-    EASY_BLOCK("open file");
-    string line;
-    ifstream myfile(fname, std::ios::binary);
-    EASY_END_BLOCK;
-    if(myfile.is_open()) {
-        int state = 0;
+    // decompresses straight out of the region file mapping
+    Regions::read(worldName, x, y, [&](const char* data, uint32_t size) {
+        readData(data, size, tiles, layer2, background);
+    });
 
-        myfile.read((char*)&this->generationPhase, sizeof(int8_t));
-
-        hasMeta = true;
-        state = 1;
-
-        /*unsigned int content;
-        for (int i = 0; i < CHUNK_W * CHUNK_H; i++) {
-            myfile.read((char*)&content, sizeof(unsigned int));
-            int id = content;
-            myfile.read((char*)&content, sizeof(unsigned int));
-            Uint32 color = content;
-            tiles[i] = MaterialInstance(Materials::MATERIALS[id], color);
-        }
-        for (int i = 0; i < CHUNK_W * CHUNK_H; i++) {
-            myfile.read((char*)&content, sizeof(unsigned int));
-            int id = content;
-            myfile.read((char*)&content, sizeof(unsigned int));
-            Uint32 color = content;
-            layer2[i] = MaterialInstance(Materials::MATERIALS[id], color);
-        }*/
-        /*for (int i = 0; i < CHUNK_W * CHUNK_H; i++) {
-            myfile.read((char*)&content, sizeof(unsigned int));
-            background[i] = content;
-        }*/
-
-        int src_size;
-        myfile.read((char*)&src_size, sizeof(int));
-
-        if(src_size != CHUNK_W * CHUNK_H * 2 * sizeof(MaterialInstanceData)) throw std::runtime_error("Chunk src_size was different from expected: " + std::to_string(src_size) + " vs " + std::to_string(CHUNK_W * CHUNK_H * 2 * sizeof(MaterialInstanceData)));
-
-        int compressed_size;
-        myfile.read((char*)&compressed_size, sizeof(int));
-
-        int src_size2;
-        myfile.read((char*)&src_size2, sizeof(int));
-        int desSize = CHUNK_W * CHUNK_H * sizeof(unsigned int);
-
-        if(src_size2 != desSize) throw std::runtime_error("Chunk src_size2 was different from expected: " + std::to_string(src_size2) + " vs " + std::to_string(desSize));
+    this->tiles = tiles;
+    this->layer2 = layer2;
+    this->background = background;
+    hasTileCache = true;
 
-        int compressed_size2;
-        myfile.read((char*)&compressed_size2, sizeof(int));
+}
 
-        MaterialInstanceData* readBuf = (MaterialInstanceData*)malloc(src_size);
+void Chunk::readData(const char* data, uint32_t size, MaterialInstance* tiles, MaterialInstance* layer2, Uint32* background) {
+    if(size < CHUNK_HEADER_SIZE) throw std::runtime_error("Chunk data was too small: " + std::to_string(size));
 
-        if(readBuf == NULL) throw std::runtime_error("Failed to allocate memory for Chunk readBuf.");
+    int src_size;
+    int compressed_size;
+    int src_size2;
+    int compressed_size2;
+    const char* p = data;
+    memcpy(&this->generationPhase, p, sizeof(int8_t)); p += sizeof(int8_t);
+    memcpy(&src_size, p, sizeof(int)); p += sizeof(int);
+    memcpy(&compressed_size, p, sizeof(int)); p += sizeof(int);
+    memcpy(&src_size2, p, sizeof(int)); p += sizeof(int);
+    memcpy(&compressed_size2, p, sizeof(int)); p += sizeof(int);
 
-        char* compressed_data = (char*)malloc(compressed_size);
+    hasMeta = true;
 
-        EASY_BLOCK("read MaterialInstanceData");
-        myfile.read((char*)compressed_data, compressed_size);
-        EASY_END_BLOCK;
+    // chunks are stored as material/color/temperature planes now, but older saves have interleaved MaterialInstanceData
+    const int planes_size = (int)(CellGrid::planesSize(CHUNK_W, CHUNK_H) * 2);
+    const int legacy_size = (int)(CHUNK_W * CHUNK_H * 2 * sizeof(MaterialInstanceData));
+    if(src_size != planes_size && src_size != legacy_size) throw std::runtime_error("Chunk src_size was different from expected: " + std::to_string(src_size) + " vs " + std::to_string(planes_size));
 
-        const int decompressed_size = LZ4_decompress_safe(compressed_data, (char*)readBuf, compressed_size, src_size);
+    int desSize = CHUNK_W * CHUNK_H * sizeof(unsigned int);
+    if(src_size2 != desSize) throw std::runtime_error("Chunk src_size2 was different from expected: " + std::to_string(src_size2) + " vs " + std::to_string(desSize));
 
-        free(compressed_data);
+    if(compressed_size < 0 || compressed_size2 < 0 || CHUNK_HEADER_SIZE + (size_t)compressed_size + compressed_size2 > size) {
+        throw std::runtime_error("Chunk compressed sizes don't match the data size: " + std::to_string(compressed_size) + " + " + std::to_string(compressed_size2) + " vs " + std::to_string(size));
+    }
 
-        // basically, if either of these checks trigger, the chunk is unreadable, either due to miswriting it or corruption
-        // TODO: have the chunk regenerate on corruption (maybe save copies of corrupt chunks as well?)
-        if(decompressed_size < 0) {
-            logCritical("Error decompressing chunk tile data @ {},{} (err {}).", this->x, this->y, decompressed_size);
-        } else if(decompressed_size != src_size) {
-            logCritical("Decompressed chunk tile data is corrupt! @ {},{} (was {}, expected {}).", this->x, this->y, decompressed_size, src_size);
-        }
+    // reused between chunks (read() runs on the loadChunk threads)
+    static thread_local std::vector<char> readBuf;
+    readBuf.resize(src_size);
 
-        EASY_BLOCK("copy MaterialInstanceData");
-        // copy everything but the material pointer
-        //memcpy(tiles, readBuf, CHUNK_W * CHUNK_H * sizeof(MaterialInstance));
-        //memcpy(layer2, &readBuf[CHUNK_W * CHUNK_H], CHUNK_W * CHUNK_H * sizeof(MaterialInstance));
+    EASY_BLOCK("decompress MaterialInstanceData");
+    const int decompressed_size = LZ4_decompress_safe(p, readBuf.data(), compressed_size, src_size);
+    EASY_END_BLOCK;
+    p += compressed_size;
+
+    // basically, if either of these checks trigger, the chunk is unreadable, either due to miswriting it or corruption
+    // TODO: have the chunk regenerate on corruption (maybe save copies of corrupt chunks as well?)
+    if(decompressed_size < 0) {
+        logCritical("Error decompressing chunk tile data @ {},{} (err {}).", this->x, this->y, decompressed_size);
+    } else if(decompressed_size != src_size) {
+        logCritical("Decompressed chunk tile data is corrupt! @ {},{} (was {}, expected {}).", this->x, this->y, decompressed_size, src_size);
+    }
 
-        // copy the material pointer
+    EASY_BLOCK("copy MaterialInstanceData");
+    if(src_size == planes_size) {
+        CellGrid planes;
+        wrapPlanes(&planes, readBuf.data(), 0);
+        planes.scatter(tiles, CHUNK_W, 0, 0, CHUNK_W, CHUNK_H);
+        wrapPlanes(&planes, readBuf.data(), 1);
+        planes.scatter(layer2, CHUNK_W, 0, 0, CHUNK_W, CHUNK_H);
+    } else {
+        MaterialInstanceData* legacyBuf = (MaterialInstanceData*)readBuf.data();
         for(int i = 0; i < CHUNK_W * CHUNK_H; i++) {
             // twice as fast to set fields instead of making new ones
-            tiles[i].color = readBuf[i].color;
-            tiles[i].temperature = readBuf[i].temperature;
-            tiles[i].mat = Materials::MATERIALS_ARRAY[readBuf[i].index];
+            tiles[i].color = legacyBuf[i].color;
+            tiles[i].temperature = legacyBuf[i].temperature;
+            tiles[i].mat = Materials::MATERIALS_ARRAY[legacyBuf[i].index];
             tiles[i].id = MaterialInstance::_curID++;
-            //tiles[i].color = readBuf[i].color;
-            //tiles[i].temperature = readBuf[i].temperature;
-            //tiles[i] = MaterialInstance(Materials::MATERIALS_ARRAY[buf[i].index], buf[i].color, buf[i].temperature);
 
-            layer2[i].color = readBuf[i + CHUNK_W * CHUNK_H].color;
-            layer2[i].temperature = readBuf[i + CHUNK_W * CHUNK_H].temperature;
-            layer2[i].mat = Materials::MATERIALS_ARRAY[readBuf[CHUNK_W * CHUNK_H + i].index];
+            layer2[i].color = legacyBuf[i + CHUNK_W * CHUNK_H].color;
+            layer2[i].temperature = legacyBuf[i + CHUNK_W * CHUNK_H].temperature;
+            layer2[i].mat = Materials::MATERIALS_ARRAY[legacyBuf[CHUNK_W * CHUNK_H + i].index];
             layer2[i].id = MaterialInstance::_curID++;
-            //layer2[i].color = readBuf[CHUNK_W * CHUNK_H + i].color;
-            //layer2[i].temperature = readBuf[CHUNK_W * CHUNK_H + i].temperature;
-            //layer2[i] = MaterialInstance(Materials::MATERIALS_ARRAY[buf[CHUNK_W * CHUNK_H + i].index], buf[CHUNK_W * CHUNK_H + i].color, buf[CHUNK_W * CHUNK_H + i].temperature);
-        }
-        EASY_END_BLOCK;
-
-        //delete readBuf;
-
-        char* compressed_data2 = (char*)malloc(compressed_size2);
-
-        EASY_BLOCK("read background data");
-        myfile.read((char*)compressed_data2, compressed_size2);
-        EASY_END_BLOCK;
-
-        const int decompressed_size2 = LZ4_decompress_safe(compressed_data2, (char*)background, compressed_size2, src_size2);
-
-        free(compressed_data2);
-
-        if(decompressed_size2 < 0) {
-            logCritical("Error decompressing chunk background data @ {},{} (err {}).", this->x, this->y, decompressed_size2);
-        }else if(decompressed_size2 != src_size2) {
-            logCritical("Decompressed chunk background data is corrupt! @ {},{} (was {}, expected {}).", this->x, this->y, decompressed_size2, src_size2);
         }
+    }
+    EASY_END_BLOCK;
 
-        free(readBuf);
+    EASY_BLOCK("decompress background data");
+    const int decompressed_size2 = LZ4_decompress_safe(p, (char*)background, compressed_size2, src_size2);
+    EASY_END_BLOCK;
 
-        myfile.close();
+    if(decompressed_size2 < 0) {
+        logCritical("Error decompressing chunk background data @ {},{} (err {}).", this->x, this->y, decompressed_size2);
+    }else if(decompressed_size2 != src_size2) {
+        logCritical("Decompressed chunk background data is corrupt! @ {},{} (was {}, expected {}).", this->x, this->y, decompressed_size2, src_size2);
     }
+}
+
+void Chunk::write(MaterialInstance* tiles, MaterialInstance* layer2, Uint32* background) {
+    EASY_FUNCTION();
 
     this->tiles = tiles;
     this->layer2 = layer2;
     this->background = background;
-    hasTileCache = true;
 
+    // reused between chunks instead of allocating every write
+    static thread_local ChunkSnapshot snap;
+    if(!snapshot(&snap)) return;
+    writeSnapshot(&snap);
 }
 
-void Chunk::write(MaterialInstance* tiles, MaterialInstance* layer2, Uint32* background) {
+bool Chunk::snapshot(ChunkSnapshot* snap) {
     EASY_FUNCTION();
 
-    this->tiles = tiles;
-    this->layer2 = layer2;
-    this->background = background;
-    if(this->tiles == NULL || this->layer2 == NULL || this->background == NULL) return;
+    if(this->tiles == NULL || this->layer2 == NULL || this->background == NULL) return false;
     hasTileCache = true;
 
     // TODO: make these loops faster
@@ -208,82 +184,91 @@ void Chunk::write(MaterialInstance* tiles, MaterialInstance* layer2, Uint32* bac
         myfile.write((char*)&background[i], sizeof(unsigned int));
     }*/
 
+    snap->worldName = worldName;
+    snap->x = x;
+    snap->y = y;
+    snap->generationPhase = generationPhase;
+
+    // planes compress a lot better than interleaved structs (long runs of the same material/temperature)
+    snap->planes.resize(CellGrid::planesSize(CHUNK_W, CHUNK_H) * 2);
+    CellGrid planes;
+    wrapPlanes(&planes, snap->planes.data(), 0);
+    planes.gather(tiles, CHUNK_W, 0, 0, CHUNK_W, CHUNK_H);
+    wrapPlanes(&planes, snap->planes.data(), 1);
+    planes.gather(layer2, CHUNK_W, 0, 0, CHUNK_W, CHUNK_H);
+
+    snap->background.assign(background, background + CHUNK_W * CHUNK_H);
+    return true;
+}
 
-    MaterialInstanceData* buf = new MaterialInstanceData[CHUNK_W * CHUNK_H * 2];
-    for(int i = 0; i < CHUNK_W * CHUNK_H; i++) {
-        buf[i] = {(Uint16)tiles[i].mat->id, tiles[i].color, tiles[i].temperature};
-        buf[CHUNK_W * CHUNK_H + i] = {(Uint16)layer2[i].mat->id, layer2[i].color, layer2[i].temperature};
-    }
+void Chunk::writeSnapshot(ChunkSnapshot* snap) {
+    EASY_FUNCTION();
 
-    const char* const src = (char*)buf;
-    const int src_size = (int)(CHUNK_W * CHUNK_H * 2 * sizeof(MaterialInstanceData));
+    const int src_size = (int)snap->planes.size();
+    const int src_size2 = (int)(snap->background.size() * sizeof(Uint32));
     const int max_dst_size = LZ4_compressBound(src_size);
+    const int max_dst_size2 = LZ4_compressBound(src_size2);
+
+    // reused between chunks instead of malloc/free every write
+    static thread_local std::vector<char> outBuf;
+    outBuf.resize(CHUNK_HEADER_SIZE + max_dst_size + max_dst_size2);
 
-    char* compressed_data = (char*)malloc((size_t)max_dst_size);
+    // compress directly into the output after the header
+    char* compressed_data = outBuf.data() + CHUNK_HEADER_SIZE;
 
     EASY_BLOCK("compress");
-    const int compressed_data_size = LZ4_compress_fast(src, compressed_data, src_size, max_dst_size, 10);
+    const int compressed_data_size = LZ4_compress_fast(snap->planes.data(), compressed_data, src_size, max_dst_size, 10);
     EASY_END_BLOCK;
 
     if(compressed_data_size <= 0) {
-        logCritical("Failed to compress chunk tile data @ {},{} (err {})", this->x, this->y, compressed_data_size);
+        logCritical("Failed to compress chunk tile data @ {},{} (err {})", snap->x, snap->y, compressed_data_size);
+        return;
     }
 
     /*if(compressed_data_size > 0){
         logDebug("Compression ratio: {}", (float)compressed_data_size / src_size * 100);
     }*/
 
-    char* n_compressed_data = (char*)realloc(compressed_data, (size_t)compressed_data_size);
-    if(n_compressed_data == NULL) throw std::runtime_error("Failed to realloc memory for Chunk::write compressed_data.");
-    compressed_data = n_compressed_data;
-
     // bg compress
 
-    const char* const src2 = (char*)background;
-    const int src_size2 = (int)(CHUNK_W * CHUNK_H * sizeof(unsigned int));
-    const int max_dst_size2 = LZ4_compressBound(src_size2);
-
-    char* compressed_data2 = (char*)malloc((size_t)max_dst_size2);
+    char* compressed_data2 = compressed_data + compressed_data_size;
 
     EASY_BLOCK("compress");
-    const int compressed_data_size2 = LZ4_compress_fast(src2, compressed_data2, src_size2, max_dst_size2, 10);
+    const int compressed_data_size2 = LZ4_compress_fast((char*)snap->background.data(), compressed_data2, src_size2, max_dst_size2, 10);
     EASY_END_BLOCK;
 
     if(compressed_data_size2 <= 0) {
-        logCritical("Failed to compress chunk tile data @ {},{} (err {})", this->x, this->y, compressed_data_size2);
+        logCritical("Failed to compress chunk tile data @ {},{} (err {})", snap->x, snap->y, compressed_data_size2);
+        return;
     }
 
     /*if(compressed_data_size2 > 0){
         logDebug("Compression ratio: {}", (float)compressed_data_size2 / src_size2 * 100);
     }*/
 
-    char* n_compressed_data2 = (char*)realloc(compressed_data2, (size_t)compressed_data_size2);
-    if(n_compressed_data2 == NULL) throw std::runtime_error("Failed to realloc memory for Chunk::write compressed_data2.");
-    compressed_data2 = n_compressed_data2;
-
-    ofstream myfile;
-    myfile.open(fname, std::ios::binary);
-    myfile.write((char*)&generationPhase, sizeof(int8_t));
+    char* p = outBuf.data();
+    memcpy(p, &snap->generationPhase, sizeof(int8_t)); p += sizeof(int8_t);
+    memcpy(p, &src_size, sizeof(int)); p += sizeof(int);
+    memcpy(p, &compressed_data_size, sizeof(int)); p += sizeof(int);
+    memcpy(p, &src_size2, sizeof(int)); p += sizeof(int);
+    memcpy(p, &compressed_data_size2, sizeof(int)); p += sizeof(int);
 
-    myfile.write((char*)&src_size, sizeof(int));
-    myfile.write((char*)&compressed_data_size, sizeof(int));
-    myfile.write((char*)&src_size2, sizeof(int));
-    myfile.write((char*)&compressed_data_size2, sizeof(int));
-
-    myfile.write((char*)compressed_data, compressed_data_size);
-    delete[] buf;
-    myfile.write((char*)compressed_data2, compressed_data_size2);
-
-    free(compressed_data);
-    free(compressed_data2);
+    Regions::write(snap->worldName, snap->x, snap->y, outBuf.data(), (uint32_t)(CHUNK_HEADER_SIZE + compressed_data_size + compressed_data_size2));
+}
 
-    myfile.close();
+void Chunk::wrapPlanes(CellGrid* planes, char* buf, int layer) {
+    // [tiles material][tiles color][tiles temperature][layer2 material][layer2 color][layer2 temperature]
+    char* base = buf + CellGrid::planesSize(CHUNK_W, CHUNK_H) * layer;
+    Uint16* material = (Uint16*)base;
+    Uint32* color = (Uint32*)(base + CHUNK_W * CHUNK_H * sizeof(Uint16));
+    int32_t* temperature = (int32_t*)(base + CHUNK_W * CHUNK_H * (sizeof(Uint16) + sizeof(Uint32)));
+    planes->wrap(CHUNK_W, CHUNK_H, material, color, temperature);
 }
 
 bool Chunk::hasFile() {
     EASY_FUNCTION();
-    struct stat buffer;
-    return (stat(fname.c_str(), &buffer) == 0);
+    // answered from the in-memory region index
+    return Regions::has(worldName, x, y);
 }
 
 std::vector<std::string> split(std::string strToSplit, char delimeter) {
@@ -30,8 +30,23 @@ typedef struct {
     int32_t temperature;
 } MaterialInstanceData;
 
+class CellGrid;
+
+// copy of a chunk's data (as planes) taken at some point, so it can be compressed/written on another thread
+class ChunkSnapshot {
+public:
+    std::string worldName;
+    int x = 0;
+    int y = 0;
+    int8_t generationPhase = 0;
+    std::vector<char> planes;
+    std::vector<Uint32> background;
+};
+
 class Chunk {
-    std::string fname;
+    std::string worldName;
+    static void wrapPlanes(CellGrid* planes, char* buf, int layer);
+    void readData(const char* data, uint32_t size, MaterialInstance* tiles, MaterialInstance* layer2, Uint32* background);
 public:
     int x;
     int y;
@@ -49,6 +64,9 @@ public:
     //static MaterialInstanceData* readBuf;
     void read();
     void write(MaterialInstance* tiles, MaterialInstance* layer2, Uint32* background);
+    // write() split in two: snapshot() copies the data out, writeSnapshot() compresses it and writes it to the region
+    bool snapshot(ChunkSnapshot* snap);
+    static void writeSnapshot(ChunkSnapshot* snap);
     bool hasFile();
 
     bool hasTileCache = false;
@@ -57,6 +75,13 @@ public:
     Uint32* background = nullptr;
     Biome** biomes = nullptr;
 
+    // static collision mesh, built by World::updateChunkMesh from the solid cells (meshHash is World::chunkSolidHash of those cells)
+    // rb only exists while the chunk is in World::meshZone
     std::vector<b2PolygonShape> polys = {};
     RigidBody* rb = nullptr;
+    uint64_t meshHash = 0;
+    // built by World::buildChunkBoxes instead of buildChunkPolys
+    bool meshBoxes = false;
+    bool meshValid = false;
+    int meshStamp = 0;
 };
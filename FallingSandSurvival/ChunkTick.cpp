@@ -0,0 +1,880 @@
+
+#include "ChunkTick.hpp"
+
+#include <algorithm>
+
+#define BUILD_WITH_EASY_PROFILER
+#include <easy/profiler.h>
+#include "ProfilerConfig.hpp"
+
+// what a cell of physics type Type does in pass Pass (0-2, same as "iter 1"-"iter 3" in World::tick)
+// anything without a specialization (air, solid, passables other than fire, soup in the last pass) does nothing
+template<int Pass, int Type>
+class CellKernel {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {}
+};
+
+// fire
+template<>
+class CellKernel<0, PhysicsType::PASSABLE> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        if(t.material[index] != Materials::FIRE.id) return;
+
+        RNG& rng = t.rng;
+        int width = t.width;
+        MaterialInstance tile = t.tiles[index];
+
+        // fire never settles
+        t.wake(x, y);
+
+        if(rng.next() % 10 == 0) {
+            Uint32 rgb = 255;
+            rgb = (rgb << 8) + 100 + rng.next() % 50;
+            rgb = (rgb << 8) + 50;
+            tile.color = rgb;
+        }
+
+        if(rng.next() % 10 == 0) {
+            Particle part(tile, x, y - 1, (rng.next() % 10 - 5) / 20.0f, -((rng.next() % 10) / 10.0f) / 3.0f + -0.5f, 0, 0.01f);
+            part.temporary = true;
+            part.lifetime = 30;
+            part.fadeTime = 10;
+            t.spawn(part);
+        }
+
+        if(rng.next() % 150 == 0) {
+            t.put(index, Tiles::NOTHING);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+            t.visited[index] = t.epoch;
+        } else {
+            bool foundAny = false;
+            for(int xx = -2; xx <= 2; xx++) {
+                for(int yy = -2; yy <= 2; yy++) {
+                    if(t.physicsAt((x + xx) + (y + yy) * width) == PhysicsType::SOLID) {
+                        foundAny = true;
+                        if(rng.next() % 500 == 0) {
+                            t.put((x + xx) + (y + yy) * width, Tiles::createFire());
+                            t.world->markDirty(x + xx, y + yy);
+                            t.wake(x + xx, y + yy);
+                            t.visited[(x + xx) + (y + yy) * width] = t.epoch;
+                        }
+                    }
+                }
+            }
+            if(!foundAny && rng.next() % 120 == 0) {
+                t.put(index, Tiles::NOTHING);
+                t.world->markDirty(x, y);
+                t.wake(x, y);
+                t.visited[index] = t.epoch;
+            }
+        }
+    }
+};
+
+template<>
+class CellKernel<0, PhysicsType::SAND> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        RNG& rng = t.rng;
+        int width = t.width;
+        MaterialInstance* tiles = t.tiles;
+        int belowIndex = x + (y + 1) * width;
+        Uint16 belowId = t.material[belowIndex];
+
+        if((p.flags & CELL_INTERACT) && CellGrid::hasInteraction(t.material[index], belowId)) {
+            int nRules;
+            const MaterialInteraction* rules = CellGrid::interactionRules(t.material[index], belowId, &nRules);
+            for(int i = 0; i < nRules; i++) {
+                const MaterialInteraction& in = rules[i];
+                if(in.type == INTERACT_TRANSFORM_MATERIAL) {
+                    for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                        for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                            if(t.material[(x + xx) + (y + yy) * width] == belowId) {
+                                t.put((x + xx) + (y + yy) * width, Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy));
+                                t.world->markDirty(x + xx, y + yy);
+                                t.wake(x + xx, y + yy);
+                                t.visited[(x + xx) + (y + yy) * width] = t.epoch;
+                            }
+                        }
+                    }
+                } else if(in.type == INTERACT_SPAWN_MATERIAL) {
+                    for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                        for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                            if((xx == 0 && yy == 0) || t.material[(x + xx) + (y + yy) * width] == Tiles::NOTHING.mat->id) {
+                                t.put((x + xx) + (y + yy) * width, Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy));
+                                t.world->markDirty(x + xx, y + yy);
+                                t.wake(x + xx, y + yy);
+                                t.visited[(x + xx) + (y + yy) * width] = t.epoch;
+                            }
+                        }
+                    }
+                }
+            }
+            return;
+        }
+
+        if(p.flags & CELL_REACT) {
+            int nRules;
+            const MaterialInteraction* rules = CellGrid::reactionRules(t.material[index], &nRules);
+            int32_t temperature = tiles[index].temperature;
+            bool react = false;
+            for(int i = 0; i < nRules; i++) {
+                const MaterialInteraction& in = rules[i];
+                if((in.type == REACT_TEMPERATURE_BELOW && temperature < in.data1) || (in.type == REACT_TEMPERATURE_ABOVE && temperature > in.data1)) {
+                    t.put(index, Tiles::create(Materials::MATERIALS[in.data2], x, y));
+                    tiles[index].temperature = temperature;
+                    t.world->markDirty(x, y);
+                    t.wake(x, y);
+                    t.visited[index] = t.epoch;
+                    react = true;
+                }
+            }
+            if(react) return;
+        }
+
+        int below = CellGrid::props[belowId].physicsType;
+        bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && CellGrid::props[belowId].density < p.density));
+        if(!canMoveBelow) return;
+
+        const CellProps& belowL = t.propsAt((x - 1) + (y + 1) * width);
+        const CellProps& belowR = t.propsAt((x + 1) + (y + 1) * width);
+        bool canMoveBelowL = (belowL.physicsType == PhysicsType::AIR || (belowL.physicsType != PhysicsType::SOLID && belowL.density < p.density));
+        bool canMoveBelowR = (belowR.physicsType == PhysicsType::AIR || (belowR.physicsType != PhysicsType::SOLID && belowR.density < p.density));
+
+        if((canMoveBelowL || canMoveBelowR) && rng.next() % 20 == 0) return;
+
+        MaterialInstance tile = tiles[index];
+        MaterialInstance belowTile = tiles[belowIndex];
+        if(below == PhysicsType::AIR && t.physicsAt(x + (y + 2) * width) == PhysicsType::AIR && t.physicsAt(x + (y + 3) * width) == PhysicsType::AIR && t.physicsAt(x + (y + 4) * width) == PhysicsType::AIR) {
+            t.put(index, belowTile);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+            t.spawn(Particle(tile, x, y + 1, (rng.next() % 10 - 5) / 20.0f, -((rng.next() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+        } else {
+            t.put(index, belowTile);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+            if(rng.next() % 2 == 0) {
+                tile.moved = true;
+            }
+            t.put(belowIndex, tile);
+            t.world->markDirty(x, y + 1);
+            t.wake(x, y + 1);
+            t.visited[belowIndex] = t.epoch;
+        }
+
+        int selfTrasmitMovementChance = 2;
+
+        if(rng.next() % selfTrasmitMovementChance == 0) {
+            if(x > 0 && t.physicsAt((x - 1) + (y + 1) * width) == PhysicsType::SAND) {
+                int otherTransmitMovementChance = 2;
+                if(rng.next() % otherTransmitMovementChance == 0) {
+                    tiles[(x - 1) + (y + 1) * width].moved = true;
+                }
+            }
+
+            if(x < width - 1 && t.physicsAt((x + 1) + (y + 1) * width) == PhysicsType::SAND) {
+                int otherTransmitMovementChance = 2;
+                if(rng.next() % otherTransmitMovementChance == 0) {
+                    tiles[(x + 1) + (y + 1) * width].moved = true;
+                }
+            }
+        }
+    }
+};
+
+// based on https://github.com/jongallant/LiquidSimulator (MIT License)
+// NOTE: for liquids, tile.moved is tile.settled in the original algorithm
+template<>
+class CellKernel<0, PhysicsType::SOUP> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        RNG& rng = t.rng;
+        int width = t.width;
+        MaterialInstance* tiles = t.tiles;
+        float* flowX = t.world->flowX;
+        float* flowY = t.world->flowY;
+        Uint16 id = t.material[index];
+
+        MaterialInstance tile = tiles[index];
+
+        if(tile.fluidAmount == 0.0f) return;
+
+        if(tile.fluidAmount < FLUID_MinValue) {
+            tile.fluidAmount = 0.0f;
+            t.put(index, tile);
+            return;
+        }
+
+        if(tile.fluidAmount > 0.005 && t.physicsAt(x + (y + 1) * width) == PhysicsType::AIR && t.physicsAt(x + (y + 2) * width) == PhysicsType::AIR && t.physicsAt(x + (y + 3) * width) == PhysicsType::AIR && t.physicsAt(x + (y + 4) * width) == PhysicsType::AIR) {
+            t.put(index, Tiles::NOTHING);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+
+            int n = tile.fluidAmount / 4;
+            if(n < 1) n = 1;
+
+            for(int i = 0; i < n; i++) {
+                float amt = tile.fluidAmount / n;
+
+                MaterialInstance nt = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                nt.fluidAmount = amt;
+                nt.fluidAmountDiff = 0;
+                nt.moved = false;
+                t.spawn(Particle(nt, x, y + 1, (rng.next() % 10 - 5) / 30.0f, -((rng.next() % 2) + 3) / 10.0f + 1.0f, 0, 0.1f));
+            }
+
+            return;
+        }
+
+        if(tile.moved) return;
+
+        // unsettled liquid keeps its chunk awake until it settles
+        t.wake(x, y);
+
+        float startValue = tile.fluidAmount;
+        float remainingValue = tile.fluidAmount;
+
+        // the neighbor types are read once (like the copies in the old loop), flowing into air changes them
+        int bottomIndex = x + (y + 1) * width;
+        int bottomType = t.physicsAt(bottomIndex);
+        Uint16 bottomId = t.material[bottomIndex];
+
+        bool airBelow = bottomType == PhysicsType::AIR;
+        if((airBelow && t.iter <= 2) || (bottomId == id)) {
+            float dstFl = bottomType == PhysicsType::SOUP ? tiles[bottomIndex].fluidAmount : 0.0f;
+
+            float flow = CalculateVerticalFlowValue(startValue, dstFl) - dstFl;
+            if(tiles[bottomIndex].fluidAmount > 0 && flow > FLUID_MinFlow)
+                flow *= FLUID_FlowSpeed;
+
+            flow = std::max(flow, 0.0f);
+            if(flow > std::min(FLUID_MaxFlow, startValue))
+                flow = std::min(FLUID_MaxFlow, startValue);
+
+            if(flow != 0) {
+                remainingValue -= flow;
+                tile.fluidAmountDiff -= flow;
+                if(bottomType == PhysicsType::AIR) {
+                    t.put(bottomIndex, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                    tiles[bottomIndex].fluidAmount = 0.0f;
+                }
+                tiles[bottomIndex].fluidAmountDiff += flow;
+            }
+            flowY[index] += flow;
+        } else if(t.iter == 0 && bottomType == PhysicsType::SOUP && (bottomId != id)) {
+            if(rng.next() % 10 == 0) {
+                MaterialInstance bottom = tiles[bottomIndex];
+                t.put(index, bottom);
+                t.put(bottomIndex, tile);
+                t.wake(x, y + 1);
+                return;
+            }
+        }
+
+        if(remainingValue < FLUID_MinValue) {
+            tile.fluidAmountDiff -= remainingValue;
+            t.put(index, tile);
+            return;
+        }
+
+        int leftIndex = (x - 1) + y * width;
+        int leftType = t.physicsAt(leftIndex);
+        bool canMoveLeft = (leftType == PhysicsType::AIR || (t.material[leftIndex] == id)) && !airBelow;
+
+        int rightIndex = (x + 1) + y * width;
+        int rightType = t.physicsAt(rightIndex);
+        bool canMoveRight = (rightType == PhysicsType::AIR || (t.material[rightIndex] == id)) && !airBelow;
+
+        if(canMoveLeft) {
+            float dstFl = leftType == PhysicsType::SOUP ? tiles[leftIndex].fluidAmount : 0.0f;
+
+            float flow = (remainingValue - dstFl) / (canMoveRight ? 3.0f : 2.0f);
+            if(flow > FLUID_MinFlow)
+                flow *= FLUID_FlowSpeed;
+
+            flow = std::max(flow, 0.0f);
+            if(flow > std::min(FLUID_MaxFlow, remainingValue))
+                flow = std::min(FLUID_MaxFlow, remainingValue);
+
+            if(flow != 0) {
+                remainingValue -= flow;
+                tile.fluidAmountDiff -= flow;
+                if(leftType == PhysicsType::AIR) {
+                    t.put(leftIndex, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                    tiles[leftIndex].fluidAmount = 0.0f;
+                }
+                tiles[leftIndex].fluidAmountDiff += flow;
+            }
+            flowX[index] -= flow;
+        }
+
+        if(remainingValue < FLUID_MinValue) {
+            tile.fluidAmountDiff -= remainingValue;
+            t.put(index, tile);
+            return;
+        }
+
+        if(canMoveRight) {
+            float dstFl = rightType == PhysicsType::SOUP ? tiles[rightIndex].fluidAmount : 0.0f;
+
+            float flow = (remainingValue - dstFl) / 2.0f;
+            if(flow > FLUID_MinFlow)
+                flow *= FLUID_FlowSpeed;
+
+            flow = std::max(flow, 0.0f);
+            if(flow > std::min(FLUID_MaxFlow, remainingValue))
+                flow = std::min(FLUID_MaxFlow, remainingValue);
+
+            if(flow != 0) {
+                remainingValue -= flow;
+                tile.fluidAmountDiff -= flow;
+                if(rightType == PhysicsType::AIR) {
+                    t.put(rightIndex, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                    tiles[rightIndex].fluidAmount = 0.0f;
+                }
+                tiles[rightIndex].fluidAmountDiff += flow;
+            }
+            flowX[index] += flow;
+        }
+
+        if(remainingValue < FLUID_MinValue) {
+            tile.fluidAmountDiff -= remainingValue;
+            t.put(index, tile);
+            return;
+        }
+
+        int topIndex = x + (y - 1) * width;
+        int topType = t.physicsAt(topIndex);
+        Uint16 topId = t.material[topIndex];
+
+        if(topType == PhysicsType::AIR || (topId == id)) {
+            float dstFl = topType == PhysicsType::SOUP ? tiles[topIndex].fluidAmount : 0.0f;
+
+            float flow = remainingValue - CalculateVerticalFlowValue(remainingValue, dstFl);
+            if(flow > FLUID_MinFlow)
+                flow *= FLUID_FlowSpeed;
+
+            flow = std::max(flow, 0.0f);
+            if(flow > std::min(FLUID_MaxFlow, remainingValue))
+                flow = std::min(FLUID_MaxFlow, remainingValue);
+
+            if(flow != 0) {
+                remainingValue -= flow;
+                tile.fluidAmountDiff -= flow;
+                if(topType == PhysicsType::AIR) {
+                    t.put(topIndex, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                    tiles[topIndex].fluidAmount = 0.0f;
+                }
+                tiles[topIndex].fluidAmountDiff += flow;
+            }
+            flowY[index] -= flow;
+        } else if(t.iter == 0 && topType == PhysicsType::SOUP && (topId != id)) {
+            if(rng.next() % 10 == 0) {
+                MaterialInstance top = tiles[topIndex];
+                t.put(index, top);
+                t.put(topIndex, tile);
+                t.wake(x, y - 1);
+                return;
+            }
+        }
+
+        if(remainingValue < FLUID_MinValue) {
+            tile.fluidAmountDiff -= remainingValue;
+            t.put(index, tile);
+            return;
+        }
+
+        if(startValue == remainingValue) {
+            tile.settleCount++;
+            if(tile.settleCount >= 10) {
+                tile.moved = true;
+            }
+        } else {
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+            if(topType    == PhysicsType::SOUP) tiles[topIndex].moved = false;
+            if(bottomType == PhysicsType::SOUP) tiles[bottomIndex].moved = false;
+            if(leftType   == PhysicsType::SOUP) tiles[leftIndex].moved = false;
+            if(rightType  == PhysicsType::SOUP) tiles[rightIndex].moved = false;
+        }
+
+        t.put(index, tile);
+    }
+};
+
+template<>
+class CellKernel<0, PhysicsType::GAS> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        int width = t.width;
+        int above = t.physicsAt((x) + (y - 1) * width);
+        int aboveL = t.physicsAt((x - 1) + (y - 1) * width);
+        int aboveR = t.physicsAt((x + 1) + (y - 1) * width);
+
+        if(above == 0 && !((aboveL == 0 || aboveR == 0) && t.rng.next() % 2 == 0)) {
+            MaterialInstance tile = t.tiles[index];
+            t.put(index, t.tiles[(x) + (y - 1) * width]);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+
+            t.put((x) + (y - 1) * width, tile);
+            t.world->markDirty(x, y - 1);
+            t.wake(x, y - 1);
+
+            t.visited[(x) + (y - 1) * width] = t.epoch;
+        }
+    }
+};
+
+template<>
+class CellKernel<1, PhysicsType::SAND> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        RNG& rng = t.rng;
+        int width = t.width;
+        MaterialInstance* tiles = t.tiles;
+
+        MaterialInstance tile = tiles[index];
+
+        const CellProps& belowL = t.propsAt((x - 1) + (y + 1) * width);
+        const CellProps& belowR = t.propsAt((x + 1) + (y + 1) * width);
+        bool canMoveBelowL = (belowL.physicsType == PhysicsType::AIR || (belowL.physicsType != PhysicsType::SOLID && belowL.density < p.density));
+        bool canMoveBelowR = (belowR.physicsType == PhysicsType::AIR || (belowR.physicsType != PhysicsType::SOLID && belowR.density < p.density));
+
+        bool stoppedByFriction = !tile.moved;
+
+        // 1 to ~127
+        int slipperyness = p.slipperyness;
+
+        if(stoppedByFriction) {
+            int drop = 0;
+
+            for(int pil = 0; pil < 10; pil++) {
+                int pilChL = t.physicsAt((x - 1) + (y + 1 + pil) * width);
+                int pilChR = t.physicsAt((x + 1) + (y + 1 + pil) * width);
+
+                if(pilChL == PhysicsType::AIR || pilChR == PhysicsType::AIR) {
+                    drop++;
+                }
+            }
+
+            // max number of pixels tall a pillar can be before being unstable
+            int maxStability = 8 / sqrt(slipperyness) + 1;
+
+            if(drop + 1 - maxStability > 0) {
+                int chance = 1000 / (drop + 1 - maxStability);
+                if(chance < 1000) {
+                    if(rng.next() % chance == 0) {
+                        stoppedByFriction = false;
+                        tiles[index].moved = true;
+                    }
+                }
+            }
+        }
+
+        if(stoppedByFriction || !(canMoveBelowL || canMoveBelowR)) {
+            tiles[index].moved = false;
+            return;
+        }
+
+        bool shouldMove = rng.next() % (2 * slipperyness) != 0;
+
+        if(shouldMove) {
+            int selfTrasmitMovementChance = 2;
+
+            if(rng.next() % selfTrasmitMovementChance == 0) {
+                if(t.physicsAt((x) + (y + 1) * width) == PhysicsType::SAND) {
+                    int otherTransmitMovementChance = 2;
+                    if(rng.next() % otherTransmitMovementChance == 0) {
+                        tiles[(x) + (y + 1) * width].moved = true;
+                    }
+                }
+            }
+        }
+
+        if(shouldMove && canMoveBelowL && (!canMoveBelowR || rng.next() % 2 == 0)) {
+            MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+            if(t.physicsAt((x - 1) + y * width) == PhysicsType::AIR) {
+                t.put((x - 1) + y * width, belowLTile);
+                t.world->markDirty(x - 1, y);
+                t.wake(x - 1, y);
+                t.visited[(x - 1) + (y) * width] = t.epoch;
+                t.put(index, Tiles::NOTHING);
+                t.world->markDirty(x, y);
+                t.wake(x, y);
+            } else {
+                t.put(index, belowLTile);
+                t.world->markDirty(x, y);
+                t.wake(x, y);
+                t.visited[index] = t.epoch;
+            }
+
+            if(rng.next() % (20 * slipperyness) == 0) {
+                tile.moved = false;
+            }
+            t.put((x - 1) + (y + 1) * width, tile);
+            t.world->markDirty(x - 1, y + 1);
+            t.wake(x - 1, y + 1);
+            t.visited[(x - 1) + (y + 1) * width] = t.epoch;
+
+        } else if(shouldMove && canMoveBelowR) {
+            MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+            if(t.physicsAt((x + 1) + y * width) == PhysicsType::AIR) {
+                t.put((x + 1) + y * width, belowRTile);
+                t.world->markDirty(x + 1, y);
+                t.wake(x + 1, y);
+                t.put(index, Tiles::NOTHING);
+                t.world->markDirty(x, y);
+                t.wake(x, y);
+            } else {
+                t.put(index, belowRTile);
+                t.world->markDirty(x, y);
+                t.wake(x, y);
+                t.visited[index] = t.epoch;
+            }
+
+            if(rng.next() % (20 * slipperyness) == 0) {
+                tile.moved = false;
+            }
+            t.put((x + 1) + (y + 1) * width, tile);
+            t.world->markDirty(x + 1, y + 1);
+            t.wake(x + 1, y + 1);
+            t.visited[(x + 1) + (y + 1) * width] = t.epoch;
+
+        } else {
+            tiles[index].moved = false;
+        }
+    }
+};
+
+template<>
+class CellKernel<1, PhysicsType::SOUP> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        MaterialInstance tile = t.tiles[index];
+
+        bool changed = tile.fluidAmountDiff != 0.0f;
+        tile.fluidAmount += tile.fluidAmountDiff;
+        tile.fluidAmountDiff = 0.0f;
+        if(tile.fluidAmount < FLUID_MinValue) {
+            t.put(index, Tiles::NOTHING);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+            t.visited[index] = t.epoch;
+        } else {
+            t.put(index, tile);
+            t.world->markDirty(x, y);
+            if(changed) t.wake(x, y);
+            t.visited[index] = t.epoch;
+        }
+    }
+};
+
+template<>
+class CellKernel<1, PhysicsType::GAS> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        int width = t.width;
+        int aboveL = t.physicsAt((x - 1) + (y - 1) * width);
+        int aboveR = t.physicsAt((x + 1) + (y - 1) * width);
+
+        if(aboveL == 0 && !(aboveR == 0 && t.rng.next() % 2 == 0)) {
+            MaterialInstance tile = t.tiles[index];
+            t.put(index, t.tiles[(x - 1) + (y - 1) * width]);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+
+            t.put((x - 1) + (y - 1) * width, tile);
+            t.world->markDirty(x - 1, y - 1);
+            t.wake(x - 1, y - 1);
+            t.visited[(x - 1) + (y - 1) * width] = t.epoch;
+        } else if(aboveR == 0) {
+            MaterialInstance tile = t.tiles[index];
+            t.put(index, t.tiles[(x + 1) + (y - 1) * width]);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+
+            t.put((x + 1) + (y - 1) * width, tile);
+            t.world->markDirty(x + 1, y - 1);
+            t.wake(x + 1, y - 1);
+            t.visited[(x + 1) + (y - 1) * width] = t.epoch;
+        }
+    }
+};
+
+template<>
+class CellKernel<2, PhysicsType::GAS> {
+public:
+    static inline void tick(ChunkTick& t, const CellProps& p, int x, int y, int index) {
+        int width = t.width;
+        int l = t.physicsAt((x - 1) + (y) * width);
+        int r = t.physicsAt((x + 1) + (y) * width);
+
+        if(l == 0 && !(r == 0 && t.rng.next() % 2 == 0)) {
+            MaterialInstance tile = t.tiles[index];
+            t.put(index, t.tiles[(x - 1) + (y) * width]);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+
+            t.put((x - 1) + (y) * width, tile);
+            t.world->markDirty(x - 1, y);
+            t.wake(x - 1, y);
+            t.visited[(x - 1) + (y) * width] = t.epoch;
+        } else if(r == 0) {
+            MaterialInstance tile = t.tiles[index];
+            t.put(index, t.tiles[(x + 1) + (y) * width]);
+            t.world->markDirty(x, y);
+            t.wake(x, y);
+
+            t.put((x + 1) + (y) * width, tile);
+            t.world->markDirty(x + 1, y);
+            t.wake(x + 1, y);
+            t.visited[(x + 1) + (y) * width] = t.epoch;
+        } else if(t.material[index] == Materials::STEAM.id) {
+            // trapped steam stays awake until it condenses
+            t.wake(x, y);
+            if(t.rng.next() % 10 == 0) {
+                t.put(index, Tiles::createWater());
+                t.world->markDirty(x, y);
+                t.wake(x, y);
+            }
+        }
+    }
+};
+
+ChunkTick::ChunkTick(World* world, int cx, int cy, SDL_Rect sim, int iter, bool reverseX, uint16_t epoch, RNG& rng, std::vector<std::pair<uint32_t, Particle>>& spawned, uint32_t spawnKey)
+    : rng(rng), spawned(spawned) {
+    this->world = world;
+    this->tiles = world->tiles;
+    this->material = world->cells.material;
+    this->visited = world->tickVisited;
+    this->width = world->width;
+    this->epoch = epoch;
+    this->iter = iter;
+    this->reverseX = reverseX;
+    this->cx = cx;
+    this->cy = cy;
+    this->sim = sim;
+    this->spawnKey = spawnKey;
+}
+
+SDL_Rect ChunkTick::run() {
+    EASY_BLOCK("iter 1");
+    pass<0>();
+    EASY_END_BLOCK;
+
+    growSim();
+    EASY_BLOCK("iter 2");
+    pass<1>();
+    EASY_END_BLOCK;
+
+    growSim();
+    EASY_BLOCK("iter 3");
+    pass<2>();
+    EASY_END_BLOCK;
+
+    return woken();
+}
+
+SDL_Rect ChunkTick::woken() const {
+    if(wakeMinX > wakeMaxX) return {0, 0, 0, 0};
+    return {wakeMinX, wakeMinY, wakeMaxX - wakeMinX + 1, wakeMaxY - wakeMinY + 1};
+}
+
+void ChunkTick::liquidStep(std::vector<int>& cells, std::vector<int>& spill, int substeps) {
+    const CellProps* props = CellGrid::props;
+    int w = width;
+
+    // same order as pass(), bottom row first
+    std::sort(cells.begin(), cells.end(), [w](int a, int b) {
+        int ya = a / w;
+        int yb = b / w;
+        if(ya != yb) return ya > yb;
+        return a < b;
+    });
+
+    EASY_BLOCK("flow");
+    size_t nFlow = cells.size();
+    for(size_t i = 0; i < nFlow; i++) {
+        int index = cells[i];
+        const CellProps& p = props[material[index]];
+        if(p.physicsType != PhysicsType::SOUP) continue;
+        // Material::iterations is per 6 substeps (what the old loop did every tick), rounded up so fewer substeps still flow
+        if(iter >= std::max(1, (p.iterations * substeps + 5) / 6)) continue;
+        CellKernel<0, PhysicsType::SOUP>::tick(*this, p, index % w, index / w, index);
+    }
+    EASY_END_BLOCK;
+
+    // anything that's still flowing pulls in its neighbors so whatever flowed into them gets applied
+    EASY_BLOCK("collect");
+    for(size_t i = 0; i < nFlow; i++) {
+        int index = cells[i];
+        if(physicsAt(index) != PhysicsType::SOUP || tiles[index].moved) continue;
+
+        int around[4] = {index - w, index + w, index - 1, index + 1};
+        for(int n : around) {
+            if(visited[n] == epoch || physicsAt(n) != PhysicsType::SOUP) continue;
+            visited[n] = epoch;
+
+            int nx = n % w;
+            int ny = n / w;
+            if(nx < cx || ny < cy || nx >= cx + CHUNK_W || ny >= cy + CHUNK_H) {
+                spill.push_back(n);
+            } else {
+                cells.push_back(n);
+            }
+        }
+    }
+    EASY_END_BLOCK;
+
+    EASY_BLOCK("apply");
+    for(size_t i = 0; i < cells.size(); i++) {
+        int index = cells[i];
+        const CellProps& p = props[material[index]];
+        if(p.physicsType != PhysicsType::SOUP) continue;
+        CellKernel<1, PhysicsType::SOUP>::tick(*this, p, index % w, index / w, index);
+    }
+
+    // settled liquid drops out until something wakes it again
+    cells.erase(std::remove_if(cells.begin(), cells.end(), [this](int index) {
+        return physicsAt(index) != PhysicsType::SOUP || tiles[index].moved;
+    }), cells.end());
+    EASY_END_BLOCK;
+}
+
+void ChunkTick::growSim() {
+    if(wakeMinX > wakeMaxX) return;
+    int x1 = std::max(std::min(sim.x, wakeMinX), cx);
+    int y1 = std::max(std::min(sim.y, wakeMinY), cy);
+    int x2 = std::min(std::max(sim.x + sim.w, wakeMaxX + 1), cx + CHUNK_W);
+    int y2 = std::min(std::max(sim.y + sim.h, wakeMaxY + 1), cy + CHUNK_H);
+    sim = {x1, y1, x2 - x1, y2 - y1};
+}
+
+void ChunkTick::fireStep(std::vector<int>& cells, std::vector<int>& spill, Uint8* listed) {
+    const CellProps* props = CellGrid::props;
+    int w = width;
+    Uint16 fireId = (Uint16)Materials::FIRE.id;
+
+    std::sort(cells.begin(), cells.end(), [w](int a, int b) {
+        int ya = a / w;
+        int yb = b / w;
+        if(ya != yb) return ya > yb;
+        return a < b;
+    });
+
+    // fire that starts during this step is appended and burns from next tick on
+    size_t n = cells.size();
+    for(size_t i = 0; i < n; i++) {
+        int index = cells[i];
+        if(material[index] != fireId) continue;
+
+        int x = index % w;
+        int y = index / w;
+        MaterialInstance tile = tiles[index];
+
+        if(rng.next() % 10 == 0) {
+            Uint32 rgb = 255;
+            rgb = (rgb << 8) + 100 + rng.next() % 50;
+            rgb = (rgb << 8) + 50;
+            tile.color = rgb;
+        }
+
+        if(rng.next() % 10 == 0) {
+            Particle part(tile, x, y - 1, (rng.next() % 10 - 5) / 20.0f, -((rng.next() % 10) / 10.0f) / 3.0f + -0.5f, 0, 0.01f);
+            part.temporary = true;
+            part.lifetime = 30;
+            part.fadeTime = 10;
+            spawn(part);
+        }
+
+        if(rng.next() % 150 == 0) {
+            put(index, Tiles::NOTHING);
+            world->markDirty(x, y);
+            wake(x, y);
+            continue;
+        }
+
+        // the whole 5x5 neighborhood is read from the material plane at once,
+        //   then one roll decides if any of it catches (about the same odds as each solid tile rolling 1/500)
+        int solid[25];
+        int nSolid = 0;
+        for(int yy = -2; yy <= 2; yy++) {
+            const Uint16* row = material + (index + yy * w - 2);
+            for(int xx = 0; xx < 5; xx++) {
+                if(props[row[xx]].physicsType == PhysicsType::SOLID) solid[nSolid++] = index + yy * w + xx - 2;
+            }
+        }
+
+        if(nSolid > 0) {
+            if(rng.next() % 500 < nSolid) {
+                int s = solid[rng.next() % nSolid];
+                int sx = s % w;
+                int sy = s / w;
+                put(s, Tiles::createFire());
+                world->markDirty(sx, sy);
+                wake(sx, sy);
+
+                if(!listed[s]) {
+                    listed[s] = 1;
+                    if(sx < cx || sy < cy || sx >= cx + CHUNK_W || sy >= cy + CHUNK_H) {
+                        spill.push_back(s);
+                    } else {
+                        cells.push_back(s);
+                    }
+                }
+            }
+        } else if(rng.next() % 120 == 0) {
+            put(index, Tiles::NOTHING);
+            world->markDirty(x, y);
+            wake(x, y);
+        }
+    }
+
+    cells.erase(std::remove_if(cells.begin(), cells.end(), [&](int index) {
+        if(material[index] == fireId) return false;
+        listed[index] = 0;
+        return true;
+    }), cells.end());
+}
+
+template<int Pass>
+void ChunkTick::pass() {
+    const CellProps* props = CellGrid::props;
+
+    for(int dy = sim.h - 1; dy >= 0; dy--) {
+        int y = sim.y + dy;
+        for(int dxf = 0; dxf < sim.w; dxf++) {
+            int dx = reverseX ? (sim.w - 1) - dxf : dxf;
+            int x = sim.x + dx;
+            int index = x + y * width;
+
+            if(visited[index] == epoch) continue;
+
+            const CellProps& p = props[material[index]];
+            if(Pass == 0 && iter >= p.iterations) {
+                visited[index] = epoch;
+                continue;
+            }
+
+            switch(p.physicsType) {
+            case PhysicsType::SAND:
+                CellKernel<Pass, PhysicsType::SAND>::tick(*this, p, x, y, index);
+                break;
+            case PhysicsType::SOUP:
+                if(liquids) CellKernel<Pass, PhysicsType::SOUP>::tick(*this, p, x, y, index);
+                break;
+            case PhysicsType::GAS:
+                CellKernel<Pass, PhysicsType::GAS>::tick(*this, p, x, y, index);
+                break;
+            case PhysicsType::PASSABLE:
+                if(fire) CellKernel<Pass, PhysicsType::PASSABLE>::tick(*this, p, x, y, index);
+                break;
+            }
+        }
+    }
+}
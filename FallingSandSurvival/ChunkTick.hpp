@@ -0,0 +1,100 @@
+#pragma once
+
+#include "world.hpp"
+#include "RNG.hpp"
+
+#include <climits>
+
+#define INC_ChunkTick
+
+// one chunk being simulated during one World::tick pass (used when Settings::tick_cell_kernels is on)
+// each cell is dispatched with a switch on its physics type (from the material plane + CellGrid::props) to a kernel
+//   specialized for that type (see CellKernel in ChunkTick.cpp), so the hot loop doesn't chase MaterialInstance::mat
+// has to do exactly what the old loop in World::tick does (same RNG calls in the same order) so the two stay comparable
+class ChunkTick {
+public:
+    World* world;
+    MaterialInstance* tiles;
+    Uint16* material;
+    uint16_t* visited;
+    int width;
+
+    uint16_t epoch;
+    int iter;
+    bool reverseX;
+    int cx;
+    int cy;
+    SDL_Rect sim;
+
+    RNG& rng;
+    std::vector<std::pair<uint32_t, Particle>>& spawned;
+    uint32_t spawnKey;
+
+    // false leaves SOUP cells to the liquid solver (see liquidStep)
+    bool liquids = true;
+    // false leaves fire to World::tickReactive (see fireStep)
+    bool fire = true;
+    // if set, put() appends every SOLID cell it replaces with something else (for World::tickIslands)
+    std::vector<int>* solidRemoved = nullptr;
+
+    // bounds of everything changed by this chunk (including the 1 tile halo)
+    int wakeMinX = INT_MAX;
+    int wakeMinY = INT_MAX;
+    int wakeMaxX = INT_MIN;
+    int wakeMaxY = INT_MIN;
+
+    ChunkTick(World* world, int cx, int cy, SDL_Rect sim, int iter, bool reverseX, uint16_t epoch, RNG& rng, std::vector<std::pair<uint32_t, Particle>>& spawned, uint32_t spawnKey);
+
+    // runs all three passes, returns the woken rect (w == 0 if nothing woke)
+    SDL_Rect run();
+
+    // one substep of World::tickLiquids over this chunk's unsettled liquid cells (iter is the substep)
+    // flows everything in `cells`, applies the flow to them and the neighbors it reached,
+    //   and leaves only the cells that are still unsettled in `cells`
+    // neighbors in other chunks are stamped and added to `spill` instead
+    // `cells` has to be stamped with epoch in `visited` already (that's how neighbors are deduplicated)
+    void liquidStep(std::vector<int>& cells, std::vector<int>& spill, int substeps);
+
+    // one tick of this chunk's fire list for World::tickReactive
+    // fire that spreads is added to `cells` (or `spill` if it's in another chunk) and flagged in `listed`,
+    //   fire that burnt out is removed from `cells` and unflagged
+    void fireStep(std::vector<int>& cells, std::vector<int>& spill, Uint8* listed);
+
+    // everything woken so far (w == 0 if nothing woke)
+    SDL_Rect woken() const;
+
+    inline void wake(int wx, int wy) {
+        wakeMinX = std::min(wakeMinX, wx - 1);
+        wakeMinY = std::min(wakeMinY, wy - 1);
+        wakeMaxX = std::max(wakeMaxX, wx + 1);
+        wakeMaxY = std::max(wakeMaxY, wy + 1);
+    }
+
+    // every write goes through here so the material plane stays in sync with tiles
+    inline void put(int i, const MaterialInstance& m) {
+        if(solidRemoved && CellGrid::props[material[i]].physicsType == PhysicsType::SOLID && m.mat->physicsType != PhysicsType::SOLID) {
+            solidRemoved->push_back(i);
+        }
+        tiles[i] = m;
+        material[i] = (Uint16)m.mat->id;
+    }
+
+    inline const CellProps& propsAt(int i) const {
+        return CellGrid::props[material[i]];
+    }
+
+    inline int physicsAt(int i) const {
+        return CellGrid::props[material[i]].physicsType;
+    }
+
+    inline void spawn(const Particle& p) {
+        spawned.push_back({spawnKey, p});
+    }
+
+private:
+    // grows sim to include anything woken so far (clamped to this chunk)
+    void growSim();
+
+    template<int Pass>
+    void pass();
+};
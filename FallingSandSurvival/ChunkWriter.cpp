@@ -0,0 +1,106 @@
+
+#include "ChunkWriter.hpp"
+
+#define BUILD_WITH_EASY_PROFILER
+#include <easy/profiler.h>
+#include "ProfilerConfig.hpp"
+
+ChunkWriter::ChunkWriter() {
+    thread = std::thread(&ChunkWriter::run, this);
+}
+
+ChunkWriter::~ChunkWriter() {
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    queueCv.notify_all();
+    thread.join();
+
+    for(auto& s : freeSnapshots) delete s;
+}
+
+void ChunkWriter::queue(Chunk* ch) {
+    EASY_FUNCTION();
+    int64_t k = key(ch->x, ch->y);
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    auto it = pending.find(k);
+    if(it != pending.end()) {
+        // coalesce, the old snapshot was never written
+        ch->snapshot(it->second);
+        return;
+    }
+
+    doneCv.wait(lock, [&]() {
+        return pending.size() < CHUNK_WRITER_MAX_QUEUED;
+    });
+
+    ChunkSnapshot* snap;
+    if(freeSnapshots.empty()) {
+        snap = new ChunkSnapshot();
+    } else {
+        snap = freeSnapshots.back();
+        freeSnapshots.pop_back();
+    }
+
+    if(!ch->snapshot(snap)) {
+        freeSnapshots.push_back(snap);
+        return;
+    }
+
+    pending[k] = snap;
+    order.push_back(k);
+    lock.unlock();
+    queueCv.notify_one();
+}
+
+void ChunkWriter::flush() {
+    EASY_FUNCTION();
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [&]() {
+        return pending.empty() && !isWriting;
+    });
+}
+
+void ChunkWriter::waitFor(int cx, int cy) {
+    int64_t k = key(cx, cy);
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [&]() {
+        return !pending.count(k) && !(isWriting && writing == k);
+    });
+}
+
+void ChunkWriter::run() {
+    EASY_THREAD("Chunk writer");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while(true) {
+        queueCv.wait(lock, [&]() {
+            return stop || !order.empty();
+        });
+        if(order.empty()) {
+            if(stop) return;
+            continue;
+        }
+
+        int64_t k = order.front();
+        order.pop_front();
+        ChunkSnapshot* snap = pending[k];
+        pending.erase(k);
+        writing = k;
+        isWriting = true;
+
+        // the snapshot isn't in `pending` anymore so queue() can't touch it while it's being written
+        lock.unlock();
+        Chunk::writeSnapshot(snap);
+        lock.lock();
+
+        isWriting = false;
+        freeSnapshots.push_back(snap);
+        doneCv.notify_all();
+    }
+}
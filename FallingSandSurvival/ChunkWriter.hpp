@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Chunk.hpp"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+
+#define INC_ChunkWriter
+
+// max snapshots waiting to be written before queue() starts blocking (each is ~400KB)
+#define CHUNK_WRITER_MAX_QUEUED 32
+
+// writes chunks to disk on its own thread
+// queue() takes a snapshot of the chunk right away, the LZ4 compression and region write happen later on the writer thread
+// queueing a chunk that's already waiting just replaces its snapshot, so a chunk written several times in a row only hits the disk once
+class ChunkWriter {
+public:
+    ChunkWriter();
+    ~ChunkWriter();
+
+    // blocks if CHUNK_WRITER_MAX_QUEUED snapshots are already waiting
+    void queue(Chunk* ch);
+    // blocks until everything queued so far has been written
+    void flush();
+    // blocks until the chunk at cx,cy has no pending write (so reading it from disk gets the latest data)
+    void waitFor(int cx, int cy);
+
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable queueCv; // signaled when something is queued
+    std::condition_variable doneCv;  // signaled when something was written
+    bool stop = false;
+
+    std::deque<int64_t> order;
+    std::unordered_map<int64_t, ChunkSnapshot*> pending;
+    // key of the chunk the writer thread is working on right now
+    int64_t writing = 0;
+    bool isWriting = false;
+    std::vector<ChunkSnapshot*> freeSnapshots;
+
+    void run();
+
+    static inline int64_t key(int x, int y) {
+        return ((int64_t)x << 32) | (uint32_t)y;
+    }
+};
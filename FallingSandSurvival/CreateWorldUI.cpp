@@ -170,6 +170,7 @@ void CreateWorldUI::Draw(Game* game) {
         game->stateAfterLoad = INGAME;
 
         EASY_BLOCK("Close world");
+        game->syncWorld();
         delete game->world;
         game->world = nullptr;
         EASY_END_BLOCK;
@@ -30,6 +30,7 @@ void DebugUI::Draw(Game* game) {
 
         ImGui::Checkbox("Draw Chunk States", &Settings::draw_chunk_state);
         ImGui::Checkbox("Draw Load Zones", &Settings::draw_load_zones);
+        ImGui::Checkbox("Draw Active Rects", &Settings::draw_active_rects);
 
         ImGui::Checkbox("Material Tooltips", &Settings::draw_material_info);
         ImGui::Indent(10.0f);
@@ -103,19 +104,21 @@ void DebugUI::Draw(Game* game) {
             ImGui::Checkbox("Draw Temperature Map", &Settings::draw_temperature_map);
 
             if(ImGui::Checkbox("Draw Background", &Settings::draw_background)) {
+                game->syncWorld();
                 for(int x = 0; x < game->world->width; x++) {
                     for(int y = 0; y < game->world->height; y++) {
-                        game->world->dirty[x + y * game->world->width] = true;
-                        game->world->layer2Dirty[x + y * game->world->width] = true;
+                        game->world->markDirty(x, y);
+                        game->world->markLayer2Dirty(x, y);
                     }
                 }
             }
 
             if(ImGui::Checkbox("Draw Background Grid", &Settings::draw_background_grid)) {
+                game->syncWorld();
                 for(int x = 0; x < game->world->width; x++) {
                     for(int y = 0; y < game->world->height; y++) {
-                        game->world->dirty[x + y * game->world->width] = true;
-                        game->world->layer2Dirty[x + y * game->world->width] = true;
+                        game->world->markDirty(x, y);
+                        game->world->markLayer2Dirty(x, y);
                     }
                 }
             }
@@ -160,9 +163,33 @@ void DebugUI::Draw(Game* game) {
 
     ImGui::SetNextItemOpen(true, ImGuiCond_Once);
     if(ImGui::TreeNode("Simulation")) {
-        ImGui::Checkbox("Tick World", &Settings::tick_world);
-        ImGui::Checkbox("Tick Box2D", &Settings::tick_box2d);
-        ImGui::Checkbox("Tick Temperature", &Settings::tick_temperature);
+        // World::tick may be running on the sim thread and reads these, so they only change between ticks
+        auto tickCheckbox = [&](const char* label, bool* v) {
+            bool b = *v;
+            if(ImGui::Checkbox(label, &b)) {
+                game->syncWorld();
+                *v = b;
+            }
+        };
+
+        tickCheckbox("Tick World", &Settings::tick_world);
+        tickCheckbox("Tick World While Rendering", &Settings::tick_world_async);
+        tickCheckbox("Tick Box2D", &Settings::tick_box2d);
+        tickCheckbox("Tick Temperature", &Settings::tick_temperature);
+        tickCheckbox("Sleep Settled Chunks", &Settings::tick_sleep_chunks);
+        tickCheckbox("Use Cell Planes", &Settings::tick_cell_planes);
+        tickCheckbox("Use Cell Kernels", &Settings::tick_cell_kernels);
+        tickCheckbox("Liquid Solver", &Settings::tick_liquid_solver);
+        int substeps = Settings::tick_liquid_substeps;
+        if(ImGui::SliderInt("Liquid Substeps", &substeps, 1, 24)) {
+            game->syncWorld();
+            Settings::tick_liquid_substeps = substeps;
+        }
+        tickCheckbox("Sparse Fire/Reactions", &Settings::tick_reactive_set);
+        tickCheckbox("Distance LOD", &Settings::tick_lod);
+        tickCheckbox("Islands From Removed Solids", &Settings::tick_island_events);
+        tickCheckbox("Rebuild Hitboxes In Background", &Settings::tick_hitbox_async);
+        tickCheckbox("Box Terrain Colliders", &Settings::tick_box_colliders);
 
         ImGui::TreePop();
     }
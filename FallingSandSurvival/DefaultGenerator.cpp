@@ -124,7 +124,7 @@ class DefaultGenerator : public WorldGenerator {
                         double n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                         prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? Tiles::createSmoothDirt(px, py) : Tiles::createSoftDirt(px, py);
                     } else if(py > surf - 65) {
-                        if(rand() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
+                        if(RNG::local().next() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
                     } else {
                         prop[x + y * CHUNK_W] = Tiles::NOTHING;
                     }
@@ -146,7 +146,7 @@ class DefaultGenerator : public WorldGenerator {
                         double n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                         prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? Tiles::createSmoothDirt(px, py) : MaterialInstance(&Materials::GENERIC_SOLID, 0xff0000);
                     } else if(py > surf - 65) {
-                        if(rand() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
+                        if(RNG::local().next() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
                     } else {
                         prop[x + y * CHUNK_W] = Tiles::NOTHING;
                     }
@@ -169,7 +169,7 @@ class DefaultGenerator : public WorldGenerator {
                         double n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                         prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? Tiles::createSmoothDirt(px, py) : MaterialInstance(&Materials::GENERIC_SOLID, 0x00ff00);
                     } else if(py > surf - 65) {
-                        if(rand() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
+                        if(RNG::local().next() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
                     } else {
                         prop[x + y * CHUNK_W] = Tiles::NOTHING;
                     }
@@ -192,7 +192,7 @@ class DefaultGenerator : public WorldGenerator {
                         double n = ((world->noise.GetPerlin(px * 4.0, py * 4.0, 0) / 2.0 + 0.5) + 0.4) / 2.0;
                         prop[x + y * CHUNK_W] = n < abs((surf - 64) - py) / 64.0 ? Tiles::createSmoothDirt(px, py) : MaterialInstance(&Materials::GENERIC_SOLID, 0x0000ff);
                     } else if(py > surf - 65) {
-                        if(rand() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
+                        if(RNG::local().next() % 2 == 0) prop[x + y * CHUNK_W] = Tiles::createGrass();
                     } else {
                         prop[x + y * CHUNK_W] = Tiles::NOTHING;
                     }
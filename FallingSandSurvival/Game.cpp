@@ -11,6 +11,8 @@
 #include "imgui_impl_opengl3.h"
 
 #include "UIs.hpp"
+#include "RNG.hpp"
+#include "Region.hpp"
 
 #include <GL/gl3w.h>
 
@@ -23,6 +25,9 @@
 
 #define W_PI 3.14159265358979323846
 
+// where Game::tick tries to put a rigid body's tile into the world, in order (and where it looks for it if it's not where it was put)
+static const std::pair<int, int> rigidBodyCheckDirs[] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
 void Game::updateMaterialSounds() {
     uint16_t waterCt = min(movingTiles[Materials::WATER.id], (uint16_t)5000);
     float water = (float)waterCt / 3000;
@@ -103,6 +108,7 @@ int Game::init(int argc, char *argv[]) {
         Settings::draw_background = true;
         Settings::draw_background_grid = false;
         Settings::draw_load_zones = false;
+        Settings::draw_active_rects = false;
         Settings::draw_physics_debug = false;
         Settings::draw_chunk_state = false;
         Settings::draw_debug_stats = false;
@@ -562,6 +568,7 @@ int Game::init(int argc, char *argv[]) {
     EASY_BLOCK("init threadpools");
     updateDirtyPool = new ctpl::thread_pool(6);
     rotateVectorsPool = new ctpl::thread_pool(3);
+    simPool = new ctpl::thread_pool(1);
     EASY_END_BLOCK;
     #pragma endregion
 
@@ -887,9 +894,9 @@ void Game::handleWindowSizeChange(int newWidth, int newHeight) {
 
     for(int x = 0; x < world->width; x++) {
         for(int y = 0; y < world->height; y++) {
-            world->dirty[x + y * world->width] = true;
-            world->layer2Dirty[x + y * world->width] = true;
-            world->backgroundDirty[x + y * world->width] = true;
+            world->markDirty(x, y);
+            world->markLayer2Dirty(x, y);
+            world->markBackgroundDirty(x, y);
         }
     }
 
@@ -1077,6 +1084,9 @@ int Game::run(int argc, char *argv[]) {
         now = Time::millis();
         deltaTime = now - lastTime;
 
+        // events and updateFrameEarly write to the world
+        syncWorld();
+
         if(networkMode != NetworkMode::SERVER) {
             #if BUILD_WITH_DISCORD
             DiscordIntegration::tick();
@@ -1145,7 +1155,8 @@ int Game::run(int argc, char *argv[]) {
                                     if(lineX + xx < 0 || lineY + yy < 0 || lineX + xx >= world->width || lineY + yy >= world->height) continue;
                                     MaterialInstance tp = Tiles::create(DebugDrawUI::selectedMaterial, lineX + xx, lineY + yy);
                                     world->tiles[(lineX + xx) + (lineY + yy) * world->width] = tp;
-                                    world->dirty[(lineX + xx) + (lineY + yy) * world->width] = true;
+                                    world->markDirty(lineX + xx, lineY + yy);
+                                    world->markActive(lineX + xx, lineY + yy);
                                 }
                             }
 
@@ -1220,6 +1231,8 @@ int Game::run(int argc, char *argv[]) {
                                             Uint32 pixel = PIXEL(cur->surface, ntx, nty);
                                             if(((pixel >> 24) & 0xff) != 0x00) {
                                                 PIXEL(cur->surface, ntx, nty) = 0x00000000;
+                                                cur->tiles[ntx + nty * cur->matWidth] = Tiles::NOTHING;
+                                                cur->tilesVersion++;
                                                 upd = true;
                                             }
 
@@ -1349,7 +1362,8 @@ int Game::run(int argc, char *argv[]) {
                                         if(world->tiles[(x + xx) + (y + yy) * world->width].mat->physicsType == PhysicsType::SOLID) {
                                             PIXEL(tex, xx, yy) = world->tiles[(x + xx) + (y + yy) * world->width].color;
                                             world->tiles[(x + xx) + (y + yy) * world->width] = Tiles::NOTHING;
-                                            world->dirty[(x + xx) + (y + yy) * world->width] = true;
+                                            world->markDirty(x + xx, y + yy);
+                                            world->markActive(x + xx, y + yy);
 
                                             n++;
                                         }
@@ -1440,7 +1454,8 @@ int Game::run(int argc, char *argv[]) {
                                                 }
                                                 hitSolidYet = true;
                                                 world->tiles[index] = MaterialInstance(&Materials::GENERIC_SAND, Drawing::darkenColor(world->tiles[index].color, 0.5f));
-                                                world->dirty[index] = true;
+                                                world->markDirty(index % world->width, index / world->width);
+                                                world->markActive(index % world->width, index / world->width);
                                                 endInd = index;
                                                 nTilesChanged++;
                                                 return false;
@@ -1807,6 +1822,12 @@ exit:
     EASY_END_BLOCK; // frame??
 
     logInfo("Shutting down...");
+    syncWorld();
+
+    // Box2D and the GPU aren't thread safe, so the chunk bodies go here before unloading on updateDirtyPool
+    while(!world->meshChunks.empty()) {
+        world->releaseChunkMesh(world->meshChunks.back());
+    }
 
     std::vector<std::future<void>> results = {};
 
@@ -1828,6 +1849,12 @@ exit:
     }
     EASY_END_BLOCK;
 
+    // unloadChunk only queues the writes and the world isn't deleted here, so finish them before exiting
+    EASY_BLOCK("flush chunk writes");
+    world->chunkWriter->flush();
+    if(!world->noSaveLoad) Regions::close(world->worldName);
+    EASY_END_BLOCK;
+
     // release resources & shutdown
     #pragma region
     delete objectDelete;
@@ -1917,9 +1944,9 @@ void Game::updateFrameEarly() {
     if(Controls::DEBUG_REFRESH->get()) {
         for(int x = 0; x < world->width; x++) {
             for(int y = 0; y < world->height; y++) {
-                world->dirty[x + y * world->width] = true;
-                world->layer2Dirty[x + y * world->width] = true;
-                world->backgroundDirty[x + y * world->width] = true;
+                world->markDirty(x, y);
+                world->markLayer2Dirty(x, y);
+                world->markBackgroundDirty(x, y);
             }
         }
     }
@@ -1940,22 +1967,28 @@ void Game::updateFrameEarly() {
                         if(tt.mat->id != Materials::GENERIC_AIR.id) {
                             if(world->tiles[tx + ty * world->width].mat->id == Materials::GENERIC_AIR.id) {
                                 world->tiles[tx + ty * world->width] = tt;
-                                world->dirty[tx + ty * world->width] = true;
+                                world->markDirty(tx, ty);
+                                world->markActive(tx, ty);
                             } else if(world->tiles[(tx + 1) + ty * world->width].mat->id == Materials::GENERIC_AIR.id) {
                                 world->tiles[(tx + 1) + ty * world->width] = tt;
-                                world->dirty[(tx + 1) + ty * world->width] = true;
+                                world->markDirty(tx + 1, ty);
+                                world->markActive(tx + 1, ty);
                             } else if(world->tiles[(tx - 1) + ty * world->width].mat->id == Materials::GENERIC_AIR.id) {
                                 world->tiles[(tx - 1) + ty * world->width] = tt;
-                                world->dirty[(tx - 1) + ty * world->width] = true;
+                                world->markDirty(tx - 1, ty);
+                                world->markActive(tx - 1, ty);
                             } else if(world->tiles[tx + (ty + 1) * world->width].mat->id == Materials::GENERIC_AIR.id) {
                                 world->tiles[tx + (ty + 1) * world->width] = tt;
-                                world->dirty[tx + (ty + 1) * world->width] = true;
+                                world->markDirty(tx, ty + 1);
+                                world->markActive(tx, ty + 1);
                             } else if(world->tiles[tx + (ty - 1) * world->width].mat->id == Materials::GENERIC_AIR.id) {
                                 world->tiles[tx + (ty - 1) * world->width] = tt;
-                                world->dirty[tx + (ty - 1) * world->width] = true;
+                                world->markDirty(tx, ty - 1);
+                                world->markActive(tx, ty - 1);
                             } else {
                                 world->tiles[tx + ty * world->width] = Tiles::createObsidian(tx, ty);
-                                world->dirty[tx + ty * world->width] = true;
+                                world->markDirty(tx, ty);
+                                world->markActive(tx, ty);
                             }
                         }
                     }
@@ -2000,7 +2033,8 @@ void Game::updateFrameEarly() {
                 if(world->tiles[(x + xx) + (y + yy) * world->width].mat->physicsType == PhysicsType::SOLID) {
                     PIXEL(tex, xx, yy) = world->tiles[(x + xx) + (y + yy) * world->width].color;
                     world->tiles[(x + xx) + (y + yy) * world->width] = Tiles::NOTHING;
-                    world->dirty[(x + xx) + (y + yy) * world->width] = true;
+                    world->markDirty(x + xx, y + yy);
+                    world->markActive(x + xx, y + yy);
                     n++;
                 }
             }
@@ -2102,7 +2136,7 @@ void Game::updateFrameEarly() {
 
                 MaterialInstance mat = world->player->heldItem->carry[world->player->heldItem->carry.size() - 1];
                 world->player->heldItem->carry.pop_back();
-                world->addParticle(new Particle(mat, (float)x, (float)y, (float)(world->player->vx / 2 + (rand() % 10 - 5) / 10.0f + 1.5f * (float)cos((world->player->holdAngle + 180) * 3.1415f / 180.0f)), (float)(world->player->vy / 2 + -(rand() % 5 + 5) / 10.0f + 1.5f * (float)sin((world->player->holdAngle + 180) * 3.1415f / 180.0f)), 0, (float)0.1));
+                world->addParticle(Particle(mat, (float)x, (float)y, (float)(world->player->vx / 2 + (rand() % 10 - 5) / 10.0f + 1.5f * (float)cos((world->player->holdAngle + 180) * 3.1415f / 180.0f)), (float)(world->player->vy / 2 + -(rand() % 5 + 5) / 10.0f + 1.5f * (float)sin((world->player->holdAngle + 180) * 3.1415f / 180.0f)), 0, (float)0.1));
 
                 int i = (int)world->player->heldItem->carry.size();
                 i = (int)((i / (float)world->player->heldItem->capacity) * world->player->heldItem->fill.size());
@@ -2144,7 +2178,8 @@ void Game::updateFrameEarly() {
                                 GPU_SetImageFilter(world->player->heldItem->texture, GPU_FILTER_NEAREST);
 
                                 world->tiles[(x + xx) + (y + yy) * world->width] = Tiles::NOTHING;
-                                world->dirty[(x + xx) + (y + yy) * world->width] = true;
+                                world->markDirty(x + xx, y + yy);
+                                world->markActive(x + xx, y + yy);
                                 n++;
                             }
                         }
@@ -2226,9 +2261,25 @@ void Game::updateFrameEarly() {
     }
 }
 
+void Game::syncWorld() {
+    if(simTick.valid()) {
+        EASY_BLOCK("wait for World::tick", THREAD_WAIT_PROFILER_COLOR);
+        simTick.get();
+        EASY_END_BLOCK;
+    }
+
+    if(tickLatePending) {
+        tickLatePending = false;
+        tickLate();
+    }
+}
+
 void Game::tick() {
     EASY_FUNCTION(GAME_PROFILER_COLOR);
 
+    // more than one tick per frame
+    syncWorld();
+
     //logDebug("{0:d} {0:d}", accLoadX, accLoadY);
     if(state == LOADING) {
         if(world) {
@@ -2336,40 +2387,65 @@ void Game::tick() {
             float s = sin(cur->body->GetAngle());
             float c = cos(cur->body->GetAngle());
 
-            std::vector<std::pair<int, int>> checkDirs = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+            // sleeping bodies still have to be in the world while it ticks (or sand and liquids would go through them),
+            // but if it hasn't moved since the last stamp its tiles can go straight back where they were
+            bool reuseStamp = !cur->body->IsAwake() && cur->stampedAt.size() == (size_t)(cur->matWidth * cur->matHeight)
+                && cur->stampPos.x == x && cur->stampPos.y == y && cur->stampAngle == cur->body->GetAngle();
+            if(!reuseStamp) cur->stampedAt.assign(cur->matWidth * cur->matHeight, -1);
+            cur->stamped = true;
+            cur->stampPos = cur->body->GetPosition();
+            cur->stampAngle = cur->body->GetAngle();
 
             for(int tx = 0; tx < cur->matWidth; tx++) {
                 for(int ty = 0; ty < cur->matHeight; ty++) {
                     MaterialInstance rmat = cur->tiles[tx + ty * cur->matWidth];
                     if(rmat.mat->id == Materials::GENERIC_AIR.id) continue;
 
+                    if(reuseStamp) {
+                        int last = cur->stampedAt[tx + ty * cur->matWidth];
+                        cur->stampedAt[tx + ty * cur->matWidth] = -1;
+                        if(last >= 0 && world->tiles[last].mat->physicsType == PhysicsType::AIR) {
+                            world->tiles[last] = rmat;
+                            cur->stampedAt[tx + ty * cur->matWidth] = last;
+                            world->markDirty(last % world->width, last / world->width);
+                            world->markActive(last % world->width, last / world->width);
+                            continue;
+                        }
+                    }
+
                     // rotate point
                     int wx = (int)(tx * c - (ty + 1) * s + x);
                     int wy = (int)(tx * s + (ty + 1) * c + y);
 
-                    for(auto& dir : checkDirs) {
+                    for(auto& dir : rigidBodyCheckDirs) {
                         int wxd = wx + dir.first;
                         int wyd = wy + dir.second;
 
                         if(wxd < 0 || wyd < 0 || wxd >= world->width || wyd >= world->height) continue;
                         if(world->tiles[wxd + wyd * world->width].mat->physicsType == PhysicsType::AIR) {
                             world->tiles[wxd + wyd * world->width] = rmat;
-                            world->dirty[wxd + wyd * world->width] = true;
+                            cur->stampedAt[tx + ty * cur->matWidth] = wxd + wyd * world->width;
+                            world->markDirty(wxd, wyd);
+                            world->markActive(wxd, wyd);
                             //objectDelete[wxd + wyd * world->width] = true;
                             break;
                         } else if(world->tiles[wxd + wyd * world->width].mat->physicsType == PhysicsType::SAND) {
-                            world->addParticle(new Particle(world->tiles[wxd + wyd * world->width], (float)wxd, (float)(wyd - 3), (float)((rand() % 10 - 5) / 10.0f), (float)(-(rand() % 5 + 5) / 10.0f), 0, (float)0.1));
+                            world->addParticle(Particle(world->tiles[wxd + wyd * world->width], (float)wxd, (float)(wyd - 3), (float)((RNG::local().next() % 10 - 5) / 10.0f), (float)(-(RNG::local().next() % 5 + 5) / 10.0f), 0, (float)0.1));
                             world->tiles[wxd + wyd * world->width] = rmat;
+                            cur->stampedAt[tx + ty * cur->matWidth] = wxd + wyd * world->width;
                             //objectDelete[wxd + wyd * world->width] = true;
-                            world->dirty[wxd + wyd * world->width] = true;
+                            world->markDirty(wxd, wyd);
+                            world->markActive(wxd, wyd);
                             cur->body->SetLinearVelocity({cur->body->GetLinearVelocity().x * (float)0.99, cur->body->GetLinearVelocity().y * (float)0.99});
                             cur->body->SetAngularVelocity(cur->body->GetAngularVelocity() * (float)0.98);
                             break;
                         } else if(world->tiles[wxd + wyd * world->width].mat->physicsType == PhysicsType::SOUP) {
-                            world->addParticle(new Particle(world->tiles[wxd + wyd * world->width], (float)wxd, (float)(wyd - 3), (float)((rand() % 10 - 5) / 10.0f), (float)(-(rand() % 5 + 5) / 10.0f), 0, (float)0.1));
+                            world->addParticle(Particle(world->tiles[wxd + wyd * world->width], (float)wxd, (float)(wyd - 3), (float)((RNG::local().next() % 10 - 5) / 10.0f), (float)(-(RNG::local().next() % 5 + 5) / 10.0f), 0, (float)0.1));
                             world->tiles[wxd + wyd * world->width] = rmat;
+                            cur->stampedAt[tx + ty * cur->matWidth] = wxd + wyd * world->width;
                             //objectDelete[wxd + wyd * world->width] = true;
-                            world->dirty[wxd + wyd * world->width] = true;
+                            world->markDirty(wxd, wyd);
+                            world->markActive(wxd, wyd);
                             cur->body->SetLinearVelocity({cur->body->GetLinearVelocity().x * (float)0.998, cur->body->GetLinearVelocity().y * (float)0.998});
                             cur->body->SetAngularVelocity(cur->body->GetAngularVelocity() * (float)0.99);
                             break;
@@ -2414,430 +2490,479 @@ void Game::tick() {
                     if(world->tiles[wx + wy * world->width].mat->physicsType == PhysicsType::AIR) {
                         world->tiles[wx + wy * world->width] = Tiles::OBJECT;
                         objectDelete[wx + wy * world->width] = true;
+                        world->markActive(wx, wy);
                     } else if(world->tiles[wx + wy * world->width].mat->physicsType == PhysicsType::SAND || world->tiles[wx + wy * world->width].mat->physicsType == PhysicsType::SOUP) {
-                        world->addParticle(new Particle(world->tiles[wx + wy * world->width], (float)(wx + rand() % 3 - 1 - cur.vx), (float)(wy - abs(cur.vy)), (float)(-cur.vx / 4 + (rand() % 10 - 5) / 5.0f), (float)(-cur.vy / 4 + -(rand() % 5 + 5) / 5.0f), 0, (float)0.1));
+                        world->addParticle(Particle(world->tiles[wx + wy * world->width], (float)(wx + RNG::local().next() % 3 - 1 - cur.vx), (float)(wy - abs(cur.vy)), (float)(-cur.vx / 4 + (RNG::local().next() % 10 - 5) / 5.0f), (float)(-cur.vy / 4 + -(RNG::local().next() % 5 + 5) / 5.0f), 0, (float)0.1));
                         world->tiles[wx + wy * world->width] = Tiles::OBJECT;
                         objectDelete[wx + wy * world->width] = true;
-                        world->dirty[wx + wy * world->width] = true;
+                        world->markDirty(wx, wy);
+                        world->markActive(wx, wy);
                     }
                 }
             }
         }
         #pragma endregion
 
-        if(Settings::tick_world && world->readyToMerge.size() == 0) {
-            world->tick();
-        }
+        // what's on screen (in tile coords) ticks at full rate, see World::updateLod
+        world->lodFocus = {(int)((-ofsX - camX) / scale), (int)((-ofsY - camY) / scale), (int)(WIDTH / scale), (int)(HEIGHT / scale)};
 
+        // the objects are stamped into the grid now, World::tick has to run before tickLate picks them back up
+        // (tickLate also runs World::tickFinish, so islands and physicsCheck don't see stamped bodies)
+        world->deferTickFinish = true;
         if(Controls::DEBUG_TICK->get()) {
             world->tick();
         }
 
-        // player movement
-        tickPlayer();
+        bool tickWorld = Settings::tick_world && world->readyToMerge.size() == 0;
+        if(tickWorld && Settings::tick_world_async) {
+            // runs while the frame renders, syncWorld waits for it and then does tickLate before anything else touches the world
+            tickLatePending = true;
+            simTick = simPool->push([this](int id) {
+                EASY_THREAD("World::tick Thread");
+                world->tick();
+            });
+        } else {
+            if(tickWorld) world->tick();
+            tickLate();
+        }
 
-        // update particles, tickObjects, update dirty
-        // TODO: this is not entirely thread safe since tickParticles changes World::tiles and World::dirty
-        #pragma region
-        EASY_BLOCK("post World::tick");
-        bool hadDirty = false;
-        bool hadLayer2Dirty = false;
-        bool hadBackgroundDirty = false;
-        bool hadFire = false;
-        bool hadFlow = false;
-
-        int pitch;
-        //void* vdpixels_ar = texture->data;
-        //unsigned char* dpixels_ar = (unsigned char*)vdpixels_ar;
-        unsigned char* dpixels_ar = pixels_ar;
-        unsigned char* dpixelsFire_ar = pixelsFire_ar;
-        unsigned char* dpixelsFlow_ar = pixelsFlow_ar;
-        unsigned char* dpixelsEmission_ar = pixelsEmission_ar;
+        EASY_END_BLOCK;
+    }
+}
 
-        std::vector<std::future<void>> results = {};
+// the rest of the in-game tick after World::tick: player, particles, picking the objects back up out of the grid and uploading what changed
+void Game::tickLate() {
+    EASY_FUNCTION(GAME_PROFILER_COLOR);
 
-        results.push_back(updateDirtyPool->push([&](int id) {
-            EASY_BLOCK("particles");
-            //SDL_SetRenderTarget(renderer, textureParticles);
-            void* particlePixels = pixelsParticles_ar;
-            EASY_BLOCK("memset");
-            memset(particlePixels, 0, (size_t)world->width * world->height * 4);
-            EASY_END_BLOCK; // memset
-            world->renderParticles((unsigned char**)&particlePixels);
-            world->tickParticles();
-
-            //SDL_SetRenderTarget(renderer, NULL);
-            EASY_END_BLOCK; // particles
-        }));
+    // player movement
+    tickPlayer();
 
-        if(world->readyToMerge.size() == 0) {
-            results.push_back(updateDirtyPool->push([&](int id) {
-                world->tickObjectBounds();
-            }));
-        }
+    // update particles, tickObjects, update dirty
+    // TODO: this is not entirely thread safe since tickParticles changes World::tiles and World::dirty
+    #pragma region
+    EASY_BLOCK("post World::tick");
+    bool hadDirty = false;
+    bool hadLayer2Dirty = false;
+    bool hadBackgroundDirty = false;
+    bool hadFire = false;
+    bool hadFlow = false;
+
+    int pitch;
+    //void* vdpixels_ar = texture->data;
+    //unsigned char* dpixels_ar = (unsigned char*)vdpixels_ar;
+    unsigned char* dpixels_ar = pixels_ar;
+    unsigned char* dpixelsFire_ar = pixelsFire_ar;
+    unsigned char* dpixelsFlow_ar = pixelsFlow_ar;
+    unsigned char* dpixelsEmission_ar = pixelsEmission_ar;
 
-        EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
-        for(int i = 0; i < results.size(); i++) {
-            results[i].get();
-        }
-        EASY_END_BLOCK;
+    std::vector<std::future<void>> results = {};
 
-        for(size_t i = 0; i < world->rigidBodies.size(); i++) {
-            RigidBody* cur = world->rigidBodies[i];
-            if(cur == nullptr) continue;
-            if(cur->surface == nullptr) continue;
-            if(!cur->body->IsEnabled()) continue;
+    results.push_back(updateDirtyPool->push([&](int id) {
+        EASY_BLOCK("particles");
+        //SDL_SetRenderTarget(renderer, textureParticles);
+        void* particlePixels = pixelsParticles_ar;
+        EASY_BLOCK("memset");
+        memset(particlePixels, 0, (size_t)world->width * world->height * 4);
+        EASY_END_BLOCK; // memset
+        world->renderParticles((unsigned char**)&particlePixels);
+        world->tickParticles();
 
-            float x = cur->body->GetPosition().x;
-            float y = cur->body->GetPosition().y;
+        //SDL_SetRenderTarget(renderer, NULL);
+        EASY_END_BLOCK; // particles
+    }));
 
-            float s = sin(cur->body->GetAngle());
-            float c = cos(cur->body->GetAngle());
+    if(world->readyToMerge.size() == 0) {
+        results.push_back(updateDirtyPool->push([&](int id) {
+            world->tickObjectBounds();
+        }));
+    }
 
-            std::vector<std::pair<int, int>> checkDirs = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
-            for(int tx = 0; tx < cur->matWidth; tx++) {
-                for(int ty = 0; ty < cur->matHeight; ty++) {
-                    MaterialInstance rmat = cur->tiles[tx + ty * cur->matWidth];
-                    if(rmat.mat->id == Materials::GENERIC_AIR.id) continue;
+    EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
+    for(int i = 0; i < results.size(); i++) {
+        results[i].get();
+    }
+    EASY_END_BLOCK;
 
+    for(size_t i = 0; i < world->rigidBodies.size(); i++) {
+        RigidBody* cur = world->rigidBodies[i];
+        if(cur == nullptr) continue;
+        if(cur->surface == nullptr) continue;
+        if(!cur->body->IsEnabled()) continue;
+
+        float x = cur->body->GetPosition().x;
+        float y = cur->body->GetPosition().y;
+
+        // not stamped this tick (made since then, e.g. by physicsCheck)
+        if(!cur->stamped) continue;
+        cur->stamped = false;
+
+        float s = sin(cur->body->GetAngle());
+        float c = cos(cur->body->GetAngle());
+
+        // tiles that look different go into dirtyPixels, tiles that are gone also mean the hitbox has to be rebuilt
+        bool shapeChanged = false;
+        for(int tx = 0; tx < cur->matWidth; tx++) {
+            for(int ty = 0; ty < cur->matHeight; ty++) {
+                int ti = tx + ty * cur->matWidth;
+                MaterialInstance rmat = cur->tiles[ti];
+                if(rmat.mat->id == Materials::GENERIC_AIR.id) continue;
+
+                // usually it's still where it was put, otherwise look for it around there
+                int found = -1;
+                int stamped = cur->stampedAt[ti];
+                if(stamped >= 0 && world->tiles[stamped] == rmat) {
+                    found = stamped;
+                } else {
                     // rotate point
                     int wx = (int)(tx * c - (ty + 1) * s + x);
                     int wy = (int)(tx * s + (ty + 1) * c + y);
 
-                    bool found = false;
-                    for(auto& dir : checkDirs) {
+                    for(auto& dir : rigidBodyCheckDirs) {
                         int wxd = wx + dir.first;
                         int wyd = wy + dir.second;
 
                         if(wxd < 0 || wyd < 0 || wxd >= world->width || wyd >= world->height) continue;
                         if(world->tiles[wxd + wyd * world->width] == rmat) {
-                            cur->tiles[tx + ty * cur->matWidth] = world->tiles[wxd + wyd * world->width];
-                            world->tiles[wxd + wyd * world->width] = Tiles::NOTHING;
-                            world->dirty[wxd + wyd * world->width] = true;
-                            found = true;
-
-                            //for(int dxx = -1; dxx <= 1; dxx++) {
-                            //    for(int dyy = -1; dyy <= 1; dyy++) {
-                            //        if(world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].mat->physicsType == PhysicsType::SAND || world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].mat->physicsType == PhysicsType::SOUP) {
-                            //            uint32_t color = world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].color;
-
-                            //            unsigned int offset = ((wxd + dxx) + (wyd + dyy) * world->width) * 4;
-
-                            //            dpixels_ar[offset + 2] = ((color >> 0) & 0xff);        // b
-                            //            dpixels_ar[offset + 1] = ((color >> 8) & 0xff);        // g
-                            //            dpixels_ar[offset + 0] = ((color >> 16) & 0xff);        // r
-                            //            dpixels_ar[offset + 3] = world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].mat->alpha;    // a
-                            //        }
-                            //    }
-                            //}
-
-                            //if(!Settings::draw_load_zones) {
-                            //    unsigned int offset = (wxd + wyd * world->width) * 4;
-                            //    dpixels_ar[offset + 2] = 0;        // b
-                            //    dpixels_ar[offset + 1] = 0;        // g
-                            //    dpixels_ar[offset + 0] = 0xff;        // r
-                            //    dpixels_ar[offset + 3] = 0xff;    // a
-                            //}
-                            	
-
+                            found = wxd + wyd * world->width;
                             break;
                         }
                     }
 
-                    if(!found) {
+                    if(found == -1) {
                         if(world->tiles[wx + wy * world->width].mat->id == Materials::GENERIC_AIR.id) {
-                            cur->tiles[tx + ty * cur->matWidth] = Tiles::NOTHING;
+                            cur->tiles[ti] = Tiles::NOTHING;
+                            cur->dirtyPixels.push_back(ti);
+                            shapeChanged = true;
                         }
+                        continue;
                     }
                 }
+
+                int wxd = found % world->width;
+                int wyd = found / world->width;
+                MaterialInstance& wmat = world->tiles[found];
+                if(wmat.mat != rmat.mat || wmat.color != rmat.color) {
+                    cur->dirtyPixels.push_back(ti);
+                    if(wmat.mat->id == Materials::GENERIC_AIR.id) shapeChanged = true;
+                }
+                cur->tiles[ti] = wmat;
+                world->tiles[found] = Tiles::NOTHING;
+                world->markDirty(wxd, wyd);
+                world->markActive(wxd, wyd);
+
+                //for(int dxx = -1; dxx <= 1; dxx++) {
+                //    for(int dyy = -1; dyy <= 1; dyy++) {
+                //        if(world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].mat->physicsType == PhysicsType::SAND || world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].mat->physicsType == PhysicsType::SOUP) {
+                //            uint32_t color = world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].color;
+
+                //            unsigned int offset = ((wxd + dxx) + (wyd + dyy) * world->width) * 4;
+
+                //            dpixels_ar[offset + 2] = ((color >> 0) & 0xff);        // b
+                //            dpixels_ar[offset + 1] = ((color >> 8) & 0xff);        // g
+                //            dpixels_ar[offset + 0] = ((color >> 16) & 0xff);        // r
+                //            dpixels_ar[offset + 3] = world->tiles[(wxd + dxx) + (wyd + dyy) * world->width].mat->alpha;    // a
+                //        }
+                //    }
+                //}
+
+                //if(!Settings::draw_load_zones) {
+                //    unsigned int offset = (wxd + wyd * world->width) * 4;
+                //    dpixels_ar[offset + 2] = 0;        // b
+                //    dpixels_ar[offset + 1] = 0;        // g
+                //    dpixels_ar[offset + 0] = 0xff;        // r
+                //    dpixels_ar[offset + 3] = 0xff;    // a
+                //}
             }
+        }
 
-            for(int tx = 0; tx < cur->surface->w; tx++) {
-                for(int ty = 0; ty < cur->surface->h; ty++) {
-                    MaterialInstance mat = cur->tiles[tx + ty * cur->surface->w];
-                    if(mat.mat->id == Materials::GENERIC_AIR.id) {
-                        PIXEL(cur->surface, tx, ty) = 0x00000000;
-                    } else {
-                        PIXEL(cur->surface, tx, ty) = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
-                    }
+        // only bodies that changed get re-encoded (and re-uploaded by the render loop)
+        if(!cur->dirtyPixels.empty()) {
+            for(int i : cur->dirtyPixels) {
+                MaterialInstance mat = cur->tiles[i];
+                if(mat.mat->id == Materials::GENERIC_AIR.id) {
+                    PIXEL(cur->surface, i % cur->matWidth, i / cur->matWidth) = 0x00000000;
+                } else {
+                    PIXEL(cur->surface, i % cur->matWidth, i / cur->matWidth) = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
                 }
             }
+            cur->dirtyPixels.clear();
+            cur->texNeedsUpdate = true;
+            cur->tilesVersion++;
+        }
 
-            GPU_FreeImage(cur->texture);
-            cur->texture = GPU_CopyImageFromSurface(cur->surface);
-            GPU_SetImageFilter(cur->texture, GPU_FILTER_NEAREST);
+        if(shapeChanged) cur->needsUpdate = true;
+    }
 
-            cur->needsUpdate = true;
-        }
+    if(world->readyToMerge.size() == 0) {
+        if(Settings::tick_box2d) world->tickObjects();
+    }
 
-        if(world->readyToMerge.size() == 0) {
-            if(Settings::tick_box2d) world->tickObjects();
-        }
+    if(tickTime % 10 == 0) world->tickObjectsMesh();
 
-        if(tickTime % 10 == 0) world->tickObjectsMesh();
+    for(int i = 0; i < Materials::nMaterials; i++) movingTiles[i] = 0;
 
-        for(int i = 0; i < Materials::nMaterials; i++) movingTiles[i] = 0;
+    EASY_BLOCK("take dirty rects");
+    dirtyRects.clear();
+    layer2DirtyRects.clear();
+    backgroundDirtyRects.clear();
+    world->takeDirtyRects(world->dirtyTiles, dirtyRects);
+    world->takeDirtyRects(world->layer2DirtyTiles, layer2DirtyRects);
+    world->takeDirtyRects(world->backgroundDirtyTiles, backgroundDirtyRects);
+    EASY_END_BLOCK;
+
+    results.clear();
+    results.push_back(updateDirtyPool->push([&](int id) {
+        EASY_BLOCK("dirty");
+        for(auto& r : dirtyRects) {
+            for(int y = r.y; y < r.y + r.h; y++) {
+                for(int x = r.x; x < r.x + r.w; x++) {
+                    const unsigned int i = x + y * world->width;
+                    const unsigned int offset = i * 4;
+
+                    if(world->dirty[i]) {
+                        hadDirty = true;
+                        movingTiles[world->tiles[i].mat->id]++;
+                        if(world->tiles[i].mat->physicsType == PhysicsType::AIR) {
+                            dpixels_ar[offset + 0] = 0;        // b
+                            dpixels_ar[offset + 1] = 0;        // g
+                            dpixels_ar[offset + 2] = 0;        // r
+                            dpixels_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a		
+
+                            dpixelsFire_ar[offset + 0] = 0;        // b
+                            dpixelsFire_ar[offset + 1] = 0;        // g
+                            dpixelsFire_ar[offset + 2] = 0;        // r
+                            dpixelsFire_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a
+
+                            dpixelsEmission_ar[offset + 0] = 0;        // b
+                            dpixelsEmission_ar[offset + 1] = 0;        // g
+                            dpixelsEmission_ar[offset + 2] = 0;        // r
+                            dpixelsEmission_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a
 
-        results.clear();
-        results.push_back(updateDirtyPool->push([&](int id) {
-            EASY_BLOCK("dirty");
-            for(int i = 0; i < world->width * world->height; i++) {
-                const unsigned int offset = i * 4;
-
-                if(world->dirty[i]) {
-                    hadDirty = true;
-                    movingTiles[world->tiles[i].mat->id]++;
-                    if(world->tiles[i].mat->physicsType == PhysicsType::AIR) {
-                        dpixels_ar[offset + 0] = 0;        // b
-                        dpixels_ar[offset + 1] = 0;        // g
-                        dpixels_ar[offset + 2] = 0;        // r
-                        dpixels_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a		
-
-                        dpixelsFire_ar[offset + 0] = 0;        // b
-                        dpixelsFire_ar[offset + 1] = 0;        // g
-                        dpixelsFire_ar[offset + 2] = 0;        // r
-                        dpixelsFire_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a
-
-                        dpixelsEmission_ar[offset + 0] = 0;        // b
-                        dpixelsEmission_ar[offset + 1] = 0;        // g
-                        dpixelsEmission_ar[offset + 2] = 0;        // r
-                        dpixelsEmission_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a
-
-                        world->flowY[i] = 0;
-                        world->flowX[i] = 0;
-                    } else {
-                        Uint32 color = world->tiles[i].color;
-                        Uint32 emit = world->tiles[i].mat->emitColor;
-                        //float br = world->light[i];
-                        dpixels_ar[offset + 2] = ((color >> 0) & 0xff);        // b
-                        dpixels_ar[offset + 1] = ((color >> 8) & 0xff);        // g
-                        dpixels_ar[offset + 0] = ((color >> 16) & 0xff);        // r
-                        dpixels_ar[offset + 3] = world->tiles[i].mat->alpha;    // a
-
-                        dpixelsEmission_ar[offset + 2] = ((emit >> 0) & 0xff);        // b
-                        dpixelsEmission_ar[offset + 1] = ((emit >> 8) & 0xff);        // g
-                        dpixelsEmission_ar[offset + 0] = ((emit >> 16) & 0xff);        // r
-                        dpixelsEmission_ar[offset + 3] = ((emit >> 24) & 0xff);    // a
-
-                        if(world->tiles[i].mat->id == Materials::FIRE.id) {
-                            dpixelsFire_ar[offset + 2] = ((color >> 0) & 0xff);        // b
-                            dpixelsFire_ar[offset + 1] = ((color >> 8) & 0xff);        // g
-                            dpixelsFire_ar[offset + 0] = ((color >> 16) & 0xff);        // r
-                            dpixelsFire_ar[offset + 3] = world->tiles[i].mat->alpha;    // a
-                            hadFire = true;
-                        }
-                        if(world->tiles[i].mat->physicsType == PhysicsType::SOUP) {
-
-                            float newFlowX = world->prevFlowX[i] + (world->flowX[i] - world->prevFlowX[i]) * 0.25;
-                            float newFlowY = world->prevFlowY[i] + (world->flowY[i] - world->prevFlowY[i]) * 0.25;
-                            if(newFlowY < 0) newFlowY *= 0.5;
-
-                            dpixelsFlow_ar[offset + 2] = 0; // b
-                            dpixelsFlow_ar[offset + 1] = std::min(std::max(newFlowY * (3.0 / world->tiles[i].mat->iterations + 0.5) / 4.0 + 0.5, 0.0), 1.0) * 255; // g
-                            dpixelsFlow_ar[offset + 0] = std::min(std::max(newFlowX * (3.0 / world->tiles[i].mat->iterations + 0.5) / 4.0 + 0.5, 0.0), 1.0) * 255; // r
-                            dpixelsFlow_ar[offset + 3] = 0xff; // a
-                            hadFlow = true;
-                            world->prevFlowX[i] = newFlowX;
-                            world->prevFlowY[i] = newFlowY;
                             world->flowY[i] = 0;
                             world->flowX[i] = 0;
                         } else {
-                            world->flowY[i] = 0;
-                            world->flowX[i] = 0;
+                            Uint32 color = world->tiles[i].color;
+                            Uint32 emit = world->tiles[i].mat->emitColor;
+                            //float br = world->light[i];
+                            dpixels_ar[offset + 2] = ((color >> 0) & 0xff);        // b
+                            dpixels_ar[offset + 1] = ((color >> 8) & 0xff);        // g
+                            dpixels_ar[offset + 0] = ((color >> 16) & 0xff);        // r
+                            dpixels_ar[offset + 3] = world->tiles[i].mat->alpha;    // a
+
+                            dpixelsEmission_ar[offset + 2] = ((emit >> 0) & 0xff);        // b
+                            dpixelsEmission_ar[offset + 1] = ((emit >> 8) & 0xff);        // g
+                            dpixelsEmission_ar[offset + 0] = ((emit >> 16) & 0xff);        // r
+                            dpixelsEmission_ar[offset + 3] = ((emit >> 24) & 0xff);    // a
+
+                            if(world->tiles[i].mat->id == Materials::FIRE.id) {
+                                dpixelsFire_ar[offset + 2] = ((color >> 0) & 0xff);        // b
+                                dpixelsFire_ar[offset + 1] = ((color >> 8) & 0xff);        // g
+                                dpixelsFire_ar[offset + 0] = ((color >> 16) & 0xff);        // r
+                                dpixelsFire_ar[offset + 3] = world->tiles[i].mat->alpha;    // a
+                                hadFire = true;
+                            }
+                            if(world->tiles[i].mat->physicsType == PhysicsType::SOUP) {
+
+                                float newFlowX = world->prevFlowX[i] + (world->flowX[i] - world->prevFlowX[i]) * 0.25;
+                                float newFlowY = world->prevFlowY[i] + (world->flowY[i] - world->prevFlowY[i]) * 0.25;
+                                if(newFlowY < 0) newFlowY *= 0.5;
+
+                                dpixelsFlow_ar[offset + 2] = 0; // b
+                                dpixelsFlow_ar[offset + 1] = std::min(std::max(newFlowY * (3.0 / world->tiles[i].mat->iterations + 0.5) / 4.0 + 0.5, 0.0), 1.0) * 255; // g
+                                dpixelsFlow_ar[offset + 0] = std::min(std::max(newFlowX * (3.0 / world->tiles[i].mat->iterations + 0.5) / 4.0 + 0.5, 0.0), 1.0) * 255; // r
+                                dpixelsFlow_ar[offset + 3] = 0xff; // a
+                                hadFlow = true;
+                                world->prevFlowX[i] = newFlowX;
+                                world->prevFlowY[i] = newFlowY;
+                                world->flowY[i] = 0;
+                                world->flowX[i] = 0;
+                            } else {
+                                world->flowY[i] = 0;
+                                world->flowX[i] = 0;
+                            }
                         }
                     }
                 }
+                memset(&world->dirty[r.x + y * world->width], false, r.w);
             }
-            EASY_END_BLOCK;
-        }));
-
-        //void* vdpixelsLayer2_ar = textureLayer2->data;
-        //unsigned char* dpixelsLayer2_ar = (unsigned char*)vdpixelsLayer2_ar;
-        unsigned char* dpixelsLayer2_ar = pixelsLayer2_ar;
-        results.push_back(updateDirtyPool->push([&](int id) {
-            EASY_BLOCK("layer2Dirty");
-            for(int i = 0; i < world->width * world->height; i++) {
-                /*for (int x = 0; x < world->width; x++) {
-                    for (int y = 0; y < world->height; y++) {*/
-                    //const unsigned int i = x + y * world->width;
-                const unsigned int offset = i * 4;
-                if(world->layer2Dirty[i]) {
-                    hadLayer2Dirty = true;
-                    if(world->layer2[i].mat->physicsType == PhysicsType::AIR) {
-                        if(Settings::draw_background_grid) {
-                            Uint32 color = ((i) % 2) == 0 ? 0x888888 : 0x444444;
-                            dpixelsLayer2_ar[offset + 2] = (color >> 0) & 0xff;        // b
-                            dpixelsLayer2_ar[offset + 1] = (color >> 8) & 0xff;        // g
-                            dpixelsLayer2_ar[offset + 0] = (color >> 16) & 0xff;       // r
-                            dpixelsLayer2_ar[offset + 3] = SDL_ALPHA_OPAQUE;			 // a
-                            continue;
-                        } else {
-                            dpixelsLayer2_ar[offset + 0] = 0;        // b
-                            dpixelsLayer2_ar[offset + 1] = 0;        // g
-                            dpixelsLayer2_ar[offset + 2] = 0;        // r
-                            dpixelsLayer2_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a
-                            continue;
+        }
+        EASY_END_BLOCK;
+    }));
+
+    //void* vdpixelsLayer2_ar = textureLayer2->data;
+    //unsigned char* dpixelsLayer2_ar = (unsigned char*)vdpixelsLayer2_ar;
+    unsigned char* dpixelsLayer2_ar = pixelsLayer2_ar;
+    results.push_back(updateDirtyPool->push([&](int id) {
+        EASY_BLOCK("layer2Dirty");
+        for(auto& r : layer2DirtyRects) {
+            for(int y = r.y; y < r.y + r.h; y++) {
+                for(int x = r.x; x < r.x + r.w; x++) {
+                    const unsigned int i = x + y * world->width;
+                    const unsigned int offset = i * 4;
+                    if(world->layer2Dirty[i]) {
+                        hadLayer2Dirty = true;
+                        if(world->layer2[i].mat->physicsType == PhysicsType::AIR) {
+                            if(Settings::draw_background_grid) {
+                                Uint32 color = ((i) % 2) == 0 ? 0x888888 : 0x444444;
+                                dpixelsLayer2_ar[offset + 2] = (color >> 0) & 0xff;        // b
+                                dpixelsLayer2_ar[offset + 1] = (color >> 8) & 0xff;        // g
+                                dpixelsLayer2_ar[offset + 0] = (color >> 16) & 0xff;       // r
+                                dpixelsLayer2_ar[offset + 3] = SDL_ALPHA_OPAQUE;			 // a
+                                continue;
+                            } else {
+                                dpixelsLayer2_ar[offset + 0] = 0;        // b
+                                dpixelsLayer2_ar[offset + 1] = 0;        // g
+                                dpixelsLayer2_ar[offset + 2] = 0;        // r
+                                dpixelsLayer2_ar[offset + 3] = SDL_ALPHA_TRANSPARENT;    // a
+                                continue;
+                            }
                         }
+                        Uint32 color = world->layer2[i].color;
+                        dpixelsLayer2_ar[offset + 2] = (color >> 0) & 0xff;        // b
+                        dpixelsLayer2_ar[offset + 1] = (color >> 8) & 0xff;        // g
+                        dpixelsLayer2_ar[offset + 0] = (color >> 16) & 0xff;        // r
+                        dpixelsLayer2_ar[offset + 3] = world->layer2[i].mat->alpha;    // a
                     }
-                    Uint32 color = world->layer2[i].color;
-                    dpixelsLayer2_ar[offset + 2] = (color >> 0) & 0xff;        // b
-                    dpixelsLayer2_ar[offset + 1] = (color >> 8) & 0xff;        // g
-                    dpixelsLayer2_ar[offset + 0] = (color >> 16) & 0xff;        // r
-                    dpixelsLayer2_ar[offset + 3] = world->layer2[i].mat->alpha;    // a
                 }
+                memset(&world->layer2Dirty[r.x + y * world->width], false, r.w);
             }
-            EASY_END_BLOCK;
-        }));
-
-        //void* vdpixelsBackground_ar = textureBackground->data;
-        //unsigned char* dpixelsBackground_ar = (unsigned char*)vdpixelsBackground_ar;
-        unsigned char* dpixelsBackground_ar = pixelsBackground_ar;
-        results.push_back(updateDirtyPool->push([&](int id) {
-            EASY_BLOCK("backgroundDirty");
-            for(int i = 0; i < world->width * world->height; i++) {
-                /*for (int x = 0; x < world->width; x++) {
-                    for (int y = 0; y < world->height; y++) {*/
-                    //const unsigned int i = x + y * world->width;
-                const unsigned int offset = i * 4;
-
-                if(world->backgroundDirty[i]) {
-                    hadBackgroundDirty = true;
-                    Uint32 color = world->background[i];
-                    dpixelsBackground_ar[offset + 2] = (color >> 0) & 0xff;        // b
-                    dpixelsBackground_ar[offset + 1] = (color >> 8) & 0xff;        // g
-                    dpixelsBackground_ar[offset + 0] = (color >> 16) & 0xff;       // r
-                    dpixelsBackground_ar[offset + 3] = (color >> 24) & 0xff;       // a
+        }
+        EASY_END_BLOCK;
+    }));
+
+    //void* vdpixelsBackground_ar = textureBackground->data;
+    //unsigned char* dpixelsBackground_ar = (unsigned char*)vdpixelsBackground_ar;
+    unsigned char* dpixelsBackground_ar = pixelsBackground_ar;
+    results.push_back(updateDirtyPool->push([&](int id) {
+        EASY_BLOCK("backgroundDirty");
+        for(auto& r : backgroundDirtyRects) {
+            for(int y = r.y; y < r.y + r.h; y++) {
+                for(int x = r.x; x < r.x + r.w; x++) {
+                    const unsigned int i = x + y * world->width;
+                    const unsigned int offset = i * 4;
+
+                    if(world->backgroundDirty[i]) {
+                        hadBackgroundDirty = true;
+                        Uint32 color = world->background[i];
+                        dpixelsBackground_ar[offset + 2] = (color >> 0) & 0xff;        // b
+                        dpixelsBackground_ar[offset + 1] = (color >> 8) & 0xff;        // g
+                        dpixelsBackground_ar[offset + 0] = (color >> 16) & 0xff;       // r
+                        dpixelsBackground_ar[offset + 3] = (color >> 24) & 0xff;       // a
+                    }
                 }
-
-                //}
-            }
-            EASY_END_BLOCK;
-        }));
-
-        EASY_BLOCK("objectDelete");
-        for(int i = 0; i < world->width * world->height; i++) {
-            /*for (int x = 0; x < world->width; x++) {
-                for (int y = 0; y < world->height; y++) {*/
-                //const unsigned int i = x + y * world->width;
-            const unsigned int offset = i * 4;
-
-            if(objectDelete[i]) {
-                world->tiles[i] = Tiles::NOTHING;
+                memset(&world->backgroundDirty[r.x + y * world->width], false, r.w);
             }
         }
         EASY_END_BLOCK;
+    }));
+
+    EASY_BLOCK("objectDelete");
+    for(int i = 0; i < world->width * world->height; i++) {
+        /*for (int x = 0; x < world->width; x++) {
+            for (int y = 0; y < world->height; y++) {*/
+            //const unsigned int i = x + y * world->width;
+        const unsigned int offset = i * 4;
+
+        if(objectDelete[i]) {
+            world->tiles[i] = Tiles::NOTHING;
+            // something may have been resting on the object
+            world->markActive(i % world->width, i / world->width);
+        }
+    }
+    EASY_END_BLOCK;
 
-        //results.push_back(updateDirtyPool->push([&](int id) {
+    //results.push_back(updateDirtyPool->push([&](int id) {
 
-        //}));
-        EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
-        for(int i = 0; i < results.size(); i++) {
-            results[i].get();
-        }
-        EASY_END_BLOCK;
+    //}));
+    EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
+    for(int i = 0; i < results.size(); i++) {
+        results[i].get();
+    }
+    EASY_END_BLOCK;
 
-        updateMaterialSounds();
+    // the objects are out of the grid again
+    if(world->tickFinishPending) world->tickFinish();
 
-        EASY_BLOCK("particle GPU_UpdateImageBytes");
-        GPU_UpdateImageBytes(
-            textureParticles,
-            NULL,
-            &pixelsParticles_ar[0],
-            world->width * 4
-        );
-        EASY_END_BLOCK; // GPU_UpdateImageBytes
+    updateMaterialSounds();
 
-        EASY_BLOCK("dirty memset");
-        if(hadDirty)		   memset(world->dirty, false, (size_t)world->width * world->height);
-        if(hadLayer2Dirty)	   memset(world->layer2Dirty, false, (size_t)world->width * world->height);
-        if(hadBackgroundDirty) memset(world->backgroundDirty, false, (size_t)world->width * world->height);
-        EASY_END_BLOCK;
+    EASY_BLOCK("particle GPU_UpdateImageBytes");
+    GPU_UpdateImageBytes(
+        textureParticles,
+        NULL,
+        &pixelsParticles_ar[0],
+        world->width * 4
+    );
+    EASY_END_BLOCK; // GPU_UpdateImageBytes
 
-        EASY_END_BLOCK; // post World::tick
-        #pragma endregion
+    EASY_END_BLOCK; // post World::tick
+    #pragma endregion
 
-        if(Settings::tick_temperature && tickTime % 4 == 2) {
-            world->tickTemperature();
-        }
-        if(Settings::draw_temperature_map && tickTime % 4 == 0) {
-            renderTemperatureMap(world);
-        }
+    if(Settings::tick_temperature) {
+        world->tickTemperature();
+    }
+    if(Settings::draw_temperature_map && tickTime % 4 == 0) {
+        renderTemperatureMap(world);
+    }
 
-        EASY_BLOCK("GPU_UpdateImageBytes", GPU_PROFILER_COLOR);
+    EASY_BLOCK("GPU_UpdateImageBytes", GPU_PROFILER_COLOR);
+    if(fullTextureUpload) {
+        // everything moved (see tickChunkLoading)
+        GPU_UpdateImageBytes(texture, NULL, &pixels[0], world->width * 4);
+        GPU_UpdateImageBytes(emissionTexture, NULL, &pixelsEmission[0], world->width * 4);
+        GPU_UpdateImageBytes(textureLayer2, NULL, &pixelsLayer2[0], world->width * 4);
+        GPU_UpdateImageBytes(textureBackground, NULL, &pixelsBackground[0], world->width * 4);
+        GPU_UpdateImageBytes(textureFlow, NULL, &pixelsFlow[0], world->width * 4);
+        GPU_UpdateImageBytes(textureFire, NULL, &pixelsFire[0], world->width * 4);
+        waterFlowPassShader->dirty = true;
+        fullTextureUpload = false;
+    } else {
         if(hadDirty) {
-            GPU_UpdateImageBytes(
-                texture,
-                NULL,
-                &pixels[0],
-                world->width * 4
-            );
-
-            GPU_UpdateImageBytes(
-                emissionTexture,
-                NULL,
-                &pixelsEmission[0],
-                world->width * 4
-            );
+            updateImageRects(texture, pixels_ar, dirtyRects);
+            updateImageRects(emissionTexture, pixelsEmission_ar, dirtyRects);
         }
 
         if(hadLayer2Dirty) {
-            GPU_UpdateImageBytes(
-                textureLayer2,
-                NULL,
-                &pixelsLayer2[0],
-                world->width * 4
-            );
+            updateImageRects(textureLayer2, pixelsLayer2_ar, layer2DirtyRects);
         }
 
         if(hadBackgroundDirty) {
-            GPU_UpdateImageBytes(
-                textureBackground,
-                NULL,
-                &pixelsBackground[0],
-                world->width * 4
-            );
+            updateImageRects(textureBackground, pixelsBackground_ar, backgroundDirtyRects);
         }
 
         if(hadFlow) {
-            GPU_UpdateImageBytes(
-                textureFlow,
-                NULL,
-                &pixelsFlow[0],
-                world->width * 4
-            );
-
+            updateImageRects(textureFlow, pixelsFlow_ar, dirtyRects);
             waterFlowPassShader->dirty = true;
         }
 
         if(hadFire) {
-            GPU_UpdateImageBytes(
-                textureFire,
-                NULL,
-                &pixelsFire[0],
-                world->width * 4
-            );
-        }
-
-        if(Settings::draw_temperature_map) {
-            GPU_UpdateImageBytes(
-                temperatureMap,
-                NULL,
-                &pixelsTemp[0],
-                world->width * 4
-            );
+            updateImageRects(textureFire, pixelsFire_ar, dirtyRects);
         }
+    }
 
-        /*GPU_UpdateImageBytes(
-            textureObjects,
+    if(Settings::draw_temperature_map) {
+        GPU_UpdateImageBytes(
+            temperatureMap,
             NULL,
-            &pixelsObjects[0],
+            &pixelsTemp[0],
             world->width * 4
-        );*/
-        EASY_END_BLOCK;
+        );
+    }
 
-        if(Settings::tick_box2d && tickTime % 4 == 0) world->updateWorldMesh();
+    /*GPU_UpdateImageBytes(
+        textureObjects,
+        NULL,
+        &pixelsObjects[0],
+        world->width * 4
+    );*/
+    EASY_END_BLOCK;
 
-        EASY_END_BLOCK;
+    if(Settings::tick_box2d && tickTime % 4 == 0) world->updateWorldMesh();
+}
+
+void Game::updateImageRects(GPU_Image* img, unsigned char* pix, std::vector<SDL_Rect>& rects) {
+    for(auto& r : rects) {
+        GPU_Rect gr = {(float)r.x, (float)r.y, (float)r.w, (float)r.h};
+        GPU_UpdateImageBytes(img, &gr, &pix[(r.x + r.y * world->width) * 4], world->width * 4);
     }
 }
 
@@ -2901,9 +3026,14 @@ void Game::tickChunkLoading() {
         memset(world->dirty, false, (size_t)world->width * world->height);
         memset(world->layer2Dirty, false, (size_t)world->width * world->height);
         memset(world->backgroundDirty, false, (size_t)world->width * world->height);
+        memset(world->dirtyTiles, false, (size_t)world->dirtyTilesW * world->dirtyTilesH);
+        memset(world->layer2DirtyTiles, false, (size_t)world->dirtyTilesW * world->dirtyTilesH);
+        memset(world->backgroundDirtyTiles, false, (size_t)world->dirtyTilesW * world->dirtyTilesH);
         EASY_END_BLOCK;
 
         EASY_BLOCK("loop");
+        int shiftX = 0;
+        int shiftY = 0;
         while((abs(accLoadX) > CHUNK_W / 2 || abs(accLoadY) > CHUNK_H / 2)) {
             int subX = std::fmax(std::fmin(accLoadX, CHUNK_W / 2), -CHUNK_W / 2);
             if(abs(subX) < CHUNK_W / 2) subX = 0;
@@ -2913,107 +3043,8 @@ void Game::tickChunkLoading() {
             world->loadZone.x += subX;
             world->loadZone.y += subY;
 
-            int delta = 4 * (subX + subY * world->width);
-            EASY_BLOCK("rotate");
-            std::vector<std::future<void>> results = {};
-            if(delta > 0) {
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixels_ar[0]), &(pixels_ar[world->width * world->height * 4]) - delta, &(pixels_ar[world->width * world->height * 4]));
-                    //rotate(pixels.begin(), pixels.end() - delta, pixels.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsLayer2_ar[0]), &(pixelsLayer2_ar[world->width * world->height * 4]) - delta, &(pixelsLayer2_ar[world->width * world->height * 4]));
-                    //rotate(pixelsLayer2.begin(), pixelsLayer2.end() - delta, pixelsLayer2.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsBackground_ar[0]), &(pixelsBackground_ar[world->width * world->height * 4]) - delta, &(pixelsBackground_ar[world->width * world->height * 4]));
-                    //rotate(pixelsBackground.begin(), pixelsBackground.end() - delta, pixelsBackground.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsFire_ar[0]), &(pixelsFire_ar[world->width * world->height * 4]) - delta, &(pixelsFire_ar[world->width * world->height * 4]));
-                    //rotate(pixelsFire_ar.begin(), pixelsFire_ar.end() - delta, pixelsFire_ar.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsFlow_ar[0]), &(pixelsFlow_ar[world->width * world->height * 4]) - delta, &(pixelsFlow_ar[world->width * world->height * 4]));
-                    //rotate(pixelsFlow_ar.begin(), pixelsFlow_ar.end() - delta, pixelsFlow_ar.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsEmission_ar[0]), &(pixelsEmission_ar[world->width * world->height * 4]) - delta, &(pixelsEmission_ar[world->width * world->height * 4]));
-                    //rotate(pixelsEmission_ar.begin(), pixelsEmission_ar.end() - delta, pixelsEmission_ar.end());
-                }));
-            } else if(delta < 0) {
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixels_ar[0]), &(pixels_ar[0]) - delta, &(pixels_ar[world->width * world->height * 4]));
-                    //rotate(pixels.begin(), pixels.begin() - delta, pixels.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsLayer2_ar[0]), &(pixelsLayer2_ar[0]) - delta, &(pixelsLayer2_ar[world->width * world->height * 4]));
-                    //rotate(pixelsLayer2.begin(), pixelsLayer2.begin() - delta, pixelsLayer2.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsBackground_ar[0]), &(pixelsBackground_ar[0]) - delta, &(pixelsBackground_ar[world->width * world->height * 4]));
-                    //rotate(pixelsBackground.begin(), pixelsBackground.begin() - delta, pixelsBackground.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsFire_ar[0]), &(pixelsFire_ar[0]) - delta, &(pixelsFire_ar[world->width * world->height * 4]));
-                    //rotate(pixelsFire_ar.begin(), pixelsFire_ar.begin() - delta, pixelsFire_ar.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsFlow_ar[0]), &(pixelsFlow_ar[0]) - delta, &(pixelsFlow_ar[world->width * world->height * 4]));
-                    //rotate(pixelsFlow_ar.begin(), pixelsFlow_ar.begin() - delta, pixelsFlow_ar.end());
-                }));
-                results.push_back(updateDirtyPool->push([&](int id) {
-                    rotate(&(pixelsEmission_ar[0]), &(pixelsEmission_ar[0]) - delta, &(pixelsEmission_ar[world->width * world->height * 4]));
-                    //rotate(pixelsEmission_ar.begin(), pixelsEmission_ar.begin() - delta, pixelsEmission_ar.end());
-                }));
-            }
-            EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
-            for(auto& v : results) {
-                v.get();
-            }
-            EASY_END_BLOCK; // wait for threads
-
-            EASY_END_BLOCK; // rotate
-
-            #define CLEARPIXEL(pixels, ofs) \
-pixels[ofs + 0] = pixels[ofs + 1] = pixels[ofs + 2] = 0xff; \
-pixels[ofs + 3] = SDL_ALPHA_TRANSPARENT;
-
-            EASY_BLOCK("CLEARPIXEL X");
-            for(int x = 0; x < abs(subX); x++) {
-                for(int y = 0; y < world->height; y++) {
-                    const unsigned int offset = (world->width * 4 * y) + x * 4;
-                    if(offset < world->width * world->height * 4) {
-                        CLEARPIXEL(pixels_ar, offset);
-                        CLEARPIXEL(pixelsLayer2_ar, offset);
-                        CLEARPIXEL(pixelsObjects_ar, offset);
-                        CLEARPIXEL(pixelsBackground_ar, offset);
-                        CLEARPIXEL(pixelsFire_ar, offset);
-                        CLEARPIXEL(pixelsFlow_ar, offset);
-                        CLEARPIXEL(pixelsEmission_ar, offset);
-                    }
-                }
-            }
-            EASY_END_BLOCK;
-
-            EASY_BLOCK("CLEARPIXEL Y");
-            for(int y = 0; y < abs(subY); y++) {
-                for(int x = 0; x < world->width; x++) {
-                    const unsigned int offset = (world->width * 4 * y) + x * 4;
-                    if(offset < world->width * world->height * 4) {
-                        CLEARPIXEL(pixels_ar, offset);
-                        CLEARPIXEL(pixelsLayer2_ar, offset);
-                        CLEARPIXEL(pixelsObjects_ar, offset);
-                        CLEARPIXEL(pixelsBackground_ar, offset);
-                        CLEARPIXEL(pixelsFire_ar, offset);
-                        CLEARPIXEL(pixelsFlow_ar, offset);
-                        CLEARPIXEL(pixelsEmission_ar, offset);
-                    }
-                }
-            }
-            EASY_END_BLOCK;
-
-            #undef CLEARPIXEL
+            shiftX += subX;
+            shiftY += subY;
 
             accLoadX -= subX;
             accLoadY -= subY;
@@ -3024,11 +3055,47 @@ pixels[ofs + 3] = SDL_ALPHA_TRANSPARENT;
 
         EASY_END_BLOCK;
 
+        // move the pixels with the world (one pass for the whole move instead of one per step)
+        EASY_BLOCK("shift");
+        std::vector<std::future<void>> results = {};
+        for(unsigned char* pix : {pixels_ar, pixelsLayer2_ar, pixelsBackground_ar, pixelsFire_ar, pixelsFlow_ar, pixelsEmission_ar}) {
+            results.push_back(updateDirtyPool->push([&, pix](int id) {
+                World::shiftGrid(pix, 4, world->width, world->height, shiftX, shiftY);
+            }));
+        }
+        EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
+        for(auto& v : results) {
+            v.get();
+        }
+        EASY_END_BLOCK; // wait for threads
+        EASY_END_BLOCK; // shift
+
+        // only the newly exposed strips need to be cleared
+        EASY_BLOCK("clear exposed");
+        auto clearRect = [&](int x0, int y0, int x1, int y1) {
+            x0 = std::max(x0, 0);
+            y0 = std::max(y0, 0);
+            x1 = std::min(x1, (int)world->width);
+            y1 = std::min(y1, (int)world->height);
+            for(int y = y0; y < y1; y++) {
+                for(int x = x0; x < x1; x++) {
+                    const unsigned int offset = (world->width * 4 * y) + x * 4;
+                    for(unsigned char* pix : {pixels_ar, pixelsLayer2_ar, pixelsObjects_ar, pixelsBackground_ar, pixelsFire_ar, pixelsFlow_ar, pixelsEmission_ar}) {
+                        pix[offset + 0] = pix[offset + 1] = pix[offset + 2] = 0xff;
+                        pix[offset + 3] = SDL_ALPHA_TRANSPARENT;
+                    }
+                }
+            }
+        };
+        if(shiftX > 0) clearRect(0, 0, shiftX, world->height);
+        if(shiftX < 0) clearRect(world->width + shiftX, 0, world->width, world->height);
+        if(shiftY > 0) clearRect(0, 0, world->width, shiftY);
+        if(shiftY < 0) clearRect(0, world->height + shiftY, world->width, world->height);
+        EASY_END_BLOCK;
+
         world->tickChunks();
         world->updateWorldMesh();
-        world->dirty[0] = true;
-        world->layer2Dirty[0] = true;
-        world->backgroundDirty[0] = true;
+        fullTextureUpload = true;
 
     } else {
         world->frame();
@@ -3051,9 +3118,9 @@ void Game::tickPlayer() {
         if(Controls::PLAYER_UP->get() && !Controls::DEBUG_DRAW->get()) {
             audioEngine.SetEventParameter("event:/Player/Fly", "Intensity", 1);
             for(int i = 0; i < 4; i++) {
-                Particle* p = new Particle(Tiles::createLava(), (float)(world->player->x + world->loadZone.x + world->player->hw / 2 + rand() % 5 - 2 + world->player->vx), (float)(world->player->y + world->loadZone.y + world->player->hh + world->player->vy), (float)((rand() % 10 - 5) / 10.0f + world->player->vx / 2.0f), (float)((rand() % 10) / 10.0f + 1 + world->player->vy / 2.0f), 0, (float)0.025);
-                p->temporary = true;
-                p->lifetime = 120;
+                Particle p(Tiles::createLava(), (float)(world->player->x + world->loadZone.x + world->player->hw / 2 + RNG::local().next() % 5 - 2 + world->player->vx), (float)(world->player->y + world->loadZone.y + world->player->hh + world->player->vy), (float)((RNG::local().next() % 10 - 5) / 10.0f + world->player->vx / 2.0f), (float)((RNG::local().next() % 10) / 10.0f + 1 + world->player->vy / 2.0f), 0, (float)0.025);
+                p.temporary = true;
+                p.lifetime = 120;
                 world->addParticle(p);
             }
         } else {
@@ -3136,34 +3203,33 @@ void Game::tickPlayer() {
                         int y = sind == -1 ? wmy : sind / world->width;
 
                         std::function<void(MaterialInstance, int, int)> makeParticle = [&](MaterialInstance tile, int xPos, int yPos) {
-                            Particle* par = new Particle(tile, xPos, yPos, 0, 0, 0, (float)0.01f);
-                            par->vx = (rand() % 10 - 5) / 5.0f * 1.0f;
-                            par->vy = (rand() % 10 - 5) / 5.0f * 1.0f;
-                            par->ax = -par->vx / 10.0f;
-                            par->ay = -par->vy / 10.0f;
-                            if(par->ay == 0 && par->ax == 0) par->ay = 0.01f;
+                            Particle par(tile, xPos, yPos, 0, 0, 0, (float)0.01f);
+                            par.vx = (RNG::local().next() % 10 - 5) / 5.0f * 1.0f;
+                            par.vy = (RNG::local().next() % 10 - 5) / 5.0f * 1.0f;
+                            par.ax = -par.vx / 10.0f;
+                            par.ay = -par.vy / 10.0f;
+                            if(par.ay == 0 && par.ax == 0) par.ay = 0.01f;
 
-                            //par->targetX = world->player->x + world->player->hw / 2 + world->loadZone.x;
-                            //par->targetY = world->player->y + world->player->hh / 2 + world->loadZone.y;
-                            //par->targetForce = 0.35f;
+                            //par.targetX = world->player->x + world->player->hw / 2 + world->loadZone.x;
+                            //par.targetY = world->player->y + world->player->hh / 2 + world->loadZone.y;
+                            //par.targetForce = 0.35f;
 
-                            par->lifetime = 6;
+                            par.lifetime = 6;
 
-                            par->phase = true;
+                            par.phase = true;
 
-                            world->player->heldItem->vacuumParticles.push_back(par);
+                            ParticleHandle h = world->addParticle(par);
+                            world->player->heldItem->vacuumParticles.push_back(h);
 
-                            par->killCallback = [&]() {
+                            world->particles.setKillCallback(world->particles.indexOf(h), [this, h]() {
                                 auto& v = world->player->heldItem->vacuumParticles;
-                                v.erase(std::remove(v.begin(), v.end(), par), v.end());
-                            };
-
-                            world->addParticle(par);
+                                v.erase(std::remove(v.begin(), v.end(), h), v.end());
+                            });
                         };
 
                         int rad = 5;
                         int clipRadSq = rad * rad;
-                        clipRadSq += rand() % clipRadSq / 4;
+                        clipRadSq += RNG::local().next() % clipRadSq / 4;
                         for(int xx = -rad; xx <= rad; xx++) {
                             for(int yy = -rad; yy <= rad; yy++) {
                                 if(xx * xx + yy * yy > clipRadSq) continue;
@@ -3176,51 +3242,53 @@ void Game::tickPlayer() {
                                     makeParticle(tile, x + xx, y + yy);
                                     world->tiles[(x + xx) + (y + yy) * world->width] = Tiles::NOTHING;
                                     //world->tiles[(x + xx) + (y + yy) * world->width] = Tiles::createFire();
-                                    world->dirty[(x + xx) + (y + yy) * world->width] = true;
+                                    world->markDirty(x + xx, y + yy);
+                                    world->markActive(x + xx, y + yy);
                                 }
 
 
                             }
                         }
 
-                        world->particles.erase(std::remove_if(world->particles.begin(), world->particles.end(), [&](Particle* cur) {
-                            if(cur->targetForce == 0 && !cur->phase) {
+                        ParticleSystem& ps = world->particles;
+                        for(size_t i = 0; i < ps.size(); i++) {
+                            if(ps.targetForce[i] == 0 && !(ps.flags[i] & PARTICLE_PHASE)) {
                                 int rad = 5;
                                 for(int xx = -rad; xx <= rad; xx++) {
                                     for(int yy = -rad; yy <= rad; yy++) {
                                         if((yy == -rad || yy == rad) && (xx == -rad || x == rad)) continue;
 
-                                        if(((int)(cur->x) == (x + xx)) && ((int)(cur->y) == (y + yy))) {
+                                        if(((int)(ps.x[i]) == (x + xx)) && ((int)(ps.y[i]) == (y + yy))) {
 
-                                            cur->vx = (rand() % 10 - 5) / 5.0f * 1.0f;
-                                            cur->vy = (rand() % 10 - 5) / 5.0f * 1.0f;
-                                            cur->ax = -cur->vx / 10.0f;
-                                            cur->ay = -cur->vy / 10.0f;
-                                            if(cur->ay == 0 && cur->ax == 0) cur->ay = 0.01f;
+                                            ps.vx[i] = (RNG::local().next() % 10 - 5) / 5.0f * 1.0f;
+                                            ps.vy[i] = (RNG::local().next() % 10 - 5) / 5.0f * 1.0f;
+                                            ps.ax[i] = -ps.vx[i] / 10.0f;
+                                            ps.ay[i] = -ps.vy[i] / 10.0f;
+                                            if(ps.ay[i] == 0 && ps.ax[i] == 0) ps.ay[i] = 0.01f;
 
-                                            //par->targetX = world->player->x + world->player->hw / 2 + world->loadZone.x;
-                                            //par->targetY = world->player->y + world->player->hh / 2 + world->loadZone.y;
-                                            //par->targetForce = 0.35f;
+                                            //ps.targetX[i] = world->player->x + world->player->hw / 2 + world->loadZone.x;
+                                            //ps.targetY[i] = world->player->y + world->player->hh / 2 + world->loadZone.y;
+                                            //ps.targetForce[i] = 0.35f;
 
-                                            cur->lifetime = 6;
+                                            ps.lifetime[i] = 6;
 
-                                            cur->phase = true;
+                                            ps.flags[i] |= PARTICLE_PHASE;
 
-                                            world->player->heldItem->vacuumParticles.push_back(cur);
+                                            ParticleHandle h = ps.handleAt(i);
+                                            world->player->heldItem->vacuumParticles.push_back(h);
 
-                                            cur->killCallback = [&]() {
+                                            ps.setKillCallback(i, [this, h]() {
                                                 auto& v = world->player->heldItem->vacuumParticles;
-                                                v.erase(std::remove(v.begin(), v.end(), cur), v.end());
-                                            };
+                                                v.erase(std::remove(v.begin(), v.end(), h), v.end());
+                                            });
 
-                                            return false;
+                                            goto nextParticle;
                                         }
                                     }
                                 }
                             }
-
-                            return false;
-                        }), world->particles.end());
+                        nextParticle: {}
+                        }
 
                         vector<RigidBody*> rbs = world->rigidBodies;
 
@@ -3245,6 +3313,8 @@ void Game::tickPlayer() {
                                             Uint32 pixel = PIXEL(cur->surface, ntx, nty);
                                             if(((pixel >> 24) & 0xff) != 0x00) {
                                                 PIXEL(cur->surface, ntx, nty) = 0x00000000;
+                                                cur->tiles[ntx + nty * cur->matWidth] = Tiles::NOTHING;
+                                                cur->tilesVersion++;
                                                 upd = true;
 
                                                 makeParticle(MaterialInstance(&Materials::GENERIC_SOLID, pixel), (x + xx), (y + yy));
@@ -3268,23 +3338,26 @@ void Game::tickPlayer() {
                 }
 
                 if(world->player->heldItem->vacuumParticles.size() > 0) {
-                    world->player->heldItem->vacuumParticles.erase(std::remove_if(world->player->heldItem->vacuumParticles.begin(), world->player->heldItem->vacuumParticles.end(), [&](Particle* cur) {
-
-                        if(cur->lifetime <= 0) {
-                            cur->targetForce = 0.45f;
-                            cur->targetX = world->player->x + world->player->hw / 2.0f + world->loadZone.x;
-                            cur->targetY = world->player->y + world->player->hh / 2.0f + world->loadZone.y;
-                            cur->ax = 0;
-                            cur->ay = 0.01f;
+                    ParticleSystem& ps = world->particles;
+                    world->player->heldItem->vacuumParticles.erase(std::remove_if(world->player->heldItem->vacuumParticles.begin(), world->player->heldItem->vacuumParticles.end(), [&](ParticleHandle h) {
+                        int i = ps.indexOf(h);
+                        if(i == -1) return true;
+
+                        if(ps.lifetime[i] <= 0) {
+                            ps.targetForce[i] = 0.45f;
+                            ps.targetX[i] = world->player->x + world->player->hw / 2.0f + world->loadZone.x;
+                            ps.targetY[i] = world->player->y + world->player->hh / 2.0f + world->loadZone.y;
+                            ps.ax[i] = 0;
+                            ps.ay[i] = 0.01f;
                         }
 
-                        float tdx = cur->targetX - cur->x;
-                        float tdy = cur->targetY - cur->y;
+                        float tdx = ps.targetX[i] - ps.x[i];
+                        float tdy = ps.targetY[i] - ps.y[i];
 
                         if(tdx * tdx + tdy * tdy < 10 * 10) {
-                            cur->temporary = true;
-                            cur->lifetime = 0;
-                            //logDebug("vacuum {}", cur->tile.mat->name.c_str());
+                            ps.flags[i] |= PARTICLE_TEMPORARY;
+                            ps.lifetime[i] = 0;
+                            //logDebug("vacuum {}", ps.tile[i].mat->name.c_str());
                             return true;
                         }
 
@@ -3466,6 +3539,8 @@ void Game::renderEarly() {
 
                             GPU_Line(textureEntitiesLQ->target, world->player->hammerX + dx, world->player->hammerY + dy, world->player->hammerX, world->player->hammerY, {0xff, 0xff, 0x00, 0xff});
                         } else {
+                            // reads the tiles, which World::tick may be writing on the sim thread right now
+                            syncWorld();
                             int startInd = getAimSolidSurface(64);
 
                             if(startInd != -1) {
@@ -3800,6 +3875,18 @@ void Game::renderOverlays() {
         EASY_END_BLOCK; // draw load zones
     }
 
+    if(Settings::draw_active_rects) {
+        EASY_BLOCK("draw active rects", RENDER_PROFILER_COLOR);
+        const std::vector<SDL_Rect>& active = world->snapshot().active;
+        for(size_t i = 0; i < active.size(); i++) {
+            SDL_Rect a = active[i];
+            if(a.w <= 0 || a.h <= 0) continue;
+            GPU_Rect r = GPU_Rect {(float)(ofsX + camX + a.x * scale), (float)(ofsY + camY + a.y * scale), (float)(a.w * scale), (float)(a.h * scale)};
+            GPU_Rectangle2(target, r, {0xff, 0xff, 0x00, 0xff});
+        }
+        EASY_END_BLOCK; // draw active rects
+    }
+
     if(Settings::draw_physics_debug) {
         //EASY_BLOCK("draw physics meshes", RENDER_PROFILER_COLOR);
         //for(size_t i = 0; i < world->rigidBodies.size(); i++) {
@@ -4038,7 +4125,7 @@ void Game::renderOverlays() {
         buffAsStdStr1 = buff1;
         Drawing::drawTextBG(target, buffAsStdStr1.c_str(), font16, 4, 2 + (lineHeight * dbgIndex++), 0xff, 0xff, 0xff, {0x00, 0x00, 0x00, 0x40}, ALIGN_LEFT);
         
-        snprintf(buff1, sizeof(buff1), "Particles: %d", (int)world->particles.size());
+        snprintf(buff1, sizeof(buff1), "Particles: %d", (int)world->snapshot().particles);
         buffAsStdStr1 = buff1;
         Drawing::drawTextBG(target, buffAsStdStr1.c_str(), font16, 4, 2 + (lineHeight * dbgIndex++), 0xff, 0xff, 0xff, {0x00, 0x00, 0x00, 0x40}, ALIGN_LEFT);
 
@@ -4288,6 +4375,10 @@ void Game::quitToMainMenu() {
     stateAfterLoad = MAIN_MENU;
 
     EASY_BLOCK("Close world");
+    syncWorld();
+    EASY_BLOCK("flush chunk writes");
+    world->chunkWriter->flush();
+    EASY_END_BLOCK;
     delete world;
     world = nullptr;
     EASY_END_BLOCK;
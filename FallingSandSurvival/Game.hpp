@@ -194,12 +194,25 @@ public:
     vector< unsigned char > pixelsTemp;
     unsigned char* pixelsTemp_ar = nullptr;
 
+    // rects (from World::takeDirtyRects) that were repacked this tick, only these get uploaded
+    std::vector<SDL_Rect> dirtyRects;
+    std::vector<SDL_Rect> layer2DirtyRects;
+    std::vector<SDL_Rect> backgroundDirtyRects;
+    // set when the pixel buffers were shifted, so the whole textures have to be uploaded
+    bool fullTextureUpload = false;
+    void updateImageRects(GPU_Image* img, unsigned char* pix, std::vector<SDL_Rect>& rects);
+
     b2DebugDraw_impl* b2DebugDraw;
 
     int ent_prevLoadZoneX = 0;
     int ent_prevLoadZoneY = 0;
     ctpl::thread_pool* updateDirtyPool = nullptr;
     ctpl::thread_pool* rotateVectorsPool = nullptr;
+    // World::tick runs here when Settings::tick_world_async is on, while the frame renders from the pixel buffers/textures
+    ctpl::thread_pool* simPool = nullptr;
+    std::future<void> simTick;
+    // the tick that started simTick still has to do tickLate (see syncWorld)
+    bool tickLatePending = false;
 
     uint16_t* movingTiles;
     void updateMaterialSounds();
@@ -270,6 +283,9 @@ public:
 
     void updateFrameEarly();
     void tick();
+    // waits for the World::tick running on simPool and finishes the tick that started it, call before anything but rendering touches the world
+    void syncWorld();
+    void tickLate();
     void tickChunkLoading();
     void tickPlayer();
     void updateFrameLate();
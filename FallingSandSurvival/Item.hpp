@@ -47,7 +47,7 @@ public:
     std::vector<UInt16Point> fill;
     uint16_t capacity = 0;
 
-    std::vector<Particle*> vacuumParticles;
+    std::vector<ParticleHandle> vacuumParticles;
 
     Item();
     ~Item();
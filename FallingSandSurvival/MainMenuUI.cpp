@@ -227,6 +227,7 @@ void MainMenuUI::DrawSingleplayer(Game* game) {
                 game->stateAfterLoad = INGAME;
 
                 EASY_BLOCK("Close world");
+                game->syncWorld();
                 delete game->world;
                 game->world = nullptr;
                 EASY_END_BLOCK;
@@ -2,6 +2,10 @@
 #include "Particle.hpp"
 #include <iostream>
 
+#define BUILD_WITH_EASY_PROFILER
+#include <easy/profiler.h>
+#include "ProfilerConfig.hpp"
+
 Particle::Particle(MaterialInstance tile, float x, float y, float vx, float vy, float ax, float ay) {
     this->tile = tile;
     this->x = x;
@@ -12,12 +16,195 @@ Particle::Particle(MaterialInstance tile, float x, float y, float vx, float vy,
     this->ay = ay;
 }
 
-Particle::Particle(const Particle & part) {
-    tile = part.tile;
-    x = part.x;
-    y = part.y;
-    vx = part.vx;
-    vy = part.vy;
-    ax = part.ax;
-    ay = part.ay;
+ParticleHandle ParticleSystem::add(const Particle& p) {
+    uint32_t slot;
+    if(freeSlots.empty()) {
+        slot = (uint32_t)slotIndex.size();
+        slotIndex.push_back(0);
+        slotGeneration.push_back(0);
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    ParticleHandle h = slot | ((uint32_t)slotGeneration[slot] << PARTICLE_SLOT_BITS);
+    slotIndex[slot] = (uint32_t)size();
+    handles.push_back(h);
+
+    x.push_back(p.x);
+    y.push_back(p.y);
+    vx.push_back(p.vx);
+    vy.push_back(p.vy);
+    ax.push_back(p.ax);
+    ay.push_back(p.ay);
+    flags.push_back((p.phase ? PARTICLE_PHASE : 0) | (p.temporary ? PARTICLE_TEMPORARY : 0));
+    lifetime.push_back(p.lifetime);
+    targetX.push_back(p.targetX);
+    targetY.push_back(p.targetY);
+    targetForce.push_back(p.targetForce);
+    fadeTime.push_back(p.fadeTime);
+    inObjectState.push_back((Uint8)p.inObjectState);
+    tile.push_back(p.tile);
+
+    return h;
+}
+
+int ParticleSystem::indexOf(ParticleHandle h) const {
+    uint32_t slot = h & PARTICLE_SLOT_MASK;
+    if(slot >= slotIndex.size()) return -1;
+    if(slotGeneration[slot] != (Uint8)(h >> PARTICLE_SLOT_BITS)) return -1;
+    int i = (int)slotIndex[slot];
+    if(flags[i] & PARTICLE_DEAD) return -1;
+    return i;
+}
+
+void ParticleSystem::setKillCallback(int i, std::function<void()> callback) {
+    killCallbacks[handles[i] & PARTICLE_SLOT_MASK] = callback;
+}
+
+void ParticleSystem::integrate(int w, int h, const SDL_Rect& zone) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    size_t n = size();
+    float* px = x.data();
+    float* py = y.data();
+    float* pvx = vx.data();
+    float* pvy = vy.data();
+    const float* pax = ax.data();
+    const float* pay = ay.data();
+    const float* ptf = targetForce.data();
+    Uint8* pflags = flags.data();
+    const int* plife = lifetime.data();
+
+    for(size_t i = 0; i < n; i++) {
+        if((pflags[i] & PARTICLE_TEMPORARY) && plife[i] <= 0) {
+            pflags[i] |= PARTICLE_DEAD;
+            continue;
+        }
+
+        if(ptf[i] != 0) {
+            float tdx = targetX[i] - px[i];
+            float tdy = targetY[i] - py[i];
+            float normFac = sqrtf(tdx * tdx + tdy * tdy);
+
+            pvx[i] += tdx / normFac * ptf[i];
+            pvy[i] += tdy / normFac * ptf[i];
+
+            if(normFac < 100) {
+                pvx[i] *= 0.95f;
+                pvy[i] *= 0.95f;
+            }
+        }
+
+        if(px[i] < 0 || (int)px[i] >= w || py[i] < 0 || (int)py[i] >= h) {
+            pflags[i] |= PARTICLE_DEAD;
+            continue;
+        }
+
+        int lx = (int)px[i];
+        int ly = (int)py[i];
+        if(lx >= zone.x && ly >= zone.y && lx < zone.x + zone.w && ly < zone.y + zone.h) {
+            pvx[i] += pax[i];
+            pvy[i] += pay[i];
+        }
+    }
+}
+
+void ParticleSystem::compact() {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    size_t i = 0;
+    while(i < size()) {
+        if(!(flags[i] & PARTICLE_DEAD)) {
+            i++;
+            continue;
+        }
+
+        uint32_t slot = handles[i] & PARTICLE_SLOT_MASK;
+        auto cb = killCallbacks.find(slot);
+        if(cb != killCallbacks.end()) {
+            pendingCallbacks.push_back(std::move(cb->second));
+            killCallbacks.erase(cb);
+        }
+        slotGeneration[slot]++;
+        freeSlots.push_back(slot);
+
+        size_t last = size() - 1;
+        if(i != last) moveParticle(last, i);
+        popBack();
+    }
+
+    // after everything is packed again so the callbacks see a consistent system
+    for(auto& cb : pendingCallbacks) cb();
+    pendingCallbacks.clear();
+}
+
+void ParticleSystem::translate(float dx, float dy) {
+    size_t n = size();
+    for(size_t i = 0; i < n; i++) {
+        x[i] += dx;
+        y[i] += dy;
+    }
+}
+
+void ParticleSystem::clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    ax.clear();
+    ay.clear();
+    flags.clear();
+    lifetime.clear();
+    targetX.clear();
+    targetY.clear();
+    targetForce.clear();
+    fadeTime.clear();
+    inObjectState.clear();
+    tile.clear();
+
+    // bump every slot so old handles don't resolve to new particles
+    for(auto& g : slotGeneration) g++;
+    handles.clear();
+    freeSlots.clear();
+    for(uint32_t s = 0; s < slotIndex.size(); s++) freeSlots.push_back(s);
+    killCallbacks.clear();
+}
+
+void ParticleSystem::moveParticle(size_t from, size_t to) {
+    x[to] = x[from];
+    y[to] = y[from];
+    vx[to] = vx[from];
+    vy[to] = vy[from];
+    ax[to] = ax[from];
+    ay[to] = ay[from];
+    flags[to] = flags[from];
+    lifetime[to] = lifetime[from];
+    targetX[to] = targetX[from];
+    targetY[to] = targetY[from];
+    targetForce[to] = targetForce[from];
+    fadeTime[to] = fadeTime[from];
+    inObjectState[to] = inObjectState[from];
+    tile[to] = tile[from];
+
+    handles[to] = handles[from];
+    slotIndex[handles[to] & PARTICLE_SLOT_MASK] = (uint32_t)to;
+}
+
+void ParticleSystem::popBack() {
+    x.pop_back();
+    y.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    ax.pop_back();
+    ay.pop_back();
+    flags.pop_back();
+    lifetime.pop_back();
+    targetX.pop_back();
+    targetY.pop_back();
+    targetForce.pop_back();
+    fadeTime.pop_back();
+    inObjectState.pop_back();
+    tile.pop_back();
+    handles.pop_back();
 }
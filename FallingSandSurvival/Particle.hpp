@@ -7,7 +7,10 @@
 #endif // !INC_Tiles
 
 #include <functional>
+#include <vector>
+#include <unordered_map>
 
+// describes one particle to be added to a ParticleSystem (which stores them as SoA)
 class Particle {
 public:
     MaterialInstance tile {};
@@ -25,7 +28,76 @@ public:
     int lifetime = 0;
     int fadeTime = 60;
     unsigned short inObjectState = 0;
-    std::function<void()> killCallback = []() {};
     Particle(MaterialInstance tile, float x, float y, float vx, float vy, float ax, float ay);
-    Particle(const Particle &part);
+};
+
+// refers to one particle in a ParticleSystem even after others are removed
+// low bits are the slot, high bits are the slot's generation so handles to dead particles stop resolving
+typedef uint32_t ParticleHandle;
+#define PARTICLE_SLOT_BITS 24
+#define PARTICLE_SLOT_MASK ((1u << PARTICLE_SLOT_BITS) - 1)
+
+#define PARTICLE_PHASE     0x1 // doesn't collide with tiles
+#define PARTICLE_TEMPORARY 0x2 // dies when its lifetime runs out
+#define PARTICLE_DEAD      0x4 // removed by the next compact()
+
+// all of a world's particles, stored as SoA and kept packed
+// dead particles are swap-removed by compact(), so indices only stay valid until then (use handles to keep track of one)
+class ParticleSystem {
+public:
+    // used by every particle every tick
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> ax;
+    std::vector<float> ay;
+    std::vector<Uint8> flags;
+    std::vector<int> lifetime;
+
+    // only some particles use these
+    std::vector<float> targetX;
+    std::vector<float> targetY;
+    std::vector<float> targetForce;
+    std::vector<int> fadeTime;
+    std::vector<Uint8> inObjectState;
+    std::vector<MaterialInstance> tile;
+
+    inline size_t size() const {
+        return x.size();
+    }
+
+    ParticleHandle add(const Particle& p);
+    // index of the particle, or -1 if it died
+    int indexOf(ParticleHandle h) const;
+    inline ParticleHandle handleAt(int i) const {
+        return handles[i];
+    }
+
+    // kept in a side table so particles without one don't pay for it
+    void setKillCallback(int i, std::function<void()> callback);
+
+    inline void kill(int i) {
+        flags[i] |= PARTICLE_DEAD;
+    }
+
+    // batch pass over every particle: kills expired temporary particles and ones outside the w*h grid,
+    // applies target forces, and applies acceleration to the ones inside `zone`
+    void integrate(int w, int h, const SDL_Rect& zone);
+    // removes dead particles (swapping the last one into their place) and then runs their kill callbacks
+    void compact();
+    void translate(float dx, float dy);
+    // drops everything without running kill callbacks
+    void clear();
+
+private:
+    std::vector<ParticleHandle> handles;       // by index
+    std::vector<uint32_t> slotIndex;           // by slot
+    std::vector<Uint8> slotGeneration;         // by slot
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<uint32_t, std::function<void()>> killCallbacks; // by slot
+    std::vector<std::function<void()>> pendingCallbacks;
+
+    void moveParticle(size_t from, size_t to);
+    void popBack();
 };
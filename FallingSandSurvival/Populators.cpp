@@ -2,6 +2,7 @@
 
 #include "Populator.hpp"
 #include "Structures.hpp"
+#include "RNG.hpp"
 
 #ifndef INC_Textures
 #include "Textures.hpp"
@@ -152,7 +153,7 @@ public:
                     if(n2 + n + ndetail < std::fmin(0.95, (py) / 1000.0)) {
                         double nlav = world->noise.GetPerlin(px / 4.0, py / 4.0, 7018);
                         if(nlav > 0.45) {
-                            chunk[x + y * CHUNK_W] = rand() % 3 == 0 ? (ch->y > 15 ? Tiles::createLava() : Tiles::createWater()) : Tiles::NOTHING;
+                            chunk[x + y * CHUNK_W] = RNG::local().next() % 3 == 0 ? (ch->y > 15 ? Tiles::createLava() : Tiles::createWater()) : Tiles::NOTHING;
                         } else {
                             chunk[x + y * CHUNK_W] = Tiles::NOTHING;
                         }
@@ -307,7 +308,7 @@ public:
 
     std::vector<PlacedStructure> apply(MaterialInstance* chunk, MaterialInstance* layer2, Chunk** area, bool* dirty, int tx, int ty, int tw, int th, Chunk* ch, World* world) {
         if(ch->y < 0 || ch->y > 3) return {};
-        int x = rand() % (CHUNK_W / 2) + (CHUNK_W / 4);
+        int x = RNG::local().next() % (CHUNK_W / 2) + (CHUNK_W / 4);
         if(area[1 + 2 * 3]->tiles[x + 0 * CHUNK_W].mat->id == Materials::SOFT_DIRT.id) return {};
 
         for(int y = 0; y < CHUNK_H; y++) {
@@ -333,7 +334,7 @@ public:
                 }*/
 
                 char buff[40];
-                snprintf(buff, sizeof(buff), "assets/objects/tree%d.png", rand() % 8 + 1);
+                snprintf(buff, sizeof(buff), "assets/objects/tree%d.png", RNG::local().next() % 8 + 1);
                 //snprintf(buff, sizeof(buff), "assets/objects/testTree.png");
                 std::string buffAsStdStr = buff;
                 SDL_Surface* tex = Textures::loadTexture(buffAsStdStr.c_str());
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+#define INC_RNG
+
+// small xorshift PRNG used instead of rand() by the simulation and world generation
+// rand() shares one locked state between all threads, which is slow from the tickScheduler threads
+//   and makes the result depend on thread timing
+// each thread has its own RNG (RNG::local()), and World reseeds it for every chunk it works on
+//   (from tickCt / the world seed and the chunk coords), so runs are reproducible
+class RNG {
+public:
+    uint32_t state = 0x9E3779B9;
+
+    RNG() {};
+    RNG(uint32_t seed) {
+        setSeed(seed);
+    };
+
+    void setSeed(uint32_t seed) {
+        state = hash(seed);
+        if(state == 0) state = 0x9E3779B9;
+    }
+
+    // 0 to 0x7fffffff, same usage as rand()
+    inline int next() {
+        uint32_t x = state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state = x;
+        // xorshift* output scramble so the low bits (used by `% n`) are decent
+        return (int)((x * 0x2545F491u) >> 1);
+    }
+
+    static inline uint32_t hash(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352d;
+        x ^= x >> 15;
+        x *= 0x846ca68b;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static inline uint32_t hash(uint32_t a, uint32_t b) {
+        return hash(a ^ (hash(b) + 0x9E3779B9 + (a << 6) + (a >> 2)));
+    }
+
+    static inline uint32_t hash(uint32_t a, uint32_t b, uint32_t c) {
+        return hash(hash(a, b), c);
+    }
+
+    static inline uint32_t hash(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+        return hash(hash(a, b, c), d);
+    }
+
+    // the RNG for the current thread
+    static RNG& local() {
+        static thread_local RNG rng;
+        return rng;
+    }
+};
@@ -0,0 +1,330 @@
+
+#include "Region.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BUILD_WITH_EASY_PROFILER
+#include <easy/profiler.h>
+#include "ProfilerConfig.hpp"
+
+#define REGION_VERSION 1
+// files grow by at least this much at a time so appending chunks doesn't remap every write
+#define REGION_GROW_SIZE (1024 * 1024)
+
+Region::Region(std::string fname, int x, int y) {
+    this->fname = fname;
+    this->x = x;
+    this->y = y;
+}
+
+Region::~Region() {
+    unmap();
+    close();
+}
+
+bool Region::open(bool create) {
+    EASY_FUNCTION();
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if(data != nullptr) return true;
+
+    #ifdef _WIN32
+    HANDLE h = CreateFileA(fname.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(h == INVALID_HANDLE_VALUE) return false;
+    file = h;
+    LARGE_INTEGER fsize;
+    GetFileSizeEx(h, &fsize);
+    size_t fileSize = (size_t)fsize.QuadPart;
+    #else
+    int fd = ::open(fname.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    if(fd < 0) return false;
+    file = fd;
+    struct stat st;
+    fstat(fd, &st);
+    size_t fileSize = (size_t)st.st_size;
+    #endif
+
+    bool fresh = fileSize < sizeof(RegionHeader);
+    if(!map(fresh ? sizeof(RegionHeader) + REGION_GROW_SIZE : fileSize)) {
+        logCritical("Failed to map region file {}.", fname);
+        close();
+        return false;
+    }
+
+    if(fresh) {
+        memset(data, 0, sizeof(RegionHeader));
+        memcpy(header()->magic, "FSSR", 4);
+        header()->version = REGION_VERSION;
+        header()->end = sizeof(RegionHeader);
+    } else if(memcmp(header()->magic, "FSSR", 4) != 0 || header()->version != REGION_VERSION) {
+        logCritical("Region file {} is corrupt or from an unsupported version.", fname);
+        unmap();
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool Region::has(int lx, int ly) {
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    if(data == nullptr) return false;
+    return header()->entries[lx + ly * REGION_SIZE].size > 0;
+}
+
+bool Region::read(int lx, int ly, std::function<void(const char* data, uint32_t size)> fn) {
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    if(data == nullptr) return false;
+
+    RegionEntry e = header()->entries[lx + ly * REGION_SIZE];
+    if(e.size == 0) return false;
+    if((size_t)e.offset + e.size > mappedSize) {
+        logCritical("Region file {} has an entry past the end of the file @ {},{}.", fname, lx, ly);
+        return false;
+    }
+
+    fn(data + e.offset, e.size);
+    return true;
+}
+
+bool Region::write(int lx, int ly, const char* src, uint32_t size) {
+    EASY_FUNCTION();
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if(data == nullptr) return false;
+
+    int i = lx + ly * REGION_SIZE;
+    uint32_t offset;
+    if(header()->entries[i].capacity >= size) {
+        // fits in its old slot
+        offset = header()->entries[i].offset;
+    } else {
+        // the old slot (if any) is abandoned, there's no compaction yet
+        offset = header()->end;
+        size_t needed = (size_t)offset + size;
+        if(needed > mappedSize) {
+            size_t newSize = std::max(needed, mappedSize + std::max(mappedSize / 2, (size_t)REGION_GROW_SIZE));
+            unmap();
+            if(!map(newSize)) {
+                logCritical("Failed to grow region file {} to {} bytes.", fname, newSize);
+                return false;
+            }
+        }
+        header()->entries[i].offset = offset;
+        header()->entries[i].capacity = size;
+        header()->end = offset + size;
+    }
+
+    memcpy(data + offset, src, size);
+    header()->entries[i].size = size;
+    return true;
+}
+
+void Region::flush() {
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if(data == nullptr) return;
+
+    #ifdef _WIN32
+    FlushViewOfFile(data, mappedSize);
+    FlushFileBuffers((HANDLE)file);
+    #else
+    msync(data, mappedSize, MS_SYNC);
+    #endif
+}
+
+bool Region::map(size_t size) {
+    #ifdef _WIN32
+    // CreateFileMapping extends the file if it's smaller than the mapping
+    mapping = CreateFileMappingA((HANDLE)file, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xffffffff), NULL);
+    if(mapping == NULL) return false;
+    data = (char*)MapViewOfFile((HANDLE)mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if(data == nullptr) {
+        CloseHandle((HANDLE)mapping);
+        mapping = nullptr;
+        return false;
+    }
+    #else
+    struct stat st;
+    if(fstat(file, &st) != 0) return false;
+    if((size_t)st.st_size < size && ftruncate(file, (off_t)size) != 0) return false;
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+    if(p == MAP_FAILED) return false;
+    data = (char*)p;
+    #endif
+    mappedSize = size;
+    return true;
+}
+
+void Region::unmap() {
+    #ifdef _WIN32
+    if(data != nullptr) UnmapViewOfFile(data);
+    if(mapping != nullptr) CloseHandle((HANDLE)mapping);
+    mapping = nullptr;
+    #else
+    if(data != nullptr) munmap(data, mappedSize);
+    #endif
+    data = nullptr;
+    mappedSize = 0;
+}
+
+void Region::close() {
+    #ifdef _WIN32
+    if(file != nullptr) CloseHandle((HANDLE)file);
+    file = nullptr;
+    #else
+    if(file >= 0) ::close(file);
+    file = -1;
+    #endif
+}
+
+std::mutex Regions::mutex;
+std::unordered_map<std::string, Regions::WorldRegions*> Regions::worlds;
+
+Regions::WorldRegions* Regions::get(const std::string& worldName) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = worlds.find(worldName);
+    if(it != worlds.end()) return it->second;
+
+    EASY_FUNCTION();
+    WorldRegions* w = new WorldRegions();
+    w->dir = worldName + "/chunks/";
+
+    // one directory listing up front instead of a stat() every time a chunk is looked up
+    std::error_code err;
+    if(filesystem::exists(w->dir, err)) {
+        for(auto& p : filesystem::directory_iterator(w->dir)) {
+            std::string name = p.path().filename().generic_string();
+            int a;
+            int b;
+            if(sscanf(name.c_str(), "region_%d_%d", &a, &b) == 2) {
+                w->regionFiles.insert(key(a, b));
+            } else if(sscanf(name.c_str(), "chunk_%d_%d", &a, &b) == 2) {
+                w->legacyChunks.insert(key(a, b));
+            }
+        }
+    }
+
+    worlds[worldName] = w;
+    return w;
+}
+
+void Regions::close(const std::string& worldName) {
+    EASY_FUNCTION();
+    WorldRegions* w;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = worlds.find(worldName);
+        if(it == worlds.end()) return;
+        w = it->second;
+        worlds.erase(it);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        for(auto& p : w->regions) {
+            p.second->flush();
+            delete p.second;
+        }
+        w->regions.clear();
+    }
+    delete w;
+}
+
+Region* Regions::getRegion(WorldRegions* w, int rx, int ry, bool create) {
+    int64_t k = key(rx, ry);
+    auto it = w->regions.find(k);
+    if(it != w->regions.end()) return it->second;
+    if(!create && !w->regionFiles.count(k)) return nullptr;
+
+    Region* r = new Region(w->dir + "region_" + std::to_string(rx) + "_" + std::to_string(ry), rx, ry);
+    if(!r->open(create)) {
+        // don't keep retrying unreadable files
+        w->regionFiles.erase(k);
+        delete r;
+        return nullptr;
+    }
+
+    w->regions[k] = r;
+    w->regionFiles.insert(k);
+    return r;
+}
+
+bool Regions::has(const std::string& worldName, int cx, int cy) {
+    EASY_FUNCTION();
+    WorldRegions* w = get(worldName);
+    std::lock_guard<std::mutex> lock(w->mutex);
+
+    if(w->legacyChunks.count(key(cx, cy))) return true;
+
+    int rx = regionCoord(cx);
+    int ry = regionCoord(cy);
+    Region* r = getRegion(w, rx, ry, false);
+    return r != nullptr && r->has(cx - rx * REGION_SIZE, cy - ry * REGION_SIZE);
+}
+
+bool Regions::read(const std::string& worldName, int cx, int cy, std::function<void(const char* data, uint32_t size)> fn) {
+    WorldRegions* w = get(worldName);
+
+    int rx = regionCoord(cx);
+    int ry = regionCoord(cy);
+    int lx = cx - rx * REGION_SIZE;
+    int ly = cy - ry * REGION_SIZE;
+
+    Region* r;
+    bool legacy;
+    {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        r = getRegion(w, rx, ry, false);
+        if(r != nullptr && !r->has(lx, ly)) r = nullptr;
+        legacy = r == nullptr && w->legacyChunks.count(key(cx, cy));
+    }
+
+    // outside the world lock so other regions can be read at the same time
+    if(r != nullptr) return r->read(lx, ly, fn);
+
+    if(legacy) {
+        std::ifstream file(w->dir + "chunk_" + std::to_string(cx) + "_" + std::to_string(cy), std::ios::binary | std::ios::ate);
+        if(!file.is_open()) return false;
+        std::vector<char> buf((size_t)file.tellg());
+        file.seekg(0);
+        file.read(buf.data(), buf.size());
+        fn(buf.data(), (uint32_t)buf.size());
+        return true;
+    }
+
+    return false;
+}
+
+bool Regions::write(const std::string& worldName, int cx, int cy, const char* data, uint32_t size) {
+    WorldRegions* w = get(worldName);
+
+    int rx = regionCoord(cx);
+    int ry = regionCoord(cy);
+
+    Region* r;
+    bool legacy;
+    {
+        std::lock_guard<std::mutex> lock(w->mutex);
+        r = getRegion(w, rx, ry, true);
+        if(r == nullptr) return false;
+        legacy = w->legacyChunks.erase(key(cx, cy)) > 0;
+    }
+
+    if(!r->write(cx - rx * REGION_SIZE, cy - ry * REGION_SIZE, data, size)) {
+        if(legacy) {
+            std::lock_guard<std::mutex> lock(w->mutex);
+            w->legacyChunks.insert(key(cx, cy));
+        }
+        return false;
+    }
+
+    // the region has the up to date copy now
+    if(legacy) std::remove((w->dir + "chunk_" + std::to_string(cx) + "_" + std::to_string(cy)).c_str());
+
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
+
+#define INC_Region
+
+// region files are REGION_SIZE*REGION_SIZE chunks
+#define REGION_SIZE 32
+
+// one <world>/chunks/region_X_Y file, memory mapped
+// layout: [RegionHeader][chunk data...]
+//   each chunk's data is what used to be its own chunk_X_Y file (see Chunk::write)
+//   a chunk keeps its slot as long as the new data fits, otherwise it's moved to the end of the file
+class Region {
+public:
+    int x;
+    int y;
+
+    // doesn't touch the file until open() is called
+    Region(std::string fname, int x, int y);
+    ~Region();
+
+    // maps the file, creating it if `create` is set
+    bool open(bool create);
+
+    // lx/ly are chunk coords inside the region (0 to REGION_SIZE-1)
+    bool has(int lx, int ly);
+    // `fn` gets a pointer straight into the mapping (only valid until it returns)
+    bool read(int lx, int ly, std::function<void(const char* data, uint32_t size)> fn);
+    bool write(int lx, int ly, const char* data, uint32_t size);
+    // writes the mapped pages back to the file
+    void flush();
+
+private:
+    typedef struct {
+        uint32_t offset;
+        uint32_t size;
+        uint32_t capacity;
+    } RegionEntry;
+
+    typedef struct {
+        char magic[4];
+        uint32_t version;
+        uint32_t end; // first byte after the last slot
+        uint32_t reserved;
+        RegionEntry entries[REGION_SIZE * REGION_SIZE];
+    } RegionHeader;
+
+    std::string fname;
+    // readers share, writes (which might remap) are exclusive
+    std::shared_timed_mutex mutex;
+    char* data = nullptr;
+    size_t mappedSize = 0;
+    #ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+    #else
+    int file = -1;
+    #endif
+
+    bool map(size_t size);
+    void unmap();
+    void close();
+    RegionHeader* header() {
+        return (RegionHeader*)data;
+    }
+};
+
+// chunk storage for all worlds, split into region files
+// keeps an in-memory index per world of which chunks exist, so Chunk::hasFile doesn't need to hit the filesystem
+// chunk_X_Y files from older saves are still read, and get moved into their region the next time they're written
+class Regions {
+public:
+    static bool has(const std::string& worldName, int cx, int cy);
+    static bool read(const std::string& worldName, int cx, int cy, std::function<void(const char* data, uint32_t size)> fn);
+    static bool write(const std::string& worldName, int cx, int cy, const char* data, uint32_t size);
+    // flushes and unmaps the world's regions and forgets its index, call once nothing writes to the world anymore
+    static void close(const std::string& worldName);
+
+private:
+    class WorldRegions {
+    public:
+        std::string dir;
+        std::mutex mutex;
+        std::unordered_map<int64_t, Region*> regions;
+        // scanned once when the world is first used
+        std::unordered_set<int64_t> regionFiles;
+        std::unordered_set<int64_t> legacyChunks;
+    };
+
+    static std::mutex mutex;
+    static std::unordered_map<std::string, WorldRegions*> worlds;
+
+    static WorldRegions* get(const std::string& worldName);
+    static Region* getRegion(WorldRegions* w, int rx, int ry, bool create);
+
+    static inline int64_t key(int x, int y) {
+        return ((int64_t)x << 32) | (uint32_t)y;
+    }
+    static inline int regionCoord(int c) {
+        return c >= 0 ? c / REGION_SIZE : (c + 1) / REGION_SIZE - 1;
+    }
+};
@@ -30,9 +30,22 @@ public:
 
     // hitbox needs update
     bool needsUpdate = false;
+    // id of the World::hitboxJobs entry rebuilding it (0 if none)
+    uint32_t hitboxJob = 0;
+    // bumped whenever tiles change, a hitbox job built from an older copy of them isn't applied
+    uint32_t tilesVersion = 0;
 
     // surface needs to be converted to texture
     bool texNeedsUpdate = false;
+    // tiles (by index) whose pixel in surface is out of date
+    std::vector<int> dirtyPixels;
+    // world index each tile was put at by the last stamp in Game::tick (-1 if it wasn't), so they can be picked back up without searching
+    std::vector<int> stampedAt;
+    // the tiles are in the world right now (from the stamp in Game::tick until the pickup in Game::tickLate)
+    bool stamped = false;
+    // where the body was for that stamp, a sleeping body that's still there reuses stampedAt instead of rotating every tile again
+    b2Vec2 stampPos = {0, 0};
+    float stampAngle = 0;
 
     int weldX = -1;
     int weldY = -1;
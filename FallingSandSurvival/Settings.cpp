@@ -5,6 +5,7 @@ bool Settings::draw_frame_graph     = true;
 bool Settings::draw_background      = true;
 bool Settings::draw_background_grid = false;
 bool Settings::draw_load_zones      = false;
+bool Settings::draw_active_rects    = false;
 bool Settings::draw_physics_debug   = false;
 bool Settings::draw_b2d_shape       = true;
 bool Settings::draw_b2d_joint       = false;
@@ -28,8 +29,19 @@ bool Settings::lightingEmission     = true;
 bool Settings::lightingDithering    = false;
 
 bool Settings::tick_world           = true;
+bool Settings::tick_world_async     = true;
 bool Settings::tick_box2d           = true;
 bool Settings::tick_temperature     = true;
+bool Settings::tick_sleep_chunks    = true;
+bool Settings::tick_cell_planes     = true;
+bool Settings::tick_cell_kernels    = true;
+bool Settings::tick_liquid_solver   = true;
+int Settings::tick_liquid_substeps  = 6;
+bool Settings::tick_reactive_set    = true;
+bool Settings::tick_lod             = false;
+bool Settings::tick_island_events   = true;
+bool Settings::tick_hitbox_async    = true;
+bool Settings::tick_box_colliders   = false;
 bool Settings::hd_objects           = false;
 
 int Settings::hd_objects_size = 3;
@@ -7,6 +7,7 @@ public:
     static bool draw_background;
     static bool draw_background_grid;
     static bool draw_load_zones;
+    static bool draw_active_rects;
     static bool draw_physics_debug;
     static bool draw_b2d_shape;
     static bool draw_b2d_joint;
@@ -31,8 +32,19 @@ public:
     static bool lightingDithering;
 
     static bool tick_world;
+    static bool tick_world_async;
     static bool tick_box2d;
     static bool tick_temperature;
+    static bool tick_sleep_chunks;
+    static bool tick_cell_planes;
+    static bool tick_cell_kernels;
+    static bool tick_liquid_solver;
+    static int tick_liquid_substeps;
+    static bool tick_reactive_set;
+    static bool tick_lod;
+    static bool tick_island_events;
+    static bool tick_hitbox_async;
+    static bool tick_box_colliders;
     static bool hd_objects;
 
     static int hd_objects_size;
@@ -1,6 +1,7 @@
 
 #include "Structures.hpp"
 #include <algorithm>
+#include "RNG.hpp"
 
 #ifndef INC_Textures
 #include "Textures.hpp"
@@ -10,8 +11,8 @@
 #undef max
 
 Structure Structures::makeTree(World world, int x, int y) {
-    int w = 50 + rand() % 10;
-    int h = 80 + rand() % 20;
+    int w = 50 + RNG::local().next() % 10;
+    int h = 80 + RNG::local().next() % 20;
     MaterialInstance* tiles = new MaterialInstance[w * h];
 
     for(int tx = 0; tx < w; tx++) {
@@ -20,10 +21,10 @@ Structure Structures::makeTree(World world, int x, int y) {
         }
     }
 
-    int trunk = 3 + rand() % 2;
+    int trunk = 3 + RNG::local().next() % 2;
 
     float cx = w / 2;
-    float dcx = (((rand() % 10) / 10.0) - 0.5) / 3.0;
+    float dcx = (((RNG::local().next() % 10) / 10.0) - 0.5) / 3.0;
     for(int ty = h - 1; ty > 20; ty--) {
         int bw = trunk + std::max((ty - h + 10) / 3, 0);
         for(int xx = -bw; xx <= bw; xx++) {
@@ -44,12 +45,12 @@ Structure Structures::makeTree(World world, int x, int y) {
         }
     }
 
-    int nBranches = rand() % 3;
-    bool side = rand() % 2; // false = right, true = left
+    int nBranches = RNG::local().next() % 3;
+    bool side = RNG::local().next() % 2; // false = right, true = left
     for(int i = 0; i < nBranches; i++) {
-        int yPos = 20 + (h - 20) / 3 * (i + 1) + rand() % 10;
-        float tilt = ((rand() % 10) / 10.0 - 0.5) * 8;
-        int len = 10 + rand() % 5;
+        int yPos = 20 + (h - 20) / 3 * (i + 1) + RNG::local().next() % 10;
+        float tilt = ((RNG::local().next() % 10) / 10.0 - 0.5) * 8;
+        int len = 10 + RNG::local().next() % 5;
         for(int xx = 0; xx < len; xx++) {
             int tx = (int)(w / 2 + dcx * (h - yPos)) + (side ? 1 : -1) * (xx + 2) - (int)(dcx * (h - 30));
             int th = 3 * (1 - (xx / (float)len));
@@ -69,7 +70,7 @@ Structure Structures::makeTree(World world, int x, int y) {
 
 Structure Structures::makeTree1(World world, int x, int y) {
     char buff[30];
-    snprintf(buff, sizeof(buff), "assets/objects/tree%d.png", rand() % 8 + 1);
+    snprintf(buff, sizeof(buff), "assets/objects/tree%d.png", RNG::local().next() % 8 + 1);
     std::string buffAsStdStr = buff;
     return Structure(Textures::loadTexture(buffAsStdStr.c_str()), Materials::GENERIC_PASSABLE);
 }
@@ -0,0 +1,111 @@
+
+#include "TickScheduler.hpp"
+
+#define BUILD_WITH_EASY_PROFILER
+#include <easy/profiler.h>
+#include "ProfilerConfig.hpp"
+
+TickScheduler::TickScheduler(int nWorkers) {
+    for(int i = 0; i < nWorkers + 1; i++) {
+        queues.push_back(new Queue());
+    }
+    for(int i = 0; i < nWorkers; i++) {
+        threads.push_back(std::thread(&TickScheduler::workerMain, this, i + 1));
+    }
+}
+
+TickScheduler::~TickScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    startCv.notify_all();
+    for(auto& t : threads) t.join();
+    for(auto& q : queues) delete q;
+}
+
+void TickScheduler::dispatch(int nTasks, void* ctx, void(*call)(void* ctx, int task, int worker)) {
+    {
+        // the workers are all parked here, so the queues can be refilled without locking them
+        std::lock_guard<std::mutex> lock(mutex);
+        this->ctx = ctx;
+        this->call = call;
+
+        for(auto& q : queues) {
+            q->tasks.clear();
+            q->head = 0;
+        }
+        for(int t = 0; t < nTasks; t++) {
+            queues[t % queues.size()]->tasks.push_back(t);
+        }
+        for(auto& q : queues) {
+            q->tail = q->tasks.size();
+        }
+
+        busy = (int)threads.size();
+        generation++;
+    }
+    startCv.notify_all();
+
+    work(0);
+
+    EASY_BLOCK("wait for workers", THREAD_WAIT_PROFILER_COLOR);
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCv.wait(lock, [&]() {
+        return busy == 0;
+    });
+    EASY_END_BLOCK;
+}
+
+void TickScheduler::work(int worker) {
+    int task;
+    while(pop(worker, &task)) {
+        call(ctx, task, worker);
+    }
+}
+
+bool TickScheduler::pop(int worker, int* task) {
+    Queue* q = queues[worker];
+    {
+        std::lock_guard<std::mutex> lock(q->mutex);
+        if(q->head < q->tail) {
+            *task = q->tasks[--q->tail];
+            return true;
+        }
+    }
+
+    // out of work, steal from the others
+    for(size_t i = 1; i < queues.size(); i++) {
+        Queue* victim = queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim->mutex);
+        if(victim->head < victim->tail) {
+            *task = victim->tasks[victim->head++];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TickScheduler::workerMain(int worker) {
+    EASY_THREAD("Tick worker");
+
+    uint64_t seen = 0;
+    while(true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            startCv.wait(lock, [&]() {
+                return stop || generation != seen;
+            });
+            if(stop) return;
+            seen = generation;
+        }
+
+        work(worker);
+
+        if(busy.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(mutex);
+            doneCv.notify_all();
+        }
+    }
+}
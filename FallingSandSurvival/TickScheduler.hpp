@@ -0,0 +1,63 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+#define INC_TickScheduler
+
+// persistent worker threads for World::tick
+// run() hands out task indices (spread over per-worker deques, idle workers steal from the others) and returns when they're all done
+// the calling thread works too, and between runs the workers stay parked, so a pass costs no allocations or thread pool pushes
+class TickScheduler {
+public:
+    // nWorkers extra threads (0 runs everything on the calling thread)
+    TickScheduler(int nWorkers);
+    ~TickScheduler();
+
+    // total threads that can run tasks (including the caller), worker ids passed to fn are 0 to this - 1
+    inline int size() const {
+        return (int)queues.size();
+    }
+
+    // calls fn(task, worker) for every task in [0, nTasks) and waits for all of them
+    template<typename F>
+    void run(int nTasks, F& fn) {
+        if(nTasks <= 0) return;
+        dispatch(nTasks, &fn, [](void* ctx, int task, int worker) {
+            (*(F*)ctx)(task, worker);
+        });
+    }
+
+private:
+    // owner pops from the back, thieves take from the front
+    class Queue {
+    public:
+        std::mutex mutex;
+        std::vector<int> tasks;
+        size_t head = 0;
+        size_t tail = 0;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<Queue*> queues;
+
+    std::mutex mutex;
+    std::condition_variable startCv;
+    std::condition_variable doneCv;
+    uint64_t generation = 0;
+    bool stop = false;
+
+    // current run
+    void* ctx = nullptr;
+    void (*call)(void* ctx, int task, int worker) = nullptr;
+    // workers that haven't finished the current run yet
+    std::atomic<int> busy {0};
+
+    void dispatch(int nTasks, void* ctx, void (*call)(void* ctx, int task, int worker));
+    void work(int worker);
+    bool pop(int worker, int* task);
+    void workerMain(int worker);
+};
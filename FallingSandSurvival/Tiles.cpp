@@ -1,6 +1,7 @@
 
 #include "Tiles.hpp"
 #include "Textures.hpp"
+#include "RNG.hpp"
 
 #include "Macros.hpp"
 
@@ -13,7 +14,7 @@ const MaterialInstance Tiles::OBJECT		= MaterialInstance(&Materials::GENERIC_OBJ
 
 MaterialInstance Tiles::createTestSand() {
     Uint32 rgb = 220;
-    rgb = (rgb << 8) + 155 + rand() % 30;
+    rgb = (rgb << 8) + 155 + RNG::local().next() % 30;
     rgb = (rgb << 8) + 100;
     return MaterialInstance(&Materials::TEST_SAND, rgb);
 }
@@ -51,13 +52,13 @@ MaterialInstance Tiles::createStone(int x, int y) {
 
 MaterialInstance Tiles::createGrass() {
     Uint32 rgb = 40;
-    rgb = (rgb << 8) + 120 + rand() % 20;
+    rgb = (rgb << 8) + 120 + RNG::local().next() % 20;
     rgb = (rgb << 8) + 20;
     return MaterialInstance(&Materials::GRASS, rgb);
 }
 
 MaterialInstance Tiles::createDirt() {
-    Uint32 rgb = 60 + rand() % 10;
+    Uint32 rgb = 60 + RNG::local().next() % 10;
     rgb = (rgb << 8) + 40;
     rgb = (rgb << 8) + 20;
     return MaterialInstance(&Materials::DIRT, rgb);
@@ -181,7 +182,7 @@ MaterialInstance Tiles::createSteam() {
 MaterialInstance Tiles::createFire() {
 
     Uint32 rgb = 255;
-    rgb = (rgb << 8) + 100 + rand() % 50;
+    rgb = (rgb << 8) + 100 + RNG::local().next() % 50;
     rgb = (rgb << 8) + 50;
 
     return MaterialInstance(&Materials::FIRE, rgb);
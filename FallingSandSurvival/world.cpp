@@ -15,6 +15,16 @@
 #include "lib/cpp-marching-squares-master/MarchingSquares.h"
 #include "lib/polypartition-master/src/polypartition.h"
 #include "UTime.hpp"
+#include "Settings.hpp"
+#include "CellGrid.hpp"
+#include "ChunkTick.hpp"
+#include "RNG.hpp"
+#include "Region.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEMPERATURE_SSE
+#include <emmintrin.h>
+#endif
 #include <thread>
 #include "Populators.cpp"
 #include "DefaultGenerator.cpp"
@@ -33,8 +43,12 @@
 
 #define W_PI 3.14159265358979323846
 
-ctpl::thread_pool* World::tickPool = nullptr;
-ctpl::thread_pool* World::tickVisitedPool = nullptr;
+TickScheduler* World::tickScheduler = nullptr;
+
+// fire and temperature reactions are handled by tickReactive instead of tick()'s passes (only implemented for the cell kernels)
+static bool reactiveSetEnabled() {
+    return Settings::tick_cell_kernels && Settings::tick_reactive_set;
+}
 ctpl::thread_pool* World::updateRigidBodyHitboxPool = nullptr;
 ctpl::thread_pool* World::loadChunkPool = nullptr;
 
@@ -60,22 +74,23 @@ void World::init(std::string worldPath, uint16_t w, uint16_t h, GPU_Target* targ
     width = w;
     height = h;
 
-    EASY_BLOCK("make tickPool");
-    if(tickPool == nullptr) tickPool = new ctpl::thread_pool(6);
+    EASY_BLOCK("make tickScheduler");
+    // the thread calling tick() works too
+    if(tickScheduler == nullptr) tickScheduler = new TickScheduler(std::max((int)std::thread::hardware_concurrency() - 1, 1));
     EASY_END_BLOCK;
 
     EASY_BLOCK("make loadChunkPool");
     if(loadChunkPool == nullptr) loadChunkPool = new ctpl::thread_pool(8);
     EASY_END_BLOCK;
 
-    EASY_BLOCK("make tickVisitedPool");
-    if(tickVisitedPool == nullptr) tickVisitedPool = new ctpl::thread_pool(1);
-    EASY_END_BLOCK;
-
     EASY_BLOCK("make updateRigidBodyHitboxPool");
     if(updateRigidBodyHitboxPool == nullptr) updateRigidBodyHitboxPool = new ctpl::thread_pool(8);
     EASY_END_BLOCK;
 
+    EASY_BLOCK("make chunkWriter");
+    chunkWriter = new ChunkWriter();
+    EASY_END_BLOCK;
+
     if(netMode != NetworkMode::SERVER) {
         EASY_BLOCK("audio load Explode event");
         this->audioEngine = audioEngine;
@@ -124,8 +139,8 @@ void World::init(std::string worldPath, uint16_t w, uint16_t h, GPU_Target* targ
     EASY_BLOCK("init distributedPoints");
     float distributedPointsDistance = 0.05f;
     for(int i = 0; i < (1 / distributedPointsDistance) * (1 / distributedPointsDistance); i++) {
-        float x = rand() % 1000 / 1000.0;
-        float y = rand() % 1000 / 1000.0;
+        float x = RNG::local().next() % 1000 / 1000.0;
+        float y = RNG::local().next() % 1000 / 1000.0;
 
         for(int j = 0; j < distributedPoints.size(); j++) {
             float dx = distributedPoints[j].x - x;
@@ -146,19 +161,36 @@ tooClose: {}
     dirty = new bool[width * height];
     layer2Dirty = new bool[width * height];
     backgroundDirty = new bool[width * height];
-    lastActive = new bool[width * height];
-    active = new bool[width * height];
-    this->tickVisited1 = new bool[width * height];
-    this->tickVisited2 = new bool[width * height];
+    dirtyTilesW = (width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+    dirtyTilesH = (height + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+    dirtyTiles = new bool[dirtyTilesW * dirtyTilesH];
+    layer2DirtyTiles = new bool[dirtyTilesW * dirtyTilesH];
+    backgroundDirtyTiles = new bool[dirtyTilesW * dirtyTilesH];
+    memset(dirtyTiles, false, (size_t)dirtyTilesW * dirtyTilesH);
+    memset(layer2DirtyTiles, false, (size_t)dirtyTilesW * dirtyTilesH);
+    memset(backgroundDirtyTiles, false, (size_t)dirtyTilesW * dirtyTilesH);
+    activeW = (width + CHUNK_W - 1) / CHUNK_W;
+    activeH = (height + CHUNK_H - 1) / CHUNK_H;
+    lastActive = new SDL_Rect[activeW * activeH];
+    active = new SDL_Rect[activeW * activeH];
+    this->tickVisited = new uint16_t[width * height];
+    memset(tickVisited, 0, (size_t)width * height * sizeof(uint16_t));
+    this->fireListed = new Uint8[width * height];
+    memset(fireListed, 0, (size_t)width * height);
+    this->islandVisited = new uint32_t[width * height];
+    memset(islandVisited, 0, (size_t)width * height * sizeof(uint32_t));
     for(int x = 0; x < width; x++) {
         for(int y = 0; y < height; y++) {
             dirty[x + y * width] = false;
             layer2Dirty[x + y * width] = false;
-            lastActive[x + y * width] = true;
-            active[x + y * width] = false;
             backgroundDirty[x + y * width] = false;
         }
     }
+    for(int i = 0; i < activeW * activeH; i++) {
+        lastActive[i] = {0, 0, 0, 0};
+        active[i] = {0, 0, 0, 0};
+    }
+    markActive(0, 0, width, height);
     EASY_END_BLOCK;
 
     EASY_BLOCK("init layer arrays");
@@ -178,9 +210,11 @@ tooClose: {}
             flowY[x + y * width] = 0;
             prevFlowX[x + y * width] = 0;
             prevFlowY[x + y * width] = 0;
-            //particles.push_back(new Particle(x, y, 0, 0, 0, 0.1, 0xffff00));
+            //particles.add(Particle(x, y, 0, 0, 0, 0.1, 0xffff00));
         }
     }
+    cells.init(width, height);
+    cells.gather(tiles, width, 0, 0, width, height);
     EASY_END_BLOCK;
 
     EASY_BLOCK("init box2d");
@@ -234,7 +268,7 @@ RigidBody* World::makeRigidBody(b2BodyType type, float x, float y, float angle,
             for(int yy = 0; yy < rb->matHeight; yy++) {
                 uint32 pixel = PIXEL(rb->surface, xx, yy);
                 if(((pixel >> 24) & 0xff) != 0x00) {
-                    MaterialInstance inst = Tiles::create(rand() % 250 == -1 ? &Materials::FIRE : &Materials::OBSIDIAN, xx + (int)x, yy + (int)y);
+                    MaterialInstance inst = Tiles::create(RNG::local().next() % 250 == -1 ? &Materials::FIRE : &Materials::OBSIDIAN, xx + (int)x, yy + (int)y);
                     inst.color = pixel;
                     rb->tiles[xx + yy * rb->matWidth] = inst;
                 } else {
@@ -255,8 +289,11 @@ RigidBody* World::makeRigidBody(b2BodyType type, float x, float y, float angle,
             }
         }*/
 
-        rb->texture = GPU_CopyImageFromSurface(rb->surface);
-        GPU_SetImageFilter(rb->texture, GPU_FILTER_NEAREST);
+        // no target when running headless (dedicated server/benchmark)
+        if(target != nullptr) {
+            rb->texture = GPU_CopyImageFromSurface(rb->surface);
+            GPU_SetImageFilter(rb->texture, GPU_FILTER_NEAREST);
+        }
     }
     //rigidBodies.push_back(rb);
     return rb;
@@ -290,7 +327,7 @@ RigidBody* World::makeRigidBodyMulti(b2BodyType type, float x, float y, float an
             for(int yy = 0; yy < rb->matHeight; yy++) {
                 uint32 pixel = PIXEL(rb->surface, xx, yy);
                 if(((pixel >> 24) & 0xff) != 0x00) {
-                    MaterialInstance inst = Tiles::create(rand() % 250 == -1 ? &Materials::FIRE : &Materials::OBSIDIAN, xx + (int)x, yy + (int)y);
+                    MaterialInstance inst = Tiles::create(RNG::local().next() % 250 == -1 ? &Materials::FIRE : &Materials::OBSIDIAN, xx + (int)x, yy + (int)y);
                     inst.color = pixel;
                     rb->tiles[xx + yy * rb->matWidth] = inst;
                 } else {
@@ -311,37 +348,145 @@ RigidBody* World::makeRigidBodyMulti(b2BodyType type, float x, float y, float an
             }
         }*/
 
-        rb->texture = GPU_CopyImageFromSurface(rb->surface);
-        GPU_SetImageFilter(rb->texture, GPU_FILTER_NEAREST);
+        // no target when running headless (dedicated server/benchmark)
+        if(target != nullptr) {
+            rb->texture = GPU_CopyImageFromSurface(rb->surface);
+            GPU_SetImageFilter(rb->texture, GPU_FILTER_NEAREST);
+        }
     }
     //rigidBodies.push_back(rb);
     return rb;
 }
 
-void World::updateRigidBodyHitbox(RigidBody* rb) {
-    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+// Helpers for World::updateRigidBodyHitbox
 
-    EASY_BLOCK("init");
-    SDL_Surface* texture = rb->surface;
+// labels the 4-connected components of the mask (w*h, nonzero is set) as 1 to n in `labels` (0 where it isn't set), returns n
+// two pass labeling: provisional labels are merged with union-find, then flattened to consecutive ids
+static int labelComponents(const unsigned char* mask, int w, int h, std::vector<int>& labels) {
+    labels.assign(w * h, 0);
+    std::vector<int> parent(1, 0);
 
-    for(int x = 0; x < texture->w; x++) {
-        for(int y = 0; y < texture->h; y++) {
-            MaterialInstance mat = rb->tiles[x + y * texture->w];
-            if(mat.mat->id == Materials::GENERIC_AIR.id) {
-                PIXEL(texture, x, y) = 0x00000000;
+    auto find = [&](int a) {
+        while(parent[a] != a) {
+            parent[a] = parent[parent[a]];
+            a = parent[a];
+        }
+        return a;
+    };
+
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            int i = x + y * w;
+            if(!mask[i]) continue;
+
+            int left = x > 0 ? labels[i - 1] : 0;
+            int up = y > 0 ? labels[i - w] : 0;
+            if(left && up) {
+                int a = find(left);
+                int b = find(up);
+                if(a != b) parent[std::max(a, b)] = std::min(a, b);
+                labels[i] = std::min(a, b);
+            } else if(left || up) {
+                labels[i] = left ? left : up;
             } else {
-                PIXEL(texture, x, y) = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
+                labels[i] = (int)parent.size();
+                parent.push_back((int)parent.size());
             }
         }
     }
 
-    int minX = texture->w;
+    // roots always have the smallest label of their set, so they get their id before anything that points to them
+    std::vector<int> remap(parent.size(), 0);
+    int n = 0;
+    for(int l = 1; l < (int)parent.size(); l++) {
+        int r = find(l);
+        remap[l] = r == l ? ++n : remap[r];
+    }
+
+    for(int i = 0; i < w * h; i++) labels[i] = remap[labels[i]];
+    return n;
+}
+
+// triangle centroids of the new bodies bucketed into CENTROID_GRID_SIZE cells,
+//   for the pixels that can't be given to a body by their component
+#define CENTROID_GRID_SIZE 8
+class CentroidGrid {
+public:
+    int cellsW;
+    int cellsH;
+    // cellStart[c] to cellStart[c + 1] in entries
+    std::vector<int> cellStart;
+    std::vector<std::pair<b2Vec2, int>> entries;
+
+    CentroidGrid(const std::vector<std::vector<b2PolygonShape>>& bodies, int w, int h) {
+        cellsW = w / CENTROID_GRID_SIZE + 1;
+        cellsH = h / CENTROID_GRID_SIZE + 1;
+        cellStart.assign(cellsW * cellsH + 1, 0);
+
+        for(auto& body : bodies) {
+            for(auto& tri : body) cellStart[cellOf(tri.m_centroid) + 1]++;
+        }
+        for(int c = 0; c < cellsW * cellsH; c++) cellStart[c + 1] += cellStart[c];
+
+        entries.resize(cellStart.back());
+        std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+        for(int b = 0; b < bodies.size(); b++) {
+            for(auto& tri : bodies[b]) entries[fill[cellOf(tri.m_centroid)]++] = {tri.m_centroid, b};
+        }
+    }
+
+    // body with the nearest centroid (manhattan distance, like the old linear search)
+    // searches rings of cells outward until no unsearched cell could be closer
+    int nearest(int x, int y) const {
+        int cx = std::min(x / CENTROID_GRID_SIZE, cellsW - 1);
+        int cy = std::min(y / CENTROID_GRID_SIZE, cellsH - 1);
+
+        int nb = 0;
+        int nearestDist = 100000;
+        int maxRing = std::max(cellsW, cellsH);
+        for(int ring = 0; ring <= maxRing; ring++) {
+            for(int gy = cy - ring; gy <= cy + ring; gy++) {
+                if(gy < 0 || gy >= cellsH) continue;
+                bool edgeRow = gy == cy - ring || gy == cy + ring;
+                for(int gx = cx - ring; gx <= cx + ring; gx += edgeRow ? 1 : ring * 2) {
+                    if(gx < 0 || gx >= cellsW) continue;
+                    int c = gx + gy * cellsW;
+                    for(int e = cellStart[c]; e < cellStart[c + 1]; e++) {
+                        int dst = (int)(abs(x - entries[e].first.x) + abs(y - entries[e].first.y));
+                        if(dst < nearestDist) {
+                            nearestDist = dst;
+                            nb = entries[e].second;
+                        }
+                    }
+                }
+            }
+
+            // everything past this ring is at least this far away
+            if(nearestDist <= ring * CENTROID_GRID_SIZE) break;
+        }
+
+        return nb;
+    }
+
+private:
+    inline int cellOf(const b2Vec2& p) const {
+        int gx = std::max(0, std::min((int)p.x / CENTROID_GRID_SIZE, cellsW - 1));
+        int gy = std::max(0, std::min((int)p.y / CENTROID_GRID_SIZE, cellsH - 1));
+        return gx + gy * cellsW;
+    }
+};
+
+void HitboxJob::build() {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    EASY_BLOCK("init");
+    minX = srcW;
     int maxX = 0;
-    int minY = texture->h;
+    minY = srcH;
     int maxY = 0;
-    for(int x = 0; x < texture->w; x++) {
-        for(int y = 0; y < texture->h; y++) {
-            if(((PIXEL(texture, x, y) >> 24) & 0xff) != 0x00) {
+    for(int x = 0; x < srcW; x++) {
+        for(int y = 0; y < srcH; y++) {
+            if(((pixels[x + y * srcW] >> 24) & 0xff) != 0x00) {
                 if(x < minX) minX = x;
                 if(x > maxX) maxX = x;
                 if(y < minY) minY = y;
@@ -351,64 +496,34 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
     }
     maxX++;
     maxY++;
-    SDL_Surface* sf = SDL_CreateRGBSurfaceWithFormat(texture->flags, maxX - minX, maxY - minY, texture->format->BitsPerPixel, texture->format->format);
-    SDL_Rect src = {minX, minY, maxX - minX, maxY - minY};
-    SDL_SetSurfaceBlendMode(texture, SDL_BlendMode::SDL_BLENDMODE_NONE);
-    SDL_BlitSurface(texture, &src, sf, NULL);
-
-    SDL_FreeSurface(texture);
-
-    rb->surface = sf;
-    texture = rb->surface;
+    w = maxX - minX;
+    h = maxY - minY;
+    EASY_END_BLOCK;
 
-    if(rb->surface->w <= 0 || rb->surface->h <= 0) {
-        b2world->DestroyBody(rb->body);
-        rigidBodies.erase(std::remove(rigidBodies.begin(), rigidBodies.end(), rb), rigidBodies.end());
+    if(w <= 0 || h <= 0) {
         return;
     }
 
-    float s = sin(rb->body->GetAngle());
-    float c = cos(rb->body->GetAngle());
-
-    // translate point back to origin:
-    minX -= 0;
-    minY -= 0;
-
-    // rotate point
-    float xnew = minX * c - minY * s;
-    float ynew = minX * s + minY * c;
-
-    // translate point back:
-    rb->body->SetTransform(b2Vec2(rb->body->GetPosition().x + xnew, rb->body->GetPosition().y + ynew), rb->body->GetAngle());
-    EASY_END_BLOCK;
-
-    EASY_BLOCK("foundAnything");
-    bool foundAnything = false;
-    for(int x = 0; x < texture->w; x++) {
-        for(int y = 0; y < texture->h; y++) {
-            bool f = ((PIXEL(texture, x, y) >> 24) & 0xff) == 0x00 ? 0 : 1;
-            foundAnything = foundAnything || f;
-        }
+    EASY_BLOCK("trim");
+    std::vector<Uint32> tex(w * h);
+    for(int y = 0; y < h; y++) {
+        std::copy(&pixels[minX + (minY + y) * srcW], &pixels[minX + (minY + y) * srcW] + w, &tex[y * w]);
     }
     EASY_END_BLOCK;
 
-    if(!foundAnything) {
-        return;
-    }
-
     EASY_BLOCK("alloc data");
-    unsigned char* data = new unsigned char[texture->w * texture->h];
+    unsigned char* data = new unsigned char[w * h];
     EASY_END_BLOCK;
 
     EASY_BLOCK("alloc edgeSeen");
-    bool* edgeSeen = new bool[texture->w * texture->h];
+    bool* edgeSeen = new bool[w * h];
     EASY_END_BLOCK;
 
     EASY_BLOCK("init data and edgeSeen");
-    for(int y = 0; y < texture->h; y++) {
-        for(int x = 0; x < texture->w; x++) {
-            data[x + y * texture->w] = ((PIXEL(texture, x, y) >> 24) & 0xff) == 0x00 ? 0 : 1;
-            edgeSeen[x + y * texture->w] = false;
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            data[x + y * w] = ((tex[x + y * w] >> 24) & 0xff) == 0x00 ? 0 : 1;
+            edgeSeen[x + y * w] = false;
         }
     }
     EASY_END_BLOCK;
@@ -423,30 +538,30 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
     while(true) {
         inn++;
 
-        int lookX = lookIndex % texture->w;
-        int lookY = lookIndex / texture->w;
+        int lookX = lookIndex % w;
+        int lookY = lookIndex / w;
         if(inn == 1) {
-            lookX = texture->w / 2;
-            lookY = texture->h / 2;
+            lookX = w / 2;
+            lookY = h / 2;
         }
 
         int edgeX = -1;
         int edgeY = -1;
-        int size = texture->w * texture->h;
+        int size = w * h;
         for(int i = lookIndex; i < size; i++) {
             if(data[i] != 0) {
 
                 int numBorders = 0;
-                //if (i % texture->w - 1 >= 0) numBorders += data[(i % texture->w - 1) + i / texture->w * texture->w];
-                //if (i / texture->w - 1 >= 0) numBorders += data[(i % texture->w)+(i / texture->w - 1) * texture->w];
-                if(i % texture->w + 1 < texture->w) numBorders += data[(i % texture->w + 1) + i / texture->w * texture->w];
-                if(i / texture->w + 1 < texture->h) numBorders += data[(i % texture->w) + (i / texture->w + 1) * texture->w];
-                if(i / texture->w + 1 < texture->h && i % texture->w + 1 < texture->w) numBorders += data[(i % texture->w + 1) + (i / texture->w + 1) * texture->w];
+                //if (i % w - 1 >= 0) numBorders += data[(i % w - 1) + i / w * w];
+                //if (i / w - 1 >= 0) numBorders += data[(i % w)+(i / w - 1) * w];
+                if(i % w + 1 < w) numBorders += data[(i % w + 1) + i / w * w];
+                if(i / w + 1 < h) numBorders += data[(i % w) + (i / w + 1) * w];
+                if(i / w + 1 < h && i % w + 1 < w) numBorders += data[(i % w + 1) + (i / w + 1) * w];
 
-                //int val = value(i % texture->w, i / texture->w, texture->w, height, data);
+                //int val = value(i % w, i / w, w, height, data);
                 if(numBorders != 3) {
-                    edgeX = i % texture->w;
-                    edgeY = i / texture->w;
+                    edgeX = i % w;
+                    edgeY = i / w;
                     break;
                 }
             }
@@ -456,25 +571,25 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
             break;
         }
 
-        //MarchingSquares::Direction edge = MarchingSquares::FindEdge(texture->w, texture->h, data, lookX, lookY);
+        //MarchingSquares::Direction edge = MarchingSquares::FindEdge(w, h, data, lookX, lookY);
 
         lookX = edgeX;
         lookY = edgeY;
 
-        lookIndex = lookX + lookY * texture->w + 1;
+        lookIndex = lookX + lookY * w + 1;
 
-        if(edgeSeen[lookX + lookY * texture->w]) {
+        if(edgeSeen[lookX + lookY * w]) {
             inn--;
             continue;
         }
 
-        int val = MarchingSquares::value(lookX, lookY, texture->w, texture->h, data);
+        int val = MarchingSquares::value(lookX, lookY, w, h, data);
         if(val == 0 || val == 15) {
             inn--;
             continue;
         }
 
-        MarchingSquares::Result r = MarchingSquares::FindPerimeter(lookX, lookY, texture->w, texture->h, data);
+        MarchingSquares::Result r = MarchingSquares::FindPerimeter(lookX, lookY, w, h, data);
         results.push_back(r);
 
         std::vector<b2Vec2> worldMesh;
@@ -491,12 +606,12 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
                     int ily = (int)(lastY - iy * (r.directions[i].y < 0 ? -1 : 1));
 
                     if(ilx < 0) ilx = 0;
-                    if(ilx >= texture->w) ilx = texture->w - 1;
+                    if(ilx >= w) ilx = w - 1;
 
                     if(ily < 0) ily = 0;
-                    if(ily >= texture->h) ily = texture->h - 1;
+                    if(ily >= h) ily = h - 1;
 
-                    int ind = ilx + ily * texture->w;
+                    int ind = ilx + ily * w;
                     if(ind >= size) {
                         continue;
                     }
@@ -533,7 +648,6 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
     }
     EASY_END_BLOCK;
     delete[] edgeSeen;
-    delete[] data;
     std::list<TPPLPoly> result2;
 
     TPPLPartition part;
@@ -542,8 +656,6 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
     part.RemoveHoles(&shapes, &result2);
     EASY_END_BLOCK;
     std::vector<std::vector<b2PolygonShape>> polys2s = {};
-    std::vector<SDL_Surface*> polys2sSfcs = {};
-    std::vector<bool> polys2sWeld = {};
     for(auto it = result2.begin(); it != result2.end(); it++) {
         std::list<TPPLPoly> result;
         EASY_BLOCK("Triangulate_EC");
@@ -585,149 +697,244 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
 
         if(polys2.size() > 0) {
             polys2s.push_back(polys2);
-            EASY_BLOCK("SDL_CreateRGBSurfaceWithFormat", SDL_PROFILER_COLOR);
-            polys2sSfcs.push_back(SDL_CreateRGBSurfaceWithFormat(texture->flags, texture->w, texture->h, texture->format->BitsPerPixel, texture->format->format));
-            EASY_END_BLOCK;
-            polys2sWeld.push_back(false);
+            fragments.push_back(HitboxFragment());
+            fragments.back().pixels.assign(w * h, 0);
         }
 
     }
 
     if(polys2s.size() > 0) {
+        EASY_BLOCK("assign fragments");
+        // every component of the pixel mask belongs to the body whose triangles cover it
+        std::vector<int> labels;
+        int nComponents = labelComponents(data, w, h, labels);
+
+        std::vector<std::vector<int>> componentPixels(nComponents + 1);
+        for(int i = 0; i < w * h; i++) {
+            if(labels[i]) componentPixels[labels[i]].push_back(i);
+        }
 
-        EASY_BLOCK("calculate nearest");
-        std::vector<std::future<void>> poolResults = {};
-
-        if(texture->w > 10) {
-            int nThreads = updateRigidBodyHitboxPool->n_idle();
-            int div = texture->w / nThreads;
-            int rem = texture->w % nThreads;
-
-            for(int thr = 0; thr < nThreads; thr++) {
-                poolResults.push_back(updateRigidBodyHitboxPool->push([&, thr, div, rem](int id) {
-                    EASY_THREAD("Update RigidBody Thread");
-                    int stx = thr * div;
-                    int enx = stx + div + (thr == nThreads - 1 ? rem : 0);
-
-                    for(int x = stx; x < enx; x++) {
-                        for(int y = 0; y < texture->h; y++) {
-                            if(((PIXEL(texture, x, y) >> 24) & 0xff) == 0x00) continue;
-
-                            int nb = 0;
-
-                            int nearestDist = 100000;
-                            EASY_BLOCK("search");
-                            // for each body
-                            for(int b = 0; b < polys2s.size(); b++) {
-                                // for each triangle in the mesh
-                                for(int i = 0; i < polys2s[b].size(); i++) {
-                                    int dst = abs(x - polys2s[b][i].m_centroid.x) + abs(y - polys2s[b][i].m_centroid.y);
-                                    if(dst < nearestDist) {
-                                        nearestDist = dst;
-                                        nb = b;
-                                    }
-                                }
-                            }
-                            EASY_END_BLOCK;
-                            EASY_BLOCK("copy pixels");
-                            PIXEL(polys2sSfcs[nb], x, y) = PIXEL(texture, x, y);
-                            if(x == rb->weldX && y == rb->weldY) polys2sWeld[nb] = true;
-                            EASY_END_BLOCK;
-                        }
-                    }
-                }));
-            }
-
-        } else {
-            for(int x = 0; x < texture->w; x++) {
-                for(int y = 0; y < texture->h; y++) {
-                    if(((PIXEL(texture, x, y) >> 24) & 0xff) == 0x00) continue;
-
-                    int nb = 0;
-
-                    int nearestDist = 100000;
-                    EASY_BLOCK("search");
-                    // for each body
-                    for(int b = 0; b < polys2s.size(); b++) {
-                        // for each triangle in the mesh
-                        for(int i = 0; i < polys2s[b].size(); i++) {
-                            int dst = abs(x - polys2s[b][i].m_centroid.x) + abs(y - polys2s[b][i].m_centroid.y);
-                            if(dst < nearestDist) {
-                                nearestDist = dst;
-                                nb = b;
-                            }
+        // -1 for components no triangle covers (simplified away, or too small to get a mesh), those go pixel by pixel
+        std::vector<int> componentBody(nComponents + 1, -1);
+        b2Transform ident;
+        ident.SetIdentity();
+        for(int c = 1; c <= nComponents; c++) {
+            const std::vector<int>& px = componentPixels[c];
+            // a few pixels spread over the component, since ones on the edge can be outside the simplified outline
+            for(int s = 0; s < 4 && componentBody[c] == -1; s++) {
+                int i = px[px.size() * (s * 2 + 1) / 8];
+                b2Vec2 p((float)(i % w) + 0.5f, (float)(i / w) + 0.5f);
+                for(int b = 0; b < polys2s.size() && componentBody[c] == -1; b++) {
+                    for(auto& tri : polys2s[b]) {
+                        if(tri.TestPoint(ident, p)) {
+                            componentBody[c] = b;
+                            break;
                         }
                     }
-                    EASY_END_BLOCK;
-                    EASY_BLOCK("copy pixels");
-                    PIXEL(polys2sSfcs[nb], x, y) = PIXEL(texture, x, y);
-                    if(x == rb->weldX && y == rb->weldY) polys2sWeld[nb] = true;
-                    EASY_END_BLOCK;
                 }
             }
         }
 
-        EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
-        for(int i = 0; i < poolResults.size(); i++) {
-            EASY_BLOCK("get");
-            poolResults[i].get();
-            EASY_END_BLOCK;
+        CentroidGrid* grid = nullptr;
+        for(int c = 1; c <= nComponents; c++) {
+            int nb = componentBody[c];
+            if(nb == -1 && grid == nullptr) grid = new CentroidGrid(polys2s, w, h);
+
+            for(int i : componentPixels[c]) {
+                int x = i % w;
+                int y = i / w;
+                int b = nb == -1 ? grid->nearest(x, y) : nb;
+                fragments[b].pixels[i] = tex[i];
+                if(x == weldX && y == weldY) fragments[b].weld = true;
+            }
         }
+        delete grid;
         EASY_END_BLOCK;
+
+        for(int b = 0; b < polys2s.size(); b++) fragments[b].triangles = std::move(polys2s[b]);
+    }
+    delete[] data;
+
+    outline = shapes;
+
+    // each new body gets its own pass to trim it
+    split = result2.size() > 1;
+    if(result2.size() == 2 && (result2.front().GetNumPoints() <= 3 || result2.back().GetNumPoints() <= 3)) {
+        // weird edge case that causes infinite recursion
+        // TODO: actually figure out why that happens
+        split = false;
+    }
+}
+
+void World::updateRigidBodyHitbox(RigidBody* rb) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    HitboxJob job;
+    snapshotHitbox(rb, job);
+    job.build();
+    applyHitbox(rb, job, false);
+}
+
+void World::snapshotHitbox(RigidBody* rb, HitboxJob& job) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    job.rb = rb;
+    job.tilesVersion = rb->tilesVersion;
+    job.srcW = rb->surface->w;
+    job.srcH = rb->surface->h;
+    job.weldX = rb->weldX;
+    job.weldY = rb->weldY;
+    job.pixels.resize(job.srcW * job.srcH);
+    for(int i = 0; i < job.srcW * job.srcH; i++) {
+        MaterialInstance mat = rb->tiles[i];
+        if(mat.mat->id == Materials::GENERIC_AIR.id) {
+            job.pixels[i] = 0x00000000;
+        } else {
+            job.pixels[i] = (mat.mat->alpha << 24) + (mat.color & 0x00ffffff);
+        }
+    }
+}
+
+void World::queueHitbox(RigidBody* rb) {
+    HitboxJob* job = new HitboxJob();
+    snapshotHitbox(rb, *job);
+
+    if(++nextHitboxJob == 0) nextHitboxJob++;
+    job->id = nextHitboxJob;
+    rb->hitboxJob = job->id;
+    rb->needsUpdate = false;
+
+    job->done = updateRigidBodyHitboxPool->push([job](int id) {
+        EASY_THREAD("Update RigidBody Thread");
+        job->build();
+    });
+    hitboxJobs.push_back(job);
+}
+
+void World::finishHitboxJobs(bool wait) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    for(size_t i = 0; i < hitboxJobs.size();) {
+        HitboxJob* job = hitboxJobs[i];
+        if(!wait && job->done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            i++;
+            continue;
+        }
+
+        EASY_BLOCK("wait for job", THREAD_WAIT_PROFILER_COLOR);
+        job->done.get();
         EASY_END_BLOCK;
 
-        for(int b = 0; b < polys2s.size(); b++) {
-            std::vector<b2PolygonShape> polys2 = polys2s[b];
-
-            SDL_Surface* sfc = polys2sSfcs[b];
-
-            EASY_BLOCK("make new rigidbody");
-            RigidBody* rbn = makeRigidBodyMulti(b2_dynamicBody, 0, 0, rb->body->GetAngle(), polys2, rb->body->GetFixtureList()[0].GetDensity(), rb->body->GetFixtureList()[0].GetFriction(), sfc);
-            rbn->body->SetTransform(b2Vec2(rb->body->GetPosition().x, rb->body->GetPosition().y), rb->body->GetAngle());
-            rbn->body->SetLinearVelocity(rb->body->GetLinearVelocity());
-            rbn->body->SetAngularVelocity(rb->body->GetAngularVelocity());
-            rbn->outline = shapes;
-            rbn->texNeedsUpdate = true;
-            rbn->hover = rb->hover;
-
-            bool weld = polys2sWeld[b];
-            rbn->back = weld;
-            if(weld) {
-                b2WeldJointDef weldJ;
-                weldJ.bodyA = rbn->body;
-                weldJ.bodyB = staticBody->body;
-                weldJ.localAnchorA = -rbn->body->GetPosition();
-
-                b2world->CreateJoint(&weldJ);
-
-                rbn->weldX = rb->weldX;
-                rbn->weldY = rb->weldY;
-
-                b2Filter bf = {};
-                bf.categoryBits = 0x0002;
-                bf.maskBits = 0x0000;
-                for(b2Fixture* f = rbn->body->GetFixtureList(); f; f = f->GetNext()) {
-                    f->SetFilterData(bf);
-                }
+        // the body could have been removed (or rebuilt some other way) since the job was queued
+        RigidBody* rb = job->rb;
+        if(std::find(rigidBodies.begin(), rigidBodies.end(), rb) != rigidBodies.end() && rb->hitboxJob == job->id) {
+            rb->hitboxJob = 0;
+            if(!rb->needsUpdate && rb->tilesVersion == job->tilesVersion && rb->body->IsEnabled()) {
+                applyHitbox(rb, *job, true);
             } else {
-                for(b2Fixture* f = rbn->body->GetFixtureList(); f; f = f->GetNext()) {
-                    f->SetFilterData(rb->body->GetFixtureList()[0].GetFilterData());
-                }
+                // tiles changed while it was building (or it can't be updated right now),
+                // so it has to go again (tickObjectsMesh queues it right after this)
+                rb->needsUpdate = true;
             }
+        }
 
-            rbn->item = rb->item;
-            rigidBodies.push_back(rbn);
+        delete job;
+        hitboxJobs.erase(hitboxJobs.begin() + i);
+    }
+}
 
-            if(result2.size() > 1) {
-                if(result2.size() == 2 && (result2.front().GetNumPoints() <= 3 || result2.back().GetNumPoints() <= 3)) {
-                    // weird edge case that causes infinite recursion
-                    // TODO: actually figure out why that happens
-                } else {
-                    updateRigidBodyHitbox(rbn);
-                }
+void World::applyHitbox(RigidBody* rb, HitboxJob& job, bool async) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    if(job.w <= 0 || job.h <= 0) {
+        b2world->DestroyBody(rb->body);
+        rigidBodies.erase(std::remove(rigidBodies.begin(), rigidBodies.end(), rb), rigidBodies.end());
+        return;
+    }
+
+    EASY_BLOCK("init");
+    SDL_Surface* texture = rb->surface;
+    SDL_Surface* sf = SDL_CreateRGBSurfaceWithFormat(texture->flags, job.w, job.h, texture->format->BitsPerPixel, texture->format->format);
+    for(int y = 0; y < job.h; y++) {
+        for(int x = 0; x < job.w; x++) {
+            PIXEL(sf, x, y) = job.pixels[(job.minX + x) + (job.minY + y) * job.srcW];
+        }
+    }
+
+    SDL_FreeSurface(texture);
+
+    rb->surface = sf;
+    texture = rb->surface;
+
+    float s = sin(rb->body->GetAngle());
+    float c = cos(rb->body->GetAngle());
+
+    // rotate point
+    float xnew = job.minX * c - job.minY * s;
+    float ynew = job.minX * s + job.minY * c;
+
+    // translate point back:
+    rb->body->SetTransform(b2Vec2(rb->body->GetPosition().x + xnew, rb->body->GetPosition().y + ynew), rb->body->GetAngle());
+    EASY_END_BLOCK;
+
+    for(int b = 0; b < job.fragments.size(); b++) {
+        HitboxFragment& frag = job.fragments[b];
+
+        EASY_BLOCK("SDL_CreateRGBSurfaceWithFormat", SDL_PROFILER_COLOR);
+        SDL_Surface* sfc = SDL_CreateRGBSurfaceWithFormat(texture->flags, texture->w, texture->h, texture->format->BitsPerPixel, texture->format->format);
+        for(int y = 0; y < job.h; y++) {
+            for(int x = 0; x < job.w; x++) {
+                PIXEL(sfc, x, y) = frag.pixels[x + y * job.w];
             }
-            EASY_END_BLOCK;
         }
+        EASY_END_BLOCK;
+
+        EASY_BLOCK("make new rigidbody");
+        RigidBody* rbn = makeRigidBodyMulti(b2_dynamicBody, 0, 0, rb->body->GetAngle(), frag.triangles, rb->body->GetFixtureList()[0].GetDensity(), rb->body->GetFixtureList()[0].GetFriction(), sfc);
+        rbn->body->SetTransform(b2Vec2(rb->body->GetPosition().x, rb->body->GetPosition().y), rb->body->GetAngle());
+        rbn->body->SetLinearVelocity(rb->body->GetLinearVelocity());
+        rbn->body->SetAngularVelocity(rb->body->GetAngularVelocity());
+        rbn->outline = job.outline;
+        rbn->texNeedsUpdate = true;
+        rbn->hover = rb->hover;
+
+        bool weld = frag.weld;
+        rbn->back = weld;
+        if(weld) {
+            b2WeldJointDef weldJ;
+            weldJ.bodyA = rbn->body;
+            weldJ.bodyB = staticBody->body;
+            weldJ.localAnchorA = -rbn->body->GetPosition();
+
+            b2world->CreateJoint(&weldJ);
+
+            rbn->weldX = rb->weldX;
+            rbn->weldY = rb->weldY;
+
+            b2Filter bf = {};
+            bf.categoryBits = 0x0002;
+            bf.maskBits = 0x0000;
+            for(b2Fixture* f = rbn->body->GetFixtureList(); f; f = f->GetNext()) {
+                f->SetFilterData(bf);
+            }
+        } else {
+            for(b2Fixture* f = rbn->body->GetFixtureList(); f; f = f->GetNext()) {
+                f->SetFilterData(rb->body->GetFixtureList()[0].GetFilterData());
+            }
+        }
+
+        rbn->item = rb->item;
+        rigidBodies.push_back(rbn);
+
+        if(job.split) {
+            // queued jobs leave the pieces for the next tickObjectsMesh instead of building them right here
+            if(async) {
+                rbn->needsUpdate = true;
+            } else {
+                updateRigidBodyHitbox(rbn);
+            }
+        }
+        EASY_END_BLOCK;
     }
 
     EASY_BLOCK("DestroyBody");
@@ -743,19 +950,26 @@ void World::updateRigidBodyHitbox(RigidBody* rb) {
     delete rb;
 
 }
+uint64_t World::chunkSolidHash(int chTx, int chTy) {
+    uint64_t hash = 0;
+    for(int y = 0; y < CHUNK_H; y++) {
+        MaterialInstance* row = &tiles[chTx + (y + chTy) * width];
+        for(int x = 0; x < CHUNK_W; x += 64) {
+            uint64_t bits = 0;
+            for(int b = 0; b < 64 && x + b < CHUNK_W; b++) {
+                if(row[x + b].mat->physicsType == PhysicsType::SOLID) bits |= 1ull << b;
+            }
+            hash = (hash ^ bits) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 32;
+        }
+    }
+    return hash;
+}
 
-void World::updateChunkMesh(Chunk* chunk) {
-
-    /*EASY_BLOCK("Destroy old bodies");
-    if (chunk->rb != nullptr) b2world->DestroyBody(chunk->rb->body);
-    EASY_END_BLOCK;*/
-
-    int chTx = chunk->x * CHUNK_W + loadZone.x;
-    int chTy = chunk->y * CHUNK_H + loadZone.y;
+void World::buildChunkPolys(Chunk* chunk, int chTx, int chTy) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
 
-    if(chTx < 0 || chTy < 0 || chTx + CHUNK_W >= width || chTy + CHUNK_H >= height) {
-        return;
-    }
+    chunk->polys.clear();
 
     #pragma region
     EASY_BLOCK("foundAnything loop");
@@ -965,8 +1179,6 @@ found: {};
     //Ps::MarchingSquares ms = Ps::MarchingSquares(texture);
     //worldMesh = ms.extract_simple(2);
 
-    chunk->polys.clear();
-
     EASY_BLOCK("conv TPPLPolys to b2PolygonShapes");
     std::for_each(result.begin(), result.end(), [&](TPPLPoly cur) {
         if(cur[0].x == cur[1].x && cur[1].x == cur[2].x) {
@@ -990,18 +1202,106 @@ found: {};
     });
     EASY_END_BLOCK;
     #pragma endregion
+}
 
-    EASY_BLOCK("loadTexture");
-    SDL_Surface* texture = Textures::loadTexture("assets/objects/testObject3.png");
+void World::buildChunkBoxes(Chunk* chunk, int chTx, int chTy) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    chunk->polys.clear();
+
+    // a box covering x0 to x1 (exclusive) from row y0 down to the current row
+    struct Box {
+        int x0;
+        int x1;
+        int y0;
+    };
+
+    auto emit = [&](const Box& b, int y1) {
+        float hw = (b.x1 - b.x0) / 2.0f;
+        float hh = (y1 - b.y0) / 2.0f;
+        b2PolygonShape sh;
+        sh.SetAsBox(hw, hh, b2Vec2(b.x0 + hw, b.y0 + hh), 0);
+        chunk->polys.push_back(sh);
+    };
+
+    // both lists are sorted by x0 (runs in a row don't overlap), so matching a row against the open boxes is one merge
+    std::vector<Box> open;
+    std::vector<Box> next;
+    for(int y = 0; y <= CHUNK_H; y++) {
+        next.clear();
+        size_t o = 0;
+
+        if(y < CHUNK_H) {
+            MaterialInstance* row = &tiles[chTx + (y + chTy) * width];
+            int x = 0;
+            while(x < CHUNK_W) {
+                if(row[x].mat->physicsType != PhysicsType::SOLID) {
+                    x++;
+                    continue;
+                }
+
+                int x0 = x;
+                while(x < CHUNK_W && row[x].mat->physicsType == PhysicsType::SOLID) x++;
+
+                // boxes that started left of this run can't continue
+                while(o < open.size() && open[o].x0 < x0) emit(open[o++], y);
+
+                if(o < open.size() && open[o].x0 == x0 && open[o].x1 == x) {
+                    next.push_back(open[o++]);
+                } else {
+                    next.push_back({x0, x, y});
+                }
+            }
+        }
+
+        while(o < open.size()) emit(open[o++], y);
+        std::swap(open, next);
+    }
+}
+
+void World::updateChunkMesh(Chunk* chunk) {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    int chTx = chunk->x * CHUNK_W + loadZone.x;
+    int chTy = chunk->y * CHUNK_H + loadZone.y;
+
+    if(chTx < 0 || chTy < 0 || chTx + CHUNK_W >= width || chTy + CHUNK_H >= height) {
+        releaseChunkMesh(chunk);
+        return;
+    }
+
+    EASY_BLOCK("chunkSolidHash");
+    uint64_t hash = chunkSolidHash(chTx, chTy);
     EASY_END_BLOCK;
 
+    if(!chunk->meshValid || chunk->meshHash != hash || chunk->meshBoxes != Settings::tick_box_colliders) {
+        releaseChunkMesh(chunk);
+        if(Settings::tick_box_colliders) {
+            buildChunkBoxes(chunk, chTx, chTy);
+        } else {
+            buildChunkPolys(chunk, chTx, chTy);
+        }
+        chunk->meshHash = hash;
+        chunk->meshBoxes = Settings::tick_box_colliders;
+        chunk->meshValid = true;
+    }
+
+    if(chunk->polys.empty()) return;
+
     if(chunk->rb) {
-        delete[] chunk->rb->tiles;
-        GPU_FreeImage(chunk->rb->texture);
-        SDL_FreeSurface(chunk->rb->surface);
-        delete chunk->rb;
+        // same cells, the grid just scrolled with loadZone
+        b2Vec2 pos = chunk->rb->body->GetPosition();
+        if(pos.x != chTx || pos.y != chTy) {
+            chunk->rb->body->SetTransform(b2Vec2((float)chTx, (float)chTy), 0);
+        }
+        return;
     }
-    chunk->rb = makeRigidBodyMulti(b2_staticBody, chunk->x * CHUNK_W + loadZone.x, chunk->y * CHUNK_H + loadZone.y, 0, chunk->polys, 1, 0.3, texture);
+
+    EASY_BLOCK("loadTexture");
+    SDL_Surface* texture = Textures::loadTexture("assets/objects/testObject3.png");
+    EASY_END_BLOCK;
+
+    chunk->rb = makeRigidBodyMulti(b2_staticBody, chTx, chTy, 0, chunk->polys, 1, 0.3, texture);
 
     EASY_BLOCK("set filters");
     for(b2Fixture* f = chunk->rb->body->GetFixtureList(); f; f = f->GetNext()) {
@@ -1012,6 +1312,21 @@ found: {};
     EASY_END_BLOCK;
 
     worldRigidBodies.push_back(chunk->rb);
+    meshChunks.push_back(chunk);
+}
+
+void World::releaseChunkMesh(Chunk* chunk) {
+    if(!chunk->rb) return;
+
+    b2world->DestroyBody(chunk->rb->body);
+    worldRigidBodies.erase(std::remove(worldRigidBodies.begin(), worldRigidBodies.end(), chunk->rb), worldRigidBodies.end());
+    meshChunks.erase(std::remove(meshChunks.begin(), meshChunks.end(), chunk), meshChunks.end());
+
+    delete[] chunk->rb->tiles;
+    GPU_FreeImage(chunk->rb->texture);
+    SDL_FreeSurface(chunk->rb->surface);
+    delete chunk->rb;
+    chunk->rb = nullptr;
 }
 
 void World::updateWorldMesh() {
@@ -1033,20 +1348,35 @@ void World::updateWorldMesh() {
     int maxChX = (int)ceil((meshZone.x + meshZone.w - loadZone.x) / CHUNK_W);
     int maxChY = (int)ceil((meshZone.y + meshZone.h - loadZone.y) / CHUNK_H);
 
-    EASY_BLOCK("Destroy old bodies");
-    for(int i = 0; i < worldRigidBodies.size(); i++) {
-        b2world->DestroyBody(worldRigidBodies[i]->body);
+    // chunks that aren't loaded only get a temporary Chunk from getChunk, so their bodies are rebuilt every pass
+    for(Chunk* ch : meshTempChunks) {
+        releaseChunkMesh(ch);
+        delete ch;
+    }
+    meshTempChunks.clear();
+
+    meshStamp++;
+    if(meshZone.w != 0 && meshZone.h != 0) {
+        for(int cx = minChX; cx <= maxChX; cx++) {
+            for(int cy = minChY; cy <= maxChY; cy++) {
+                Chunk* ch = getChunk(cx, cy);
+                if(ch->pleaseDelete) meshTempChunks.push_back(ch);
+                ch->meshStamp = meshStamp;
+                updateChunkMesh(ch);
+            }
+        }
     }
-    worldRigidBodies.clear();
-    EASY_END_BLOCK;
-
-    if(meshZone.w == 0 || meshZone.h == 0) return;
 
-    for(int cx = minChX; cx <= maxChX; cx++) {
-        for(int cy = minChY; cy <= maxChY; cy++) {
-            updateChunkMesh(getChunk(cx, cy));
+    // chunks that left meshZone keep their polys in case they come back, but not their bodies
+    EASY_BLOCK("Destroy old bodies");
+    for(size_t i = 0; i < meshChunks.size();) {
+        if(meshChunks[i]->meshStamp != meshStamp) {
+            releaseChunkMesh(meshChunks[i]);
+        } else {
+            i++;
         }
     }
+    EASY_END_BLOCK;
 
 }
 
@@ -1058,7 +1388,40 @@ MaterialInstance World::getTile(int x, int y) {
 void World::setTile(int x, int y, MaterialInstance type) {
     if(x < 0 || x >= width || y < 0 || y >= height) return;
     tiles[x + y * width] = type;
-    dirty[x + y * width] = true;
+    markDirty(x, y);
+    markActive(x, y);
+}
+
+void World::markActive(int x, int y) {
+    // 1 tile halo so neighbors get a chance to react to the change
+    markActive(x - 1, y - 1, 3, 3);
+}
+
+void World::markActive(int x, int y, int w, int h) {
+    // NOTE: not thread safe, tick() accumulates its own rects per chunk and merges them after each pass
+    int x1 = std::max(x, 0);
+    int y1 = std::max(y, 0);
+    int x2 = std::min(x + w, (int)width);
+    int y2 = std::min(y + h, (int)height);
+    if(x1 >= x2 || y1 >= y2) return;
+
+    for(int chy = y1 / CHUNK_H; chy <= (y2 - 1) / CHUNK_H; chy++) {
+        for(int chx = x1 / CHUNK_W; chx <= (x2 - 1) / CHUNK_W; chx++) {
+            int rx1 = std::max(x1, chx * CHUNK_W);
+            int ry1 = std::max(y1, chy * CHUNK_H);
+            int rx2 = std::min(x2, (chx + 1) * CHUNK_W);
+            int ry2 = std::min(y2, (chy + 1) * CHUNK_H);
+
+            SDL_Rect& r = active[chx + chy * activeW];
+            if(r.w > 0 && r.h > 0) {
+                rx1 = std::min(rx1, r.x);
+                ry1 = std::min(ry1, r.y);
+                rx2 = std::max(rx2, r.x + r.w);
+                ry2 = std::max(ry2, r.y + r.h);
+            }
+            r = {rx1, ry1, rx2 - rx1, ry2 - ry1};
+        }
+    }
 }
 
 MaterialInstance World::getTileLayer2(int x, int y) {
@@ -1069,7 +1432,311 @@ MaterialInstance World::getTileLayer2(int x, int y) {
 void World::setTileLayer2(int x, int y, MaterialInstance type) {
     if(x < 0 || x >= width || y < 0 || y >= height) return;
     layer2[x + y * width] = type;
-    layer2Dirty[x + y * width] = true;
+    markLayer2Dirty(x, y);
+}
+
+uint16_t World::nextTickEpoch() {
+    // a stamp in tickVisited only means something if it's the current epoch, so nothing has to be cleared
+    // (except once every 65535 epochs when it wraps around)
+    if(++tickVisitedEpoch == 0) {
+        EASY_BLOCK("memset");
+        memset(tickVisited, 0, (size_t)width * height * sizeof(uint16_t));
+        EASY_END_BLOCK;
+        tickVisitedEpoch = 1;
+    }
+    return tickVisitedEpoch;
+}
+
+void World::updateLod() {
+    if(chunkLod.size() != activeW * activeH) {
+        chunkLod.resize(activeW * activeH);
+        chunkTicking.resize(activeW * activeH);
+    }
+
+    SDL_Rect focus = lodFocus.w > 0 ? lodFocus : tickZone;
+    for(int ci = 0; ci < activeW * activeH; ci++) {
+        int chx = ci % activeW;
+        int chy = ci / activeW;
+        if(!Settings::tick_lod) {
+            chunkLod[ci] = LOD_FULL;
+            chunkTicking[ci] = 1;
+            continue;
+        }
+
+        // rings of chunks around the focus (0 if the chunk overlaps it)
+        int x = chx * CHUNK_W;
+        int y = chy * CHUNK_H;
+        int dx = std::max(std::max(focus.x - (x + CHUNK_W), x - (focus.x + focus.w)), 0);
+        int dy = std::max(std::max(focus.y - (y + CHUNK_H), y - (focus.y + focus.h)), 0);
+        int ring = (std::max(dx, dy) + CHUNK_W - 1) / CHUNK_W;
+
+        Uint8 lod = ring <= 1 ? LOD_FULL : ring == 2 ? LOD_HALF : ring <= 4 ? LOD_QUARTER : LOD_SETTLE;
+        int period = 1 << std::min((int)lod, (int)LOD_QUARTER);
+        // spread out so not every chunk in a ring lands on the same tick
+        int phase = chx + chy * 3;
+        chunkLod[ci] = lod;
+        chunkTicking[ci] = ((tickCt + phase) & (period - 1)) == 0;
+    }
+}
+
+void World::markWoken(int ci, const SDL_Rect& r) {
+    if(chunkLod.empty() || chunkLod[ci] != LOD_SETTLE) {
+        markActive(r.x, r.y, r.w, r.h);
+        return;
+    }
+
+    // split like markActive does and leave out other settling chunks
+    int x1 = std::max(r.x, 0);
+    int y1 = std::max(r.y, 0);
+    int x2 = std::min(r.x + r.w, (int)width);
+    int y2 = std::min(r.y + r.h, (int)height);
+    for(int chy = y1 / CHUNK_H; x1 < x2 && chy <= (y2 - 1) / CHUNK_H; chy++) {
+        for(int chx = x1 / CHUNK_W; chx <= (x2 - 1) / CHUNK_W; chx++) {
+            int cj = chx + chy * activeW;
+            if(cj != ci && chunkLod[cj] == LOD_SETTLE) continue;
+
+            int rx1 = std::max(x1, chx * CHUNK_W);
+            int ry1 = std::max(y1, chy * CHUNK_H);
+            int rx2 = std::min(x2, (chx + 1) * CHUNK_W);
+            int ry2 = std::min(y2, (chy + 1) * CHUNK_H);
+            markActive(rx1, ry1, rx2 - rx1, ry2 - ry1);
+        }
+    }
+}
+
+bool World::chunkInTickZone(int ci) {
+    int cx = (ci % activeW) * CHUNK_W;
+    int cy = (ci / activeW) * CHUNK_H;
+    return cx >= tickZone.x && cy >= tickZone.y && cx < tickZone.x + tickZone.w && cy < tickZone.y + tickZone.h;
+}
+
+void World::runChunkLists(std::vector<std::vector<int>>& lists, std::vector<std::vector<int>>& spill, std::function<SDL_Rect(int ci, int tk, int task, int worker)> step, std::function<void(int index)> dropped) {
+    std::vector<int> tasks;
+    tasks.reserve(activeW * activeH);
+    std::vector<SDL_Rect> woke(activeW * activeH);
+
+    // same checkerboard as tick() so neighboring chunks never run at the same time
+    for(int tk = 0; tk < 4; tk++) {
+        tasks.clear();
+        for(int ci = 0; ci < activeW * activeH; ci++) {
+            if(lists[ci].empty() || !chunkTicksNow(ci)) continue;
+            if((ci % activeW) % 2 != tk % 2 || (ci / activeW) % 2 != tk / 2) continue;
+            tasks.push_back(ci);
+        }
+        if(tasks.empty()) continue;
+
+        auto runTask = [&](int task, int worker) {
+            woke[task] = step(tasks[task], tk, task, worker);
+        };
+        tickScheduler->run((int)tasks.size(), runTask);
+
+        EASY_BLOCK("merge");
+        for(int i = 0; i < (int)tasks.size(); i++) {
+            if(woke[i].w > 0) markWoken(tasks[i], woke[i]);
+
+            std::vector<int>& sp = spill[tasks[i]];
+            for(int index : sp) {
+                int ci = ((index % width) / CHUNK_W) + ((index / width) / CHUNK_H) * activeW;
+                if(chunkInTickZone(ci)) {
+                    lists[ci].push_back(index);
+                } else if(dropped) {
+                    dropped(index);
+                }
+            }
+            sp.clear();
+        }
+        EASY_END_BLOCK;
+    }
+}
+
+void World::tickReactive() {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    if(fireCells.size() != activeW * activeH) {
+        fireCells.resize(activeW * activeH);
+        fireSpill.resize(activeW * activeH);
+    }
+
+    // temperature reactions tickTemperature found since last tick
+    // only those cells are looked at, everything else that can react is too cold/hot to
+    EASY_BLOCK("react");
+    RNG::local().setSeed(RNG::hash(tickCt, 0x4ea));
+    for(int index : reactPending) {
+        int nRules;
+        const MaterialInteraction* rules = CellGrid::reactionRules(cells.material[index], &nRules);
+
+        int32_t temperature = tiles[index].temperature;
+        for(int i = 0; i < nRules; i++) {
+            const MaterialInteraction& in = rules[i];
+            if((in.type == REACT_TEMPERATURE_BELOW && temperature < in.data1) || (in.type == REACT_TEMPERATURE_ABOVE && temperature > in.data1)) {
+                int x = index % width;
+                int y = index / width;
+                bool wasSolid = CellGrid::props[cells.material[index]].physicsType == PhysicsType::SOLID;
+                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
+                tiles[index].temperature = temperature;
+                cells.material[index] = (Uint16)tiles[index].mat->id;
+                if(wasSolid && tiles[index].mat->physicsType != PhysicsType::SOLID && Settings::tick_island_events) solidRemoved.push_back(index);
+                markDirty(x, y);
+                markActive(x, y);
+                break;
+            }
+        }
+    }
+    reactPending.clear();
+    EASY_END_BLOCK;
+
+    // fire that spread out of tickZone goes back into the lists once its chunk is in it again
+    EASY_BLOCK("gather fire");
+    size_t nPending = 0;
+    for(int index : firePending) {
+        int ci = ((index % width) / CHUNK_W) + ((index / width) / CHUNK_H) * activeW;
+        if(!chunkInTickZone(ci)) {
+            firePending[nPending++] = index;
+        } else if(cells.material[index] == Materials::FIRE.id) {
+            fireCells[ci].push_back(index);
+        } else {
+            fireListed[index] = 0;
+        }
+    }
+    firePending.resize(nPending);
+
+    // fire that was placed/loaded/etc since last tick (anything written outside of tick() is marked active)
+    for(int ci = 0; ci < activeW * activeH; ci++) {
+        SDL_Rect r = lastActive[ci];
+        if(r.w <= 0 || r.h <= 0 || !chunkInTickZone(ci)) continue;
+
+        for(int y = r.y; y < r.y + r.h; y++) {
+            for(int x = r.x; x < r.x + r.w; x++) {
+                int index = x + y * width;
+                if(cells.material[index] == Materials::FIRE.id && !fireListed[index]) {
+                    fireListed[index] = 1;
+                    fireCells[ci].push_back(index);
+                }
+            }
+        }
+    }
+    EASY_END_BLOCK;
+
+    // fire spreading into chunks outside the tick zone waits in firePending (still listed) until they come back
+    runChunkLists(fireCells, fireSpill, [&](int ci, int tk, int task, int worker) {
+        int cx = (ci % activeW) * CHUNK_W;
+        int cy = (ci / activeW) * CHUNK_H;
+
+        RNG& rng = RNG::local();
+        rng.setSeed(RNG::hash(tickCt, 0xf1e, cx, cy));
+
+        uint32_t passKey = (uint32_t)(0xff00 + tk) << 16;
+        ChunkTick chunk(this, cx, cy, {cx, cy, CHUNK_W, CHUNK_H}, 0, false, 0, rng, tickSpawned[worker], passKey | (uint32_t)task);
+        if(Settings::tick_island_events) {
+            if(tickSolidRemoved.size() != tickScheduler->size()) tickSolidRemoved.resize(tickScheduler->size());
+            chunk.solidRemoved = &tickSolidRemoved[worker];
+        }
+        chunk.fireStep(fireCells[ci], fireSpill[ci], fireListed);
+        return chunk.woken();
+    }, [&](int index) {
+        firePending.push_back(index);
+    });
+}
+
+void World::shiftReactive(int dx, int dy) {
+    std::vector<int> fire;
+    for(auto& list : fireCells) {
+        fire.insert(fire.end(), list.begin(), list.end());
+        list.clear();
+    }
+    fire.insert(fire.end(), firePending.begin(), firePending.end());
+    firePending.clear();
+    memset(fireListed, 0, (size_t)width * height);
+
+    for(int index : fire) {
+        int x = index % width + dx;
+        int y = index / width + dy;
+        if(x < 0 || y < 0 || x >= width || y >= height) continue;
+
+        int ni = x + y * width;
+        int ci = (x / CHUNK_W) + (y / CHUNK_H) * activeW;
+        if(fireListed[ni]) continue;
+        fireListed[ni] = 1;
+        if(chunkInTickZone(ci)) {
+            fireCells[ci].push_back(ni);
+        } else {
+            firePending.push_back(ni);
+        }
+    }
+
+    // tickTemperature finds these again next time
+    reactPending.clear();
+}
+
+void World::tickLiquids() {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+
+    int substeps = std::max(Settings::tick_liquid_substeps, 1);
+    if(liquidCells.size() != activeW * activeH) {
+        liquidCells.resize(activeW * activeH);
+        liquidSpill.resize(activeW * activeH);
+    }
+
+    // all the liquid in whatever was active this tick (anything else is settled and nothing around it changed)
+    EASY_BLOCK("gather");
+    for(int ci = 0; ci < activeW * activeH; ci++) {
+        liquidCells[ci].clear();
+        liquidSpill[ci].clear();
+        if(!chunkTicksNow(ci)) continue;
+
+        int cx = (ci % activeW) * CHUNK_W;
+        int cy = (ci / activeW) * CHUNK_H;
+        SDL_Rect r = {cx, cy, CHUNK_W, CHUNK_H};
+        if(Settings::tick_sleep_chunks) {
+            SDL_Rect a = lastActive[ci];
+            SDL_Rect b = active[ci];
+            bool hasA = a.w > 0 && a.h > 0;
+            bool hasB = b.w > 0 && b.h > 0;
+            if(!hasA && !hasB) continue;
+            int x1 = std::min(hasA ? a.x : INT_MAX, hasB ? b.x : INT_MAX);
+            int y1 = std::min(hasA ? a.y : INT_MAX, hasB ? b.y : INT_MAX);
+            int x2 = std::max(hasA ? a.x + a.w : INT_MIN, hasB ? b.x + b.w : INT_MIN);
+            int y2 = std::max(hasA ? a.y + a.h : INT_MIN, hasB ? b.y + b.h : INT_MIN);
+            r = {x1, y1, x2 - x1, y2 - y1};
+        }
+
+        for(int y = r.y; y < r.y + r.h; y++) {
+            for(int x = r.x; x < r.x + r.w; x++) {
+                int index = x + y * width;
+                if(CellGrid::props[cells.material[index]].physicsType == PhysicsType::SOUP) liquidCells[ci].push_back(index);
+            }
+        }
+    }
+    EASY_END_BLOCK;
+
+    for(int sub = 0; sub < substeps; sub++) {
+        EASY_BLOCK("substep");
+
+        // every listed cell gets this substep's stamp, ChunkTick::liquidStep uses it to not list anything twice
+        const uint16_t epoch = nextTickEpoch();
+        bool any = false;
+        for(auto& list : liquidCells) {
+            for(int index : list) tickVisited[index] = epoch;
+            any |= !list.empty();
+        }
+        if(!any) break;
+
+        // flow into other chunks gets applied when they run (this substep or the next)
+        runChunkLists(liquidCells, liquidSpill, [&](int ci, int tk, int task, int worker) {
+            int cx = (ci % activeW) * CHUNK_W;
+            int cy = (ci / activeW) * CHUNK_H;
+
+            RNG& rng = RNG::local();
+            rng.setSeed(RNG::hash(tickCt, 6 + sub, cx, cy));
+
+            uint32_t passKey = (uint32_t)(24 + sub * 4 + tk) << 16;
+            ChunkTick chunk(this, cx, cy, {cx, cy, CHUNK_W, CHUNK_H}, sub, false, epoch, rng, tickSpawned[worker], passKey | (uint32_t)task);
+            chunk.liquidStep(liquidCells[ci], liquidSpill[ci], substeps);
+            return chunk.woken();
+        }, nullptr);
+
+        EASY_END_BLOCK;
+    }
 }
 
 float CalculateVerticalFlowValue(float remainingLiquid, float destLiquid) {
@@ -1091,18 +1758,62 @@ float CalculateVerticalFlowValue(float remainingLiquid, float destLiquid) {
 void World::tick() {
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
 
-    // TODO: what if we only check tiles that were marked as dirty last tick?
-
     //#define DEBUG_FRICTION
     #define DO_MULTITHREADING
     //#define DO_REVERSE
 
-    #ifdef DO_MULTITHREADING
-    bool whichTickVisited = false;
-    EASY_BLOCK("memset");
-    memset(tickVisited1, false, (size_t)width * height);
+    // only tiles that were marked active since the last tick (+ whatever wakes up during this one) get simulated
+    SDL_Rect* swapActive = lastActive;
+    lastActive = active;
+    active = swapActive;
+    for(int i = 0; i < activeW * activeH; i++) active[i] = {0, 0, 0, 0};
+
+    // chunks LOD skips this tick hold on to what they had until their turn,
+    // same for chunks outside tickZone (woken by chunk loading or edits at the edge) until they're in it
+    updateLod();
+    for(int i = 0; i < activeW * activeH; i++) {
+        if(!chunkTicking[i] || !chunkInTickZone(i)) active[i] = lastActive[i];
+    }
+
+    // rects woken by each chunk during a pass, merged into active after the pass
+    std::vector<SDL_Rect> woke(activeW * activeH);
+
+    // chunks to tick in the current pass (indexed the same as woke)
+    struct ChunkTask {
+        int cx;
+        int cy;
+        SDL_Rect simRect;
+    };
+    std::vector<ChunkTask> chunkTasks(activeW * activeH);
+
+    // particles spawned by each tickScheduler thread, merged once at the end of the tick
+    if(tickSpawned.size() != tickScheduler->size()) tickSpawned.resize(tickScheduler->size());
+    if(tickSolidRemoved.size() != tickScheduler->size()) tickSolidRemoved.resize(tickScheduler->size());
+    const bool islandEvents = Settings::tick_island_events;
+
+    // anything written outside of tick() since last time was marked active, so refreshing those rects is enough
+    // (that's also where solids removed by explosions, digging, etc. show up)
+    EASY_BLOCK("gather material plane");
+    for(int i = 0; i < activeW * activeH; i++) {
+        SDL_Rect r = lastActive[i];
+        if(r.w <= 0 || r.h <= 0) continue;
+        if(islandEvents) {
+            cells.gatherMaterial(tiles, width, r.x, r.y, r.w, r.h, solidRemoved);
+        } else {
+            cells.gatherMaterial(tiles, width, r.x, r.y, r.w, r.h);
+        }
+    }
     EASY_END_BLOCK;
-    #endif
+    const bool cellPlanes = Settings::tick_cell_planes;
+    // the per-PhysicsType kernels in ChunkTick always read the material plane
+    const bool cellKernels = Settings::tick_cell_kernels;
+    // liquids get their own substeps in tickLiquids (only implemented for the kernels)
+    const bool liquidSolver = cellKernels && Settings::tick_liquid_solver;
+    const bool reactiveSet = reactiveSetEnabled();
+
+    // fire and temperature reactions first, so whatever they change is simulated this tick
+    if(reactiveSet) tickReactive();
+    Uint16* cellMaterial = cells.material;
 
     // TODO: try to figure out a way to optimize this loop since liquids want a high iteration count
     for(int iter = 0; iter < 6; iter++) {
@@ -1118,932 +1829,1253 @@ void World::tick() {
             int chOfsX = tk % 2;             // 0 1 0 1
             int chOfsY = 1 - ((tk % 4) / 2); // 1 1 0 0
 
-            #ifdef DO_MULTITHREADING
-            std::vector<std::future<std::vector<Particle*>>> results = {};
-            #endif
-            #ifdef DO_MULTITHREADING
-            bool* tickVisited = whichTickVisited ? tickVisited2 : tickVisited1;
-            std::future<void> tickVisitedDone = tickVisitedPool->push([&](int id) {
-                EASY_THREAD("memset tickVisited");
-                EASY_BLOCK("memset");
-                memset(whichTickVisited ? tickVisited1 : tickVisited2, false, (size_t)width * height);
-                EASY_END_BLOCK;
-            });
-            #else
-            bool* tickVisited = tickVisited1;
-            EASY_BLOCK("memset");
-            memset(tickVisited1, false, width * height);
-            EASY_END_BLOCK;
-            #endif
+            const uint16_t epoch = nextTickEpoch();
+            int nWoke = 0;
             EASY_END_BLOCK;
             EASY_BLOCK("loop");
             for(int cx = tickZone.x + chOfsX * CHUNK_W; cx < (tickZone.x + tickZone.w); cx += CHUNK_W * 2) {
                 for(int cy = tickZone.y + chOfsY * CHUNK_H; cy < (tickZone.y + tickZone.h); cy += CHUNK_H * 2) {
-                    EASY_BLOCK("push_back");
-                    #ifdef DO_MULTITHREADING
-                    results.push_back(tickPool->push([&, cx, cy](int id) {
-                        EASY_THREAD("Chunk tick");
-                        EASY_BLOCK("setup");
-                        std::vector<Particle*> parts = {};
-                        EASY_END_BLOCK;
-                        #else
-                    EASY_THREAD("Chunk tick");
-                    #endif
-                    EASY_BLOCK("chunk");
-                    EASY_BLOCK("iter 1");
-                    for(int dy = CHUNK_H - 1; dy >= 0; dy--) {
-                        int y = cy + dy;
-                        for(int dxf = 0; dxf < CHUNK_W; dxf++) {
-                            int dx = reverseX ? (CHUNK_W - 1) - dxf : dxf;
-                            int x = cx + dx;
-                            int index = x + y * width;
-
-                            if(tickVisited[index]) continue;
-
-                            if(iter >= tiles[index].mat->iterations) {
-                                tickVisited[index] = true;
+                    SDL_Rect simRect = {cx, cy, CHUNK_W, CHUNK_H};
+                    if(!chunkTicking[(cx / CHUNK_W) + (cy / CHUNK_H) * activeW]) continue;
+                    if(Settings::tick_sleep_chunks) {
+                        // tickZone is chunk aligned so this is the same chunk as active/lastActive use
+                        SDL_Rect a = lastActive[(cx / CHUNK_W) + (cy / CHUNK_H) * activeW];
+                        SDL_Rect b = active[(cx / CHUNK_W) + (cy / CHUNK_H) * activeW];
+                        bool hasA = a.w > 0 && a.h > 0;
+                        bool hasB = b.w > 0 && b.h > 0;
+                        if(!hasA && !hasB) continue;
+
+                        if(!hasA) {
+                            simRect = b;
+                        } else if(!hasB) {
+                            simRect = a;
+                        } else {
+                            int x1 = std::min(a.x, b.x);
+                            int y1 = std::min(a.y, b.y);
+                            int x2 = std::max(a.x + a.w, b.x + b.w);
+                            int y2 = std::max(a.y + a.h, b.y + b.h);
+                            simRect = {x1, y1, x2 - x1, y2 - y1};
+                        }
+                    }
+                    woke[nWoke] = {0, 0, 0, 0};
+                    chunkTasks[nWoke] = {cx, cy, simRect};
+                    nWoke++;
+                }
+            }
+            EASY_END_BLOCK;
+
+            // spawned particles are sorted by this when they're merged so their order doesn't depend on which thread ran what
+            uint32_t passKey = (uint32_t)(iter * 4 + tk) << 16;
+            auto tickChunk = [&](int task, int worker) {
+                int cx = chunkTasks[task].cx;
+                int cy = chunkTasks[task].cy;
+                SDL_Rect simRect = chunkTasks[task].simRect;
+                SDL_Rect* wokeRect = &woke[task];
+                std::vector<std::pair<uint32_t, Particle>>& spawned = tickSpawned[worker];
+                auto spawn = [&](const Particle& p) {
+                    spawned.push_back({passKey | (uint32_t)task, p});
+                };
+
+                EASY_BLOCK("chunk");
+                SDL_Rect sim = simRect;
+
+                // seeded per chunk so it doesn't matter which thread ends up running it (also used by Tiles::create*)
+                RNG& rng = RNG::local();
+                rng.setSeed(RNG::hash(tickCt, iter, cx, cy));
+
+                if(cellKernels) {
+                    ChunkTick chunk(this, cx, cy, simRect, iter, reverseX, epoch, rng, spawned, passKey | (uint32_t)task);
+                    chunk.liquids = !liquidSolver;
+                    chunk.fire = !reactiveSet;
+                    if(islandEvents) chunk.solidRemoved = &tickSolidRemoved[worker];
+                    *wokeRect = chunk.run();
+                    EASY_END_BLOCK;
+                    return;
+                }
+
+                // bounds of everything changed by this chunk (including the 1 tile halo)
+                int wakeMinX = INT_MAX;
+                int wakeMinY = INT_MAX;
+                int wakeMaxX = INT_MIN;
+                int wakeMaxY = INT_MIN;
+                auto wake = [&](int wx, int wy) {
+                    wakeMinX = std::min(wakeMinX, wx - 1);
+                    wakeMinY = std::min(wakeMinY, wy - 1);
+                    wakeMaxX = std::max(wakeMaxX, wx + 1);
+                    wakeMaxY = std::max(wakeMaxY, wy + 1);
+                };
+
+                // grows sim to include anything woken so far (clamped to this chunk)
+                auto growSim = [&]() {
+                    if(wakeMinX > wakeMaxX) return;
+                    int x1 = std::max(std::min(sim.x, wakeMinX), cx);
+                    int y1 = std::max(std::min(sim.y, wakeMinY), cy);
+                    int x2 = std::min(std::max(sim.x + sim.w, wakeMaxX + 1), cx + CHUNK_W);
+                    int y2 = std::min(std::max(sim.y + sim.h, wakeMaxY + 1), cy + CHUNK_H);
+                    sim = {x1, y1, x2 - x1, y2 - y1};
+                };
+
+                // every write in here goes through put() so the material plane stays in sync with tiles
+                auto put = [&](int i, const MaterialInstance& m) {
+                    if(islandEvents && CellGrid::props[cellMaterial[i]].physicsType == PhysicsType::SOLID && m.mat->physicsType != PhysicsType::SOLID) {
+                        tickSolidRemoved[worker].push_back(i);
+                    }
+                    tiles[i] = m;
+                    cellMaterial[i] = (Uint16)m.mat->id;
+                };
+                auto physicsAt = [&](int i) {
+                    return cellPlanes ? (int)CellGrid::physicsType[cellMaterial[i]] : tiles[i].mat->physicsType;
+                };
+
+                EASY_BLOCK("iter 1");
+                for(int dy = sim.h - 1; dy >= 0; dy--) {
+                    int y = sim.y + dy;
+                    for(int dxf = 0; dxf < sim.w; dxf++) {
+                        int dx = reverseX ? (sim.w - 1) - dxf : dxf;
+                        int x = sim.x + dx;
+                        int index = x + y * width;
+
+                        if(tickVisited[index] == epoch) continue;
+
+                        if(cellPlanes) {
+                            // most tiles are air or solid, so skip those without pulling in the whole MaterialInstance
+                            Uint16 m = cellMaterial[index];
+                            if(iter >= CellGrid::iterations[m]) {
+                                tickVisited[index] = epoch;
                                 continue;
                             }
-                            MaterialInstance tile = tiles[index];
+                            int t = CellGrid::physicsType[m];
+                            if(t != PhysicsType::SAND && t != PhysicsType::SOUP && t != PhysicsType::GAS && m != Materials::FIRE.id) continue;
+                        } else if(iter >= tiles[index].mat->iterations) {
+                            tickVisited[index] = epoch;
+                            continue;
+                        }
+                        MaterialInstance tile = tiles[index];
 
-                            int type = tile.mat->physicsType;
+                        int type = tile.mat->physicsType;
 
-                            if(tile.mat->id == Materials::FIRE.id) {
-                                if(rand() % 10 == 0) {
-                                    Uint32 rgb = 255;
-                                    rgb = (rgb << 8) + 100 + rand() % 50;
-                                    rgb = (rgb << 8) + 50;
-                                    tile.color = rgb;
-                                }
+                        if(tile.mat->id == Materials::FIRE.id) {
+                            // fire never settles
+                            wake(x, y);
 
-                                if(rand() % 10 == 0) {
-                                    Particle* p = new Particle(tile, x, y - 1, (rand() % 10 - 5) / 20.0f, -((rand() % 10) / 10.0f) / 3.0f + -0.5f, 0, 0.01f);
-                                    p->temporary = true;
-                                    p->lifetime = 30;
-                                    p->fadeTime = 10;
-                                    #ifdef DO_MULTITHREADING
-                                    parts.push_back(p);
-                                    #else
-                                    particles.push_back(p);
-                                    #endif
-                                }
+                            if(rng.next() % 10 == 0) {
+                                Uint32 rgb = 255;
+                                rgb = (rgb << 8) + 100 + rng.next() % 50;
+                                rgb = (rgb << 8) + 50;
+                                tile.color = rgb;
+                            }
 
-                                if(rand() % 150 == 0) {
-                                    //tiles[index] = Tiles::createSteam();
-                                    tiles[index] = Tiles::NOTHING;
-                                    dirty[index] = true;
-                                    tickVisited[index] = true;
-                                } else {
-                                    bool foundAny = false;
-                                    for(int xx = -2; xx <= 2; xx++) {
-                                        for(int yy = -2; yy <= 2; yy++) {
-                                            if(tiles[(x + xx) + (y + yy) * width].mat->physicsType == PhysicsType::SOLID) {
-                                                foundAny = true;
-                                                if(rand() % 500 == 0) {
-                                                    tiles[(x + xx) + (y + yy) * width] = Tiles::createFire();
-                                                    dirty[(x + xx) + (y + yy) * width] = true;
-                                                    tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                }
+                            if(rng.next() % 10 == 0) {
+                                Particle p(tile, x, y - 1, (rng.next() % 10 - 5) / 20.0f, -((rng.next() % 10) / 10.0f) / 3.0f + -0.5f, 0, 0.01f);
+                                p.temporary = true;
+                                p.lifetime = 30;
+                                p.fadeTime = 10;
+                                spawn(p);
+                            }
+
+                            if(rng.next() % 150 == 0) {
+                                //tiles[index] = Tiles::createSteam();
+                                put(index, Tiles::NOTHING);
+                                markDirty(x, y);
+                                wake(x, y);
+                                tickVisited[index] = epoch;
+                            } else {
+                                bool foundAny = false;
+                                for(int xx = -2; xx <= 2; xx++) {
+                                    for(int yy = -2; yy <= 2; yy++) {
+                                        if(physicsAt((x + xx) + (y + yy) * width) == PhysicsType::SOLID) {
+                                            foundAny = true;
+                                            if(rng.next() % 500 == 0) {
+                                                put((x + xx) + (y + yy) * width, Tiles::createFire());
+                                                markDirty(x + xx, y + yy);
+                                                wake(x + xx, y + yy);
+                                                tickVisited[(x + xx) + (y + yy) * width] = epoch;
                                             }
                                         }
                                     }
-                                    if(!foundAny && rand() % 120 == 0) {
-                                        tiles[index] = Tiles::NOTHING;
-                                        dirty[index] = true;
-                                        tickVisited[index] = true;
-                                    }
+                                }
+                                if(!foundAny && rng.next() % 120 == 0) {
+                                    put(index, Tiles::NOTHING);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                    tickVisited[index] = epoch;
                                 }
                             }
+                        }
 
-                            if(type == PhysicsType::SAND) {
-                                //active[index] = true;
-                                MaterialInstance belowTile = tiles[x + (y + 1) * width];
-                                int below = belowTile.mat->physicsType;
-
-                                if(tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < Materials::nMaterials && tile.mat->nInteractions[belowTile.mat->id] > 0) {
-                                    for(int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
-                                        MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
-                                        if(in.type == INTERACT_TRANSFORM_MATERIAL) {
-                                            for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                                for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                                    if(tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
-                                                        tiles[(x + xx) + (y + yy) * width] = Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy);
-                                                        dirty[(x + xx) + (y + yy) * width] = true;
-                                                        tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                    }
+                        if(type == PhysicsType::SAND) {
+                            //active[index] = true;
+                            MaterialInstance belowTile = tiles[x + (y + 1) * width];
+                            int below = belowTile.mat->physicsType;
+
+                            if(tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < Materials::nMaterials && tile.mat->nInteractions[belowTile.mat->id] > 0) {
+                                for(int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
+                                    MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
+                                    if(in.type == INTERACT_TRANSFORM_MATERIAL) {
+                                        for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                                            for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                                                if(tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
+                                                    put((x + xx) + (y + yy) * width, Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy));
+                                                    markDirty(x + xx, y + yy);
+                                                    wake(x + xx, y + yy);
+                                                    tickVisited[(x + xx) + (y + yy) * width] = epoch;
                                                 }
                                             }
-                                        } else if(in.type == INTERACT_SPAWN_MATERIAL) {
-                                            for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                                for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                                    if((xx == 0 && yy == 0) || tiles[(x + xx) + (y + yy) * width].mat->id == Tiles::NOTHING.mat->id) {
-                                                        tiles[(x + xx) + (y + yy) * width] = Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy);
-                                                        dirty[(x + xx) + (y + yy) * width] = true;
-                                                        tickVisited[(x + xx) + (y + yy) * width] = true;
-                                                    }
+                                        }
+                                    } else if(in.type == INTERACT_SPAWN_MATERIAL) {
+                                        for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                                            for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                                                if((xx == 0 && yy == 0) || tiles[(x + xx) + (y + yy) * width].mat->id == Tiles::NOTHING.mat->id) {
+                                                    put((x + xx) + (y + yy) * width, Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy));
+                                                    markDirty(x + xx, y + yy);
+                                                    wake(x + xx, y + yy);
+                                                    tickVisited[(x + xx) + (y + yy) * width] = epoch;
                                                 }
                                             }
                                         }
                                     }
-                                    continue;
                                 }
+                                continue;
+                            }
 
-                                if(tile.mat->react && tile.mat->nReactions > 0) {
-                                    bool react = false;
-                                    for(int i = 0; i < tile.mat->nReactions; i++) {
-                                        MaterialInteraction in = tile.mat->reactions[i];
-                                        if(in.type == REACT_TEMPERATURE_BELOW) {
-                                            if(tile.temperature < in.data1) {
-                                                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
-                                                tiles[index].temperature = tile.temperature;
-                                                dirty[index] = true;
-                                                tickVisited[index] = true;
-                                                react = true;
-                                            }
-                                        } else if(in.type == REACT_TEMPERATURE_ABOVE) {
-                                            if(tile.temperature > in.data1) {
-                                                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
-                                                tiles[index].temperature = tile.temperature;
-                                                dirty[index] = true;
-                                                tickVisited[index] = true;
-                                                react = true;
-                                            }
+                            if(tile.mat->react && tile.mat->nReactions > 0) {
+                                bool react = false;
+                                for(int i = 0; i < tile.mat->nReactions; i++) {
+                                    MaterialInteraction in = tile.mat->reactions[i];
+                                    if(in.type == REACT_TEMPERATURE_BELOW) {
+                                        if(tile.temperature < in.data1) {
+                                            put(index, Tiles::create(Materials::MATERIALS[in.data2], x, y));
+                                            tiles[index].temperature = tile.temperature;
+                                            markDirty(x, y);
+                                            wake(x, y);
+                                            tickVisited[index] = epoch;
+                                            react = true;
+                                        }
+                                    } else if(in.type == REACT_TEMPERATURE_ABOVE) {
+                                        if(tile.temperature > in.data1) {
+                                            put(index, Tiles::create(Materials::MATERIALS[in.data2], x, y));
+                                            tiles[index].temperature = tile.temperature;
+                                            markDirty(x, y);
+                                            wake(x, y);
+                                            tickVisited[index] = epoch;
+                                            react = true;
                                         }
                                     }
-                                    if(react) continue;
                                 }
+                                if(react) continue;
+                            }
 
-                                bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
-                                if(!canMoveBelow) continue;
+                            bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
+                            if(!canMoveBelow) continue;
 
-                                MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
-                                int belowL = belowLTile.mat->physicsType;
-                                MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
-                                int belowR = belowRTile.mat->physicsType;
+                            MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+                            int belowL = belowLTile.mat->physicsType;
+                            MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+                            int belowR = belowRTile.mat->physicsType;
 
-                                bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+                            bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                            bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
 
-                                if(canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 20 == 0)) {
-                                    if(belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR && getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
-                                        setTile(x, y, belowTile);
-                                        #ifdef DO_MULTITHREADING
-                                        parts.push_back(new Particle(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
-                                        #else
-                                        particles.push_back(new Particle(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                            if(canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rng.next() % 20 == 0)) {
+                                if(belowTile.mat->physicsType == PhysicsType::AIR && physicsAt(x + (y + 2) * width) == PhysicsType::AIR && physicsAt(x + (y + 3) * width) == PhysicsType::AIR && physicsAt(x + (y + 4) * width) == PhysicsType::AIR) {
+                                    // setTile would markActive, which isn't safe from here
+                                    put(index, belowTile);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                    spawn(Particle(tile, x, y + 1, (rng.next() % 10 - 5) / 20.0f, -((rng.next() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                                } else {
+                                    put(index, belowTile);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                    //setTile(x, y, belowTile);
+                                    //setTile(x, y + 1, tile);
+                                    if(rng.next() % 2 == 0) {
+                                        tile.moved = true;
+                                        #ifdef DEBUG_FRICTION
+                                        tile.color = 0xffffffff;
                                         #endif
-                                    } else {
-                                        tiles[index] = belowTile;
-                                        dirty[index] = true;
-                                        //setTile(x, y, belowTile);
-                                        //setTile(x, y + 1, tile);
-                                        if(rand() % 2 == 0) {
-                                            tile.moved = true;
+                                    }
+                                    put((x)+(y + 1) * width, tile);
+                                    markDirty(x, y + 1);
+                                    wake(x, y + 1);
+                                    tickVisited[x + (y + 1) * width] = epoch;
+                                }
+
+                                int selfTrasmitMovementChance = 2;
+
+                                if(rng.next() % selfTrasmitMovementChance == 0) {
+                                    if(x > 0 && physicsAt((x - 1) + (y + 1) * width) == PhysicsType::SAND) {
+                                        int otherTransmitMovementChance = 2;
+                                        if(rng.next() % otherTransmitMovementChance == 0) {
+                                            tiles[(x - 1) + (y + 1) * width].moved = true;
                                             #ifdef DEBUG_FRICTION
-                                            tile.color = 0xffffffff;
+                                            tiles[(x - 1) + (y + 1) * width].color = 0xff00ffff;
+                                            markDirty(x - 1, y + 1);
                                             #endif
                                         }
-                                        tiles[(x)+(y + 1) * width] = tile;
-                                        dirty[(x)+(y + 1) * width] = true;
-                                        tickVisited[x + (y + 1) * width] = true;
                                     }
 
-                                    int selfTrasmitMovementChance = 2;
-
-                                    if(rand() % selfTrasmitMovementChance == 0) {
-                                        if(x > 0 && tiles[(x - 1) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
-                                            int otherTransmitMovementChance = 2;
-                                            if(rand() % otherTransmitMovementChance == 0) {
-                                                tiles[(x - 1) + (y + 1) * width].moved = true;
-                                                #ifdef DEBUG_FRICTION
-                                                tiles[(x - 1) + (y + 1) * width].color = 0xff00ffff;
-                                                dirty[(x - 1) + (y + 1) * width] = true;
-                                                #endif
-                                            }
-                                        }
-
-                                        if(x < width - 1 && tiles[(x + 1) + (y + 1) * width].mat->physicsType == PhysicsType::SAND) {
-                                            int otherTransmitMovementChance = 2;
-                                            if(rand() % otherTransmitMovementChance == 0) {
-                                                tiles[(x + 1) + (y + 1) * width].moved = true;
-                                                #ifdef DEBUG_FRICTION
-                                                tiles[(x + 1) + (y + 1) * width].color = 0xff00ffff;
-                                                dirty[(x + 1) + (y + 1) * width] = true;
-                                                #endif
-                                            }
+                                    if(x < width - 1 && physicsAt((x + 1) + (y + 1) * width) == PhysicsType::SAND) {
+                                        int otherTransmitMovementChance = 2;
+                                        if(rng.next() % otherTransmitMovementChance == 0) {
+                                            tiles[(x + 1) + (y + 1) * width].moved = true;
+                                            #ifdef DEBUG_FRICTION
+                                            tiles[(x + 1) + (y + 1) * width].color = 0xff00ffff;
+                                            markDirty(x + 1, y + 1);
+                                            #endif
                                         }
                                     }
                                 }
+                            }
 
-                            } else if(type == PhysicsType::SOUP) {
-
-                                // based on https://github.com/jongallant/LiquidSimulator (MIT License)
+                        } else if(type == PhysicsType::SOUP) {
 
-                                // NOTE: for liquids, tile.moved is tile.settled in the original algorithm
+                            // based on https://github.com/jongallant/LiquidSimulator (MIT License)
 
-                                if(tile.fluidAmount == 0.0f) continue;
+                            // NOTE: for liquids, tile.moved is tile.settled in the original algorithm
 
-                                if(tile.fluidAmount < FLUID_MinValue) {
-                                    tile.fluidAmount = 0.0f;
-                                    tiles[index] = tile;
-                                    continue;
-                                }
+                            if(tile.fluidAmount == 0.0f) continue;
 
-                                if(tile.fluidAmount > 0.005 && getTile(x, y + 1).mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR && getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
-                                    setTile(x, y, Tiles::NOTHING);
+                            if(tile.fluidAmount < FLUID_MinValue) {
+                                tile.fluidAmount = 0.0f;
+                                put(index, tile);
+                                continue;
+                            }
 
-                                    int n = tile.fluidAmount / 4;
-                                    if(n < 1) n = 1;
+                            if(tile.fluidAmount > 0.005 && physicsAt(x + (y + 1) * width) == PhysicsType::AIR && physicsAt(x + (y + 2) * width) == PhysicsType::AIR && physicsAt(x + (y + 3) * width) == PhysicsType::AIR && physicsAt(x + (y + 4) * width) == PhysicsType::AIR) {
+                                put(index, Tiles::NOTHING);
+                                markDirty(x, y);
+                                wake(x, y);
 
-                                    for(int i = 0; i < n; i++) {
-                                        float amt = tile.fluidAmount / n;
+                                int n = tile.fluidAmount / 4;
+                                if(n < 1) n = 1;
 
-                                        MaterialInstance nt = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                        nt.fluidAmount = amt;
-                                        nt.fluidAmountDiff = 0;
-                                        nt.moved = false;
-                                        #ifdef DO_MULTITHREADING
-                                        parts.push_back(new Particle(nt, x, y + 1, (rand() % 10 - 5) / 30.0f, -((rand() % 2) + 3) / 10.0f + 1.0f, 0, 0.1f));
-                                        #else
-                                        particles.push_back(new Particle(nt, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
-                                        #endif
+                                for(int i = 0; i < n; i++) {
+                                    float amt = tile.fluidAmount / n;
 
-                                    }
+                                    MaterialInstance nt = MaterialInstance(tile.mat, tile.color, tile.temperature);
+                                    nt.fluidAmount = amt;
+                                    nt.fluidAmountDiff = 0;
+                                    nt.moved = false;
+                                    spawn(Particle(nt, x, y + 1, (rng.next() % 10 - 5) / 30.0f, -((rng.next() % 2) + 3) / 10.0f + 1.0f, 0, 0.1f));
 
-                                    continue;
                                 }
 
-                                if(tile.moved) continue;
+                                continue;
+                            }
 
-                                float startValue = tile.fluidAmount;
-                                float remainingValue = tile.fluidAmount;
+                            if(tile.moved) continue;
 
-                                MaterialInstance bottom = tiles[(x) + (y + 1) * width];
+                            // unsettled liquid keeps its chunk awake until it settles
+                            wake(x, y);
 
-                                bool airBelow = bottom.mat->physicsType == PhysicsType::AIR;
-                                if((airBelow && iter <= 2) || (bottom.mat->id == tile.mat->id)) {
-                                    float dstFl = bottom.mat->physicsType == PhysicsType::SOUP ? bottom.fluidAmount : 0.0f;
+                            float startValue = tile.fluidAmount;
+                            float remainingValue = tile.fluidAmount;
 
-                                    float flow = CalculateVerticalFlowValue(startValue, dstFl) - dstFl;
-                                    if(bottom.fluidAmount > 0 && flow > FLUID_MinFlow)
-                                        flow *= FLUID_FlowSpeed;
+                            MaterialInstance bottom = tiles[(x) + (y + 1) * width];
 
-                                    flow = std::max(flow, 0.0f);
-                                    if(flow > std::min(FLUID_MaxFlow, startValue))
-                                        flow = std::min(FLUID_MaxFlow, startValue);
+                            bool airBelow = bottom.mat->physicsType == PhysicsType::AIR;
+                            if((airBelow && iter <= 2) || (bottom.mat->id == tile.mat->id)) {
+                                float dstFl = bottom.mat->physicsType == PhysicsType::SOUP ? bottom.fluidAmount : 0.0f;
 
-                                    if(flow != 0) {
-                                        remainingValue -= flow;
-                                        tile.fluidAmountDiff -= flow;
-                                        if(bottom.mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x)+(y + 1) * width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                            tiles[(x)+(y + 1) * width].fluidAmount = 0.0f;
-                                        }
-                                        tiles[(x)+(y + 1) * width].fluidAmountDiff += flow;
-                                        //tiles[(x)+(y + 1) * width].moved = true;
-                                    }
-                                    flowY[index] += flow;
-                                } else if(iter == 0 && bottom.mat->physicsType == PhysicsType::SOUP && (bottom.mat->id != tile.mat->id)) {
-                                    if(rand() % 10 == 0) {
-                                        tiles[index] = bottom;
-                                        tiles[(x)+(y + 1) * width] = tile;
-                                        continue;
+                                float flow = CalculateVerticalFlowValue(startValue, dstFl) - dstFl;
+                                if(bottom.fluidAmount > 0 && flow > FLUID_MinFlow)
+                                    flow *= FLUID_FlowSpeed;
+
+                                flow = std::max(flow, 0.0f);
+                                if(flow > std::min(FLUID_MaxFlow, startValue))
+                                    flow = std::min(FLUID_MaxFlow, startValue);
+
+                                if(flow != 0) {
+                                    remainingValue -= flow;
+                                    tile.fluidAmountDiff -= flow;
+                                    if(bottom.mat->physicsType == PhysicsType::AIR) {
+                                        put((x)+(y + 1) * width, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                                        tiles[(x)+(y + 1) * width].fluidAmount = 0.0f;
                                     }
+                                    tiles[(x)+(y + 1) * width].fluidAmountDiff += flow;
+                                    //tiles[(x)+(y + 1) * width].moved = true;
                                 }
-
-                                if(remainingValue < FLUID_MinValue) {
-                                    tile.fluidAmountDiff -= remainingValue;
-                                    tiles[index] = tile;
+                                flowY[index] += flow;
+                            } else if(iter == 0 && bottom.mat->physicsType == PhysicsType::SOUP && (bottom.mat->id != tile.mat->id)) {
+                                if(rng.next() % 10 == 0) {
+                                    put(index, bottom);
+                                    put((x)+(y + 1) * width, tile);
+                                    wake(x, y + 1);
                                     continue;
                                 }
+                            }
 
-                                MaterialInstance left = tiles[(x - 1) + (y) * width];
-                                bool canMoveLeft = (left.mat->physicsType == PhysicsType::AIR || (left.mat->id == tile.mat->id)) && !airBelow;
+                            if(remainingValue < FLUID_MinValue) {
+                                tile.fluidAmountDiff -= remainingValue;
+                                put(index, tile);
+                                continue;
+                            }
 
-                                MaterialInstance right = tiles[(x + 1) + (y)*width];
-                                bool canMoveRight = (right.mat->physicsType == PhysicsType::AIR || (right.mat->id == tile.mat->id)) && !airBelow;
+                            MaterialInstance left = tiles[(x - 1) + (y) * width];
+                            bool canMoveLeft = (left.mat->physicsType == PhysicsType::AIR || (left.mat->id == tile.mat->id)) && !airBelow;
 
-                                if(canMoveLeft) {
-                                    float dstFl = left.mat->physicsType == PhysicsType::SOUP ? left.fluidAmount : 0.0f;
+                            MaterialInstance right = tiles[(x + 1) + (y)*width];
+                            bool canMoveRight = (right.mat->physicsType == PhysicsType::AIR || (right.mat->id == tile.mat->id)) && !airBelow;
 
-                                    float flow = (remainingValue - dstFl) / (canMoveRight ? 3.0f : 2.0f);
-                                    if(flow > FLUID_MinFlow)
-                                        flow *= FLUID_FlowSpeed;
+                            if(canMoveLeft) {
+                                float dstFl = left.mat->physicsType == PhysicsType::SOUP ? left.fluidAmount : 0.0f;
 
-                                    flow = std::max(flow, 0.0f);
-                                    if(flow > std::min(FLUID_MaxFlow, remainingValue))
-                                        flow = std::min(FLUID_MaxFlow, remainingValue);
+                                float flow = (remainingValue - dstFl) / (canMoveRight ? 3.0f : 2.0f);
+                                if(flow > FLUID_MinFlow)
+                                    flow *= FLUID_FlowSpeed;
 
-                                    if(flow != 0) {
-                                        remainingValue -= flow;
-                                        tile.fluidAmountDiff -= flow;
-                                        if(left.mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x-1)+(y) * width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                            tiles[(x - 1) + (y)*width].fluidAmount = 0.0f;
-                                        }
-                                        tiles[(x - 1) + (y)*width].fluidAmountDiff += flow;
-                                        //tiles[(x - 1) + (y)*width].moved = true;
+                                flow = std::max(flow, 0.0f);
+                                if(flow > std::min(FLUID_MaxFlow, remainingValue))
+                                    flow = std::min(FLUID_MaxFlow, remainingValue);
+
+                                if(flow != 0) {
+                                    remainingValue -= flow;
+                                    tile.fluidAmountDiff -= flow;
+                                    if(left.mat->physicsType == PhysicsType::AIR) {
+                                        put((x-1)+(y) * width, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                                        tiles[(x - 1) + (y)*width].fluidAmount = 0.0f;
                                     }
-                                    flowX[index] -= flow;
+                                    tiles[(x - 1) + (y)*width].fluidAmountDiff += flow;
+                                    //tiles[(x - 1) + (y)*width].moved = true;
                                 }
+                                flowX[index] -= flow;
+                            }
 
-                                if(remainingValue < FLUID_MinValue) {
-                                    tile.fluidAmountDiff -= remainingValue;
-                                    tiles[index] = tile;
-                                    continue;
-                                }
+                            if(remainingValue < FLUID_MinValue) {
+                                tile.fluidAmountDiff -= remainingValue;
+                                put(index, tile);
+                                continue;
+                            }
 
-                                if(canMoveRight) {
-                                    float dstFl = right.mat->physicsType == PhysicsType::SOUP ? right.fluidAmount : 0.0f;
+                            if(canMoveRight) {
+                                float dstFl = right.mat->physicsType == PhysicsType::SOUP ? right.fluidAmount : 0.0f;
 
-                                    float flow = (remainingValue - dstFl) / (canMoveLeft ? 2.0f : 2.0f);
-                                    if(flow > FLUID_MinFlow)
-                                        flow *= FLUID_FlowSpeed;
+                                float flow = (remainingValue - dstFl) / (canMoveLeft ? 2.0f : 2.0f);
+                                if(flow > FLUID_MinFlow)
+                                    flow *= FLUID_FlowSpeed;
 
-                                    flow = std::max(flow, 0.0f);
-                                    if(flow > std::min(FLUID_MaxFlow, remainingValue))
-                                        flow = std::min(FLUID_MaxFlow, remainingValue);
+                                flow = std::max(flow, 0.0f);
+                                if(flow > std::min(FLUID_MaxFlow, remainingValue))
+                                    flow = std::min(FLUID_MaxFlow, remainingValue);
 
-                                    if(flow != 0) {
-                                        remainingValue -= flow;
-                                        tile.fluidAmountDiff -= flow;
-                                        if(right.mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x + 1) + (y)*width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                            tiles[(x + 1) + (y)*width].fluidAmount = 0.0f;
-                                        }
-                                        tiles[(x + 1) + (y)*width].fluidAmountDiff += flow;
-                                        //tiles[(x + 1) + (y)*width].moved = true;
+                                if(flow != 0) {
+                                    remainingValue -= flow;
+                                    tile.fluidAmountDiff -= flow;
+                                    if(right.mat->physicsType == PhysicsType::AIR) {
+                                        put((x + 1) + (y)*width, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                                        tiles[(x + 1) + (y)*width].fluidAmount = 0.0f;
                                     }
-                                    flowX[index] += flow;
+                                    tiles[(x + 1) + (y)*width].fluidAmountDiff += flow;
+                                    //tiles[(x + 1) + (y)*width].moved = true;
                                 }
+                                flowX[index] += flow;
+                            }
 
-                                if(remainingValue < FLUID_MinValue) {
-                                    tile.fluidAmountDiff -= remainingValue;
-                                    tiles[index] = tile;
-                                    continue;
-                                }
+                            if(remainingValue < FLUID_MinValue) {
+                                tile.fluidAmountDiff -= remainingValue;
+                                put(index, tile);
+                                continue;
+                            }
 
-                                MaterialInstance top = tiles[(x) + (y - 1)*width];
+                            MaterialInstance top = tiles[(x) + (y - 1)*width];
 
-                                if(top.mat->physicsType == PhysicsType::AIR || (top.mat->id == tile.mat->id)) {
-                                    float dstFl = top.mat->physicsType == PhysicsType::SOUP ? top.fluidAmount : 0.0f;
+                            if(top.mat->physicsType == PhysicsType::AIR || (top.mat->id == tile.mat->id)) {
+                                float dstFl = top.mat->physicsType == PhysicsType::SOUP ? top.fluidAmount : 0.0f;
 
-                                    float flow = remainingValue - CalculateVerticalFlowValue(remainingValue, dstFl);
-                                    if(flow > FLUID_MinFlow)
-                                        flow *= FLUID_FlowSpeed;
+                                float flow = remainingValue - CalculateVerticalFlowValue(remainingValue, dstFl);
+                                if(flow > FLUID_MinFlow)
+                                    flow *= FLUID_FlowSpeed;
 
-                                    flow = std::max(flow, 0.0f);
-                                    if(flow > std::min(FLUID_MaxFlow, remainingValue))
-                                        flow = std::min(FLUID_MaxFlow, remainingValue);
+                                flow = std::max(flow, 0.0f);
+                                if(flow > std::min(FLUID_MaxFlow, remainingValue))
+                                    flow = std::min(FLUID_MaxFlow, remainingValue);
 
-                                    if(flow != 0) {
-                                        remainingValue -= flow;
-                                        tile.fluidAmountDiff -= flow;
-                                        if(top.mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x) + (y-1)*width] = MaterialInstance(tile.mat, tile.color, tile.temperature);
-                                            tiles[(x)+(y - 1) * width].fluidAmount = 0.0f;
-                                        }
-                                        tiles[(x)+(y - 1) * width].fluidAmountDiff += flow;
-                                        //tiles[(x)+(y - 1) * width].moved = true;
-                                    }
-                                    flowY[index] -= flow;
-                                } else if(iter == 0 && top.mat->physicsType == PhysicsType::SOUP && (top.mat->id != tile.mat->id)) {
-                                    if(rand() % 10 == 0) {
-                                        tiles[index] = top;
-                                        tiles[(x)+(y - 1) * width] = tile;
-                                        continue;
+                                if(flow != 0) {
+                                    remainingValue -= flow;
+                                    tile.fluidAmountDiff -= flow;
+                                    if(top.mat->physicsType == PhysicsType::AIR) {
+                                        put((x) + (y-1)*width, MaterialInstance(tile.mat, tile.color, tile.temperature));
+                                        tiles[(x)+(y - 1) * width].fluidAmount = 0.0f;
                                     }
+                                    tiles[(x)+(y - 1) * width].fluidAmountDiff += flow;
+                                    //tiles[(x)+(y - 1) * width].moved = true;
                                 }
-
-                                if(remainingValue < FLUID_MinValue) {
-                                    tile.fluidAmountDiff -= remainingValue;
-                                    tiles[index] = tile;
+                                flowY[index] -= flow;
+                            } else if(iter == 0 && top.mat->physicsType == PhysicsType::SOUP && (top.mat->id != tile.mat->id)) {
+                                if(rng.next() % 10 == 0) {
+                                    put(index, top);
+                                    put((x)+(y - 1) * width, tile);
+                                    wake(x, y - 1);
                                     continue;
                                 }
+                            }
 
-                                if(startValue == remainingValue) {
-                                    tile.settleCount++;
-                                    if(tile.settleCount >= 10) {
-                                        tile.moved = true;
-                                    }
-                                } else {
-                                    dirty[index] = true;
-                                    if(top.mat->physicsType    == PhysicsType::SOUP) tiles[(x)+(y - 1) * width].moved = false;
-                                    if(bottom.mat->physicsType == PhysicsType::SOUP) tiles[(x)+(y + 1) * width].moved = false;
-                                    if(left.mat->physicsType   == PhysicsType::SOUP) tiles[(x - 1)+(y) * width].moved = false;
-                                    if(right.mat->physicsType  == PhysicsType::SOUP) tiles[(x + 1)+(y) * width].moved = false;
+                            if(remainingValue < FLUID_MinValue) {
+                                tile.fluidAmountDiff -= remainingValue;
+                                put(index, tile);
+                                continue;
+                            }
+
+                            if(startValue == remainingValue) {
+                                tile.settleCount++;
+                                if(tile.settleCount >= 10) {
+                                    tile.moved = true;
                                 }
+                            } else {
+                                markDirty(x, y);
+                                wake(x, y);
+                                if(top.mat->physicsType    == PhysicsType::SOUP) tiles[(x)+(y - 1) * width].moved = false;
+                                if(bottom.mat->physicsType == PhysicsType::SOUP) tiles[(x)+(y + 1) * width].moved = false;
+                                if(left.mat->physicsType   == PhysicsType::SOUP) tiles[(x - 1)+(y) * width].moved = false;
+                                if(right.mat->physicsType  == PhysicsType::SOUP) tiles[(x + 1)+(y) * width].moved = false;
+                            }
+
+                            put(index, tile);
+
+                            // OLD: 
+
+                            //active[index] = true;
+                            //MaterialInstance belowTile = tiles[(x)+(y + 1) * width];
+                            //int below = belowTile.mat->physicsType;
+
+                            //if(tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < Materials::nMaterials && tile.mat->nInteractions[belowTile.mat->id] > 0) {
+                            //    for(int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
+                            //        MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
+                            //        if(in.type == INTERACT_TRANSFORM_MATERIAL) {
+                            //            for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                            //                for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                            //                    if(tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
+                            //                        tiles[(x + xx) + (y + yy) * width] = Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy);
+                            //                        dirty[(x + xx) + (y + yy) * width] = true;
+                            //                        tickVisited[(x + xx) + (y + yy) * width] = true;
+                            //                    }
+                            //                }
+                            //            }
+                            //        } else if(in.type == INTERACT_SPAWN_MATERIAL) {
+                            //            for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
+                            //                for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
+                            //                    if((xx == 0 && yy == 0) || tiles[(x + xx) + (y + yy) * width].mat->id == Tiles::NOTHING.mat->id) {
+                            //                        tiles[(x + xx) + (y + yy) * width] = Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy);
+                            //                        dirty[(x + xx) + (y + yy) * width] = true;
+                            //                        tickVisited[(x + xx) + (y + yy) * width] = true;
+                            //                    }
+                            //                }
+                            //            }
+                            //        }
+                            //    }
+                            //    continue;
+                            //}
+
+                            //if(tile.mat->react && tile.mat->nReactions > 0) {
+                            //    bool react = false;
+                            //    for(int i = 0; i < tile.mat->nReactions; i++) {
+                            //        MaterialInteraction in = tile.mat->reactions[i];
+                            //        if(in.type == REACT_TEMPERATURE_BELOW) {
+                            //            if(tile.temperature < in.data1) {
+                            //                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
+                            //                tiles[index].temperature = tile.temperature;
+                            //                dirty[index] = true;
+                            //                tickVisited[index] = true;
+                            //                react = true;
+                            //            }
+                            //        } else if(in.type == REACT_TEMPERATURE_ABOVE) {
+                            //            if(tile.temperature > in.data1) {
+                            //                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
+                            //                tiles[index].temperature = tile.temperature;
+                            //                dirty[index] = true;
+                            //                tickVisited[index] = true;
+                            //                react = true;
+                            //            }
+                            //        }
+                            //    }
+                            //    if(react) continue;
+                            //}
+
+                            ///*if (tile.mat->id == Materials::WATER.id && belowTile.mat->id == Materials::LAVA.id) {
+                            //    tiles[index] = Tiles::createSteam();
+                            //    dirty[index] = true;
+                            //    tiles[(x)+(y + 1) * width] = Tiles::createObsidian(x, y + 1);
+                            //    dirty[(x)+(y + 1) * width] = true;
+                            //    tickVisited[(x)+(y + 1) * width] = true;
+
+                            //    for (int xx = -1; xx <= 1; xx++) {
+                            //        for (int yy = 0; yy <= 2; yy++) {
+                            //            if (tiles[(x + xx) + (y + yy) * width].mat->id == Materials::LAVA.id) {
+                            //                tiles[(x + xx) + (y + yy) * width] = Tiles::createObsidian(x + xx, y + yy);
+                            //                dirty[(x + xx) + (y + yy) * width] = true;
+                            //                tickVisited[(x + xx) + (y + yy) * width] = true;
+                            //            }
+                            //        }
+                            //    }
+
+                            //    continue;
+                            //}*/
+
+                            //bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
+                            //if(!canMoveBelow) continue;
+
+                            //MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+                            //int belowL = belowLTile.mat->physicsType;
+                            //MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+                            //int belowR = belowRTile.mat->physicsType;
+
+                            //bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                            //bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+
+                            //if(canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 10 == 0)) {
+                            //    if(belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR && getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
+                            //        setTile(x, y, belowTile);
+                            //        #ifdef DO_MULTITHREADING
+                            //        parts.push_back(Particle(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                            //        #else
+                            //        particles.add(Particle(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
+                            //        #endif
+                            //    } else {
+                            //        tiles[index] = belowTile;
+                            //        dirty[index] = true;
+                            //        //setTile(x, y, belowTile);
+                            //        //setTile(x, y + 1, tile);
+                            //        tiles[(x)+(y + 1) * width] = tile;
+                            //        dirty[(x)+(y + 1) * width] = true;
+                            //        tickVisited[x + (y + 1) * width] = true;
+                            //    }
+                            //}
+                        } else if(type == PhysicsType::GAS) {
+                            //active[index] = true;
+                            int above = physicsAt((x)+(y - 1) * width);
+
+                            int aboveL = physicsAt((x - 1) + (y - 1) * width);
+                            int aboveR = physicsAt((x + 1) + (y - 1) * width);
+
+                            if(above == 0 && !((aboveL == 0 || aboveR == 0) && rng.next() % 2 == 0)) {
+                                put(index, getTile(x, y - 1));
+                                markDirty(x, y);
+                                wake(x, y);
+
+                                put((x)+(y - 1) * width, tile);
+                                markDirty(x, y - 1);
+                                wake(x, y - 1);
+
+                                tickVisited[(x)+(y - 1) * width] = epoch;
+                            }
+                        }
+                    }
+                }
+                EASY_END_BLOCK;
+
+                growSim();
+                EASY_BLOCK("iter 2");
+                for(int dy = sim.h - 1; dy >= 0; dy--) {
+                    int y = sim.y + dy;
+                    for(int dxf = 0; dxf < sim.w; dxf++) {
+                        int dx = reverseX ? (sim.w - 1) - dxf : dxf;
+                        int x = sim.x + dx;
+                        int index = x + y * width;
 
-                                tiles[index] = tile;
-
-                                // OLD: 
-
-                                //active[index] = true;
-                                //MaterialInstance belowTile = tiles[(x)+(y + 1) * width];
-                                //int below = belowTile.mat->physicsType;
-
-                                //if(tile.mat->interact && belowTile.mat->id >= 0 && belowTile.mat->id < Materials::nMaterials && tile.mat->nInteractions[belowTile.mat->id] > 0) {
-                                //    for(int i = 0; i < tile.mat->nInteractions[belowTile.mat->id]; i++) {
-                                //        MaterialInteraction in = tile.mat->interactions[belowTile.mat->id][i];
-                                //        if(in.type == INTERACT_TRANSFORM_MATERIAL) {
-                                //            for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                //                for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                //                    if(tiles[(x + xx) + (y + yy) * width].mat->id == belowTile.mat->id) {
-                                //                        tiles[(x + xx) + (y + yy) * width] = Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy);
-                                //                        dirty[(x + xx) + (y + yy) * width] = true;
-                                //                        tickVisited[(x + xx) + (y + yy) * width] = true;
-                                //                    }
-                                //                }
-                                //            }
-                                //        } else if(in.type == INTERACT_SPAWN_MATERIAL) {
-                                //            for(int xx = in.ofsX - in.data2; xx <= in.ofsX + in.data2; xx++) {
-                                //                for(int yy = in.ofsY - in.data2; yy <= in.ofsY + in.data2; yy++) {
-                                //                    if((xx == 0 && yy == 0) || tiles[(x + xx) + (y + yy) * width].mat->id == Tiles::NOTHING.mat->id) {
-                                //                        tiles[(x + xx) + (y + yy) * width] = Tiles::create(Materials::MATERIALS[in.data1], x + xx, y + yy);
-                                //                        dirty[(x + xx) + (y + yy) * width] = true;
-                                //                        tickVisited[(x + xx) + (y + yy) * width] = true;
-                                //                    }
-                                //                }
-                                //            }
-                                //        }
-                                //    }
-                                //    continue;
-                                //}
-
-                                //if(tile.mat->react && tile.mat->nReactions > 0) {
-                                //    bool react = false;
-                                //    for(int i = 0; i < tile.mat->nReactions; i++) {
-                                //        MaterialInteraction in = tile.mat->reactions[i];
-                                //        if(in.type == REACT_TEMPERATURE_BELOW) {
-                                //            if(tile.temperature < in.data1) {
-                                //                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
-                                //                tiles[index].temperature = tile.temperature;
-                                //                dirty[index] = true;
-                                //                tickVisited[index] = true;
-                                //                react = true;
-                                //            }
-                                //        } else if(in.type == REACT_TEMPERATURE_ABOVE) {
-                                //            if(tile.temperature > in.data1) {
-                                //                tiles[index] = Tiles::create(Materials::MATERIALS[in.data2], x, y);
-                                //                tiles[index].temperature = tile.temperature;
-                                //                dirty[index] = true;
-                                //                tickVisited[index] = true;
-                                //                react = true;
-                                //            }
-                                //        }
-                                //    }
-                                //    if(react) continue;
-                                //}
-
-                                ///*if (tile.mat->id == Materials::WATER.id && belowTile.mat->id == Materials::LAVA.id) {
-                                //    tiles[index] = Tiles::createSteam();
-                                //    dirty[index] = true;
-                                //    tiles[(x)+(y + 1) * width] = Tiles::createObsidian(x, y + 1);
-                                //    dirty[(x)+(y + 1) * width] = true;
-                                //    tickVisited[(x)+(y + 1) * width] = true;
-
-                                //    for (int xx = -1; xx <= 1; xx++) {
-                                //        for (int yy = 0; yy <= 2; yy++) {
-                                //            if (tiles[(x + xx) + (y + yy) * width].mat->id == Materials::LAVA.id) {
-                                //                tiles[(x + xx) + (y + yy) * width] = Tiles::createObsidian(x + xx, y + yy);
-                                //                dirty[(x + xx) + (y + yy) * width] = true;
-                                //                tickVisited[(x + xx) + (y + yy) * width] = true;
-                                //            }
-                                //        }
-                                //    }
-
-                                //    continue;
-                                //}*/
-
-                                //bool canMoveBelow = (below == PhysicsType::AIR || (below != PhysicsType::SOLID && belowTile.mat->density < tile.mat->density));
-                                //if(!canMoveBelow) continue;
-
-                                //MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
-                                //int belowL = belowLTile.mat->physicsType;
-                                //MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
-                                //int belowR = belowRTile.mat->physicsType;
-
-                                //bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                //bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
-
-                                //if(canMoveBelow && !((canMoveBelowL || canMoveBelowR) && rand() % 10 == 0)) {
-                                //    if(belowTile.mat->physicsType == PhysicsType::AIR && getTile(x, y + 2).mat->physicsType == PhysicsType::AIR && getTile(x, y + 3).mat->physicsType == PhysicsType::AIR && getTile(x, y + 4).mat->physicsType == PhysicsType::AIR) {
-                                //        setTile(x, y, belowTile);
-                                //        #ifdef DO_MULTITHREADING
-                                //        parts.push_back(new Particle(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
-                                //        #else
-                                //        particles.push_back(new Particle(tile, x, y + 1, (rand() % 10 - 5) / 20.0f, -((rand() % 2) + 3) / 10.0f + 1.5f, 0, 0.1f));
-                                //        #endif
-                                //    } else {
-                                //        tiles[index] = belowTile;
-                                //        dirty[index] = true;
-                                //        //setTile(x, y, belowTile);
-                                //        //setTile(x, y + 1, tile);
-                                //        tiles[(x)+(y + 1) * width] = tile;
-                                //        dirty[(x)+(y + 1) * width] = true;
-                                //        tickVisited[x + (y + 1) * width] = true;
-                                //    }
-                                //}
-                            } else if(type == PhysicsType::GAS) {
-                                //active[index] = true;
-                                int above = tiles[(x)+(y - 1) * width].mat->physicsType;
-
-                                int aboveL = tiles[(x - 1) + (y - 1) * width].mat->physicsType;
-                                int aboveR = tiles[(x + 1) + (y - 1) * width].mat->physicsType;
-
-                                if(above == 0 && !((aboveL == 0 || aboveR == 0) && rand() % 2 == 0)) {
-                                    tiles[index] = getTile(x, y - 1);
-                                    dirty[index] = true;
-
-                                    tiles[(x)+(y - 1) * width] = tile;
-                                    dirty[(x)+(y - 1) * width] = true;
-
-                                    tickVisited[(x)+(y - 1) * width] = true;
-                                }
-                            }
+                        if(tickVisited[index] == epoch) continue;
+
+                        if(cellPlanes) {
+                            int t = physicsAt(index);
+                            if(t != PhysicsType::SAND && t != PhysicsType::SOUP && t != PhysicsType::GAS) continue;
                         }
-                    }
-                    EASY_END_BLOCK;
 
-                    EASY_BLOCK("iter 2");
-                    for(int dy = CHUNK_H - 1; dy >= 0; dy--) {
-                        int y = cy + dy;
-                        for(int dxf = 0; dxf < CHUNK_W; dxf++) {
-                            int dx = reverseX ? (CHUNK_W - 1) - dxf : dxf;
-                            int x = cx + dx;
-                            int index = x + y * width;
+                        MaterialInstance tile = tiles[index];
 
-                            if(tickVisited[index]) continue;
+                        int type = tile.mat->physicsType;
 
-                            MaterialInstance tile = tiles[index];
+                        if(type == PhysicsType::SAND) {
+                            //active[index] = true;
+                            MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+                            int belowL = belowLTile.mat->physicsType;
+                            MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+                            int belowR = belowRTile.mat->physicsType;
 
-                            int type = tile.mat->physicsType;
+                            bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                            bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
 
-                            if(type == PhysicsType::SAND) {
-                                //active[index] = true;
-                                MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
-                                int belowL = belowLTile.mat->physicsType;
-                                MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
-                                int belowR = belowRTile.mat->physicsType;
+                            bool stoppedByFriction = !tile.moved;
 
-                                bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
+                            // 1 to ~127
+                            int slipperyness = tile.mat->slipperyness;
 
-                                bool stoppedByFriction = !tile.moved;
+                            if(stoppedByFriction) {
+                                int drop = 0;
 
-                                // 1 to ~127
-                                int slipperyness = tile.mat->slipperyness;
+                                for(int pil = 0; pil < 10; pil++) {
+                                    int pilChL = physicsAt((x - 1) + (y + 1 + pil) * width);
+                                    int pilChR = physicsAt((x + 1) + (y + 1 + pil) * width);
 
-                                if(stoppedByFriction) {
-                                    int drop = 0;
+                                    if(pilChL == PhysicsType::AIR || pilChR == PhysicsType::AIR) {
+                                        drop++;
+                                    }
+                                }
 
-                                    for(int pil = 0; pil < 10; pil++) {
-                                        int pilChL = tiles[(x - 1) + (y + 1 + pil) * width].mat->physicsType;
-                                        int pilChR = tiles[(x + 1) + (y + 1 + pil) * width].mat->physicsType;
+                                // max number of pixels tall a pillar can be before being unstable
+                                int maxStability = 8 / sqrt(slipperyness) + 1;
 
-                                        if(pilChL == PhysicsType::AIR || pilChR == PhysicsType::AIR) {
-                                            drop++;
+                                if(drop + 1 - maxStability > 0) {
+                                    int chance = 1000 / (drop + 1 - maxStability);
+                                    if(chance < 1000) {
+                                        if(rng.next() % chance == 0) {
+                                            stoppedByFriction = false;
+                                            tiles[(x)+(y)*width].moved = true;
+                                            #ifdef DEBUG_FRICTION
+                                            tiles[(x)+(y)*width].color = 0xff0000ff;
+                                            markDirty(x, y);
+                                            #endif
                                         }
                                     }
+                                }
+                            }
 
-                                    // max number of pixels tall a pillar can be before being unstable
-                                    int maxStability = 8 / sqrt(slipperyness) + 1;
-
-                                    if(drop + 1 - maxStability > 0) {
-                                        int chance = 1000 / (drop + 1 - maxStability);
-                                        if(chance < 1000) {
-                                            if(rand() % chance == 0) {
-                                                stoppedByFriction = false;
-                                                tiles[(x)+(y)*width].moved = true;
-                                                #ifdef DEBUG_FRICTION
-                                                tiles[(x)+(y)*width].color = 0xff0000ff;
-                                                dirty[(x)+(y)*width] = true;
-                                                #endif
-                                            }
+                            if(stoppedByFriction || !(canMoveBelowL || canMoveBelowR)) {
+                                tiles[(x)+(y)*width].moved = false;
+                                #ifdef DEBUG_FRICTION
+                                tiles[(x)+(y)*width].color = 0xff000000;
+                                markDirty(x, y);
+                                #endif
+                                continue;
+                            }
+
+                            bool shouldMove = rng.next() % (2 * slipperyness) != 0;
+
+                            if(shouldMove && (canMoveBelowL || canMoveBelowR)) {
+                                int selfTrasmitMovementChance = 2;
+
+                                if(rng.next() % selfTrasmitMovementChance == 0) {
+                                    if(physicsAt((x)+(y + 1) * width) == PhysicsType::SAND) {
+                                        int otherTransmitMovementChance = 2;
+                                        if(rng.next() % otherTransmitMovementChance == 0) {
+                                            tiles[(x) + (y + 1) * width].moved = true;
+                                            #ifdef DEBUG_FRICTION
+                                            tiles[(x) + (y + 1) * width].color = 0xffff00ff;
+                                            markDirty(x, y + 1);
+                                            #endif
                                         }
                                     }
                                 }
+                            }
+
+                            if(shouldMove && canMoveBelowL && (!canMoveBelowR || rng.next() % 2 == 0)) {
+                                if(physicsAt((x - 1) + y * width) == PhysicsType::AIR) {
+                                    put((x - 1) + y * width, belowLTile);
+                                    markDirty(x - 1, y);
+                                    wake(x - 1, y);
+                                    tickVisited[(x - 1) + (y)* width] = epoch;
+                                    put(index, Tiles::NOTHING);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                } else {
+                                    put(index, belowLTile);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                    tickVisited[index] = epoch;
+                                }
 
-                                if(stoppedByFriction || !(canMoveBelowL || canMoveBelowR)) {
-                                    tiles[(x)+(y)*width].moved = false;
+                                if(rng.next() % (20 * slipperyness) == 0) {
+                                    tile.moved = false;
                                     #ifdef DEBUG_FRICTION
-                                    tiles[(x)+(y)*width].color = 0xff000000;
-                                    dirty[(x)+(y)*width] = true;
+                                    tile.color = 0xff000000;
                                     #endif
-                                    continue;
+                                }
+                                put((x - 1) + (y + 1) * width, tile);
+                                markDirty(x - 1, y + 1);
+                                wake(x - 1, y + 1);
+                                tickVisited[(x - 1) + (y + 1) * width] = epoch;
+
+                            } else if(shouldMove && canMoveBelowR) {
+
+                                if(physicsAt((x + 1) + y * width) == PhysicsType::AIR) {
+                                    put((x + 1) + y * width, belowRTile);
+                                    markDirty(x + 1, y);
+                                    wake(x + 1, y);
+                                    put(index, Tiles::NOTHING);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                } else {
+                                    put(index, belowRTile);
+                                    markDirty(x, y);
+                                    wake(x, y);
+                                    tickVisited[index] = epoch;
                                 }
 
-                                bool shouldMove = rand() % (2 * slipperyness) != 0;
+                                if(rng.next() % (20 * slipperyness) == 0) {
+                                    tile.moved = false;
+                                    #ifdef DEBUG_FRICTION
+                                    tile.color = 0xff000000;
+                                    #endif
+                                }
+                                put((x + 1) + (y + 1) * width, tile);
+                                markDirty(x + 1, y + 1);
+                                wake(x + 1, y + 1);
+                                tickVisited[(x + 1) + (y + 1) * width] = epoch;
+
+                            } else {
+                                tiles[(x)+(y)*width].moved = false;
+                                #ifdef DEBUG_FRICTION
+                                tiles[(x)+(y)*width].color = 0xff000000;
+                                markDirty(x, y);
+                                #endif
+                            }
+                        } else if(type == PhysicsType::SOUP) {
+
+                            bool changed = tile.fluidAmountDiff != 0.0f;
+                            tile.fluidAmount += tile.fluidAmountDiff;
+                            tile.fluidAmountDiff = 0.0f;
+                            if(tile.fluidAmount < FLUID_MinValue) {
+                                put(index, Tiles::NOTHING);
+                                markDirty(x, y);
+                                wake(x, y);
+                                tickVisited[index] = epoch;
+                            } else {
+                                put(index, tile);
+                                /*uint8_t c = (1.0f - tile.fluidAmount / 8.0f) * 255;
+                                int rgb = c;
+                                rgb = (rgb << 8) + c;
+                                rgb = (rgb << 8) + c;
+                                tiles[index].color = rgb;*/
+                                markDirty(x, y);
+                                if(changed) wake(x, y);
+                                tickVisited[index] = epoch;
+                            }
 
-                                if(shouldMove && (canMoveBelowL || canMoveBelowR)) {
-                                    int selfTrasmitMovementChance = 2;
+                            // OLD:
 
-                                    if(rand() % selfTrasmitMovementChance == 0) {
-                                        if(tiles[(x)+(y + 1) * width].mat->physicsType == PhysicsType::SAND) {
-                                            int otherTransmitMovementChance = 2;
-                                            if(rand() % otherTransmitMovementChance == 0) {
-                                                tiles[(x) + (y + 1) * width].moved = true;
-                                                #ifdef DEBUG_FRICTION
-                                                tiles[(x) + (y + 1) * width].color = 0xffff00ff;
-                                                dirty[(x) + (y + 1) * width] = true;
-                                                #endif
-                                            }
-                                        }
-                                    }
-                                }
+                            //active[index] = true;
+                            /*MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
+                            int belowL = belowLTile.mat->physicsType;
+                            MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
+                            int belowR = belowRTile.mat->physicsType;
+
+                            bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
+                            bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
 
-                                if(shouldMove && canMoveBelowL && (!canMoveBelowR || rand() % 2 == 0)) {
+                            if(!(canMoveBelowL || canMoveBelowR)) continue;
+
+                            MaterialInstance lTile = tiles[(x - 1) + (y)* width];
+                            int l = lTile.mat->physicsType;
+                            MaterialInstance rTile = tiles[(x + 1) + (y)* width];
+                            int r = rTile.mat->physicsType;
+
+                            bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
+                            bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
+
+                            if(!((canMoveL || canMoveR) && rand() % 10 == 0)) {
+                                if(canMoveBelowL && !(canMoveBelowR && rand() % 2 == 0)) {
                                     if(tiles[(x - 1) + y * width].mat->physicsType == PhysicsType::AIR) {
                                         tiles[(x - 1) + y * width] = belowLTile;
-                                        dirty[(x - 1) + y * width] = true;
-                                        tickVisited[(x - 1) + (y)* width] = true;
+                                        markDirty(x - 1, y);
                                         tiles[index] = Tiles::NOTHING;
-                                        dirty[index] = true;
+                                        markDirty(x, y);
                                     } else {
                                         tiles[index] = belowLTile;
-                                        dirty[index] = true;
-                                        tickVisited[index] = true;
+                                        markDirty(x, y);
                                     }
 
-                                    if(rand() % (20 * slipperyness) == 0) {
-                                        tile.moved = false;
-                                        #ifdef DEBUG_FRICTION
-                                        tile.color = 0xff000000;
-                                        #endif
-                                    }
                                     tiles[(x - 1) + (y + 1) * width] = tile;
-                                    dirty[(x - 1) + (y + 1) * width] = true;
-                                    tickVisited[(x - 1) + (y + 1) * width] = true;
-
-                                } else if(shouldMove && canMoveBelowR) {
-
+                                    markDirty(x - 1, y + 1);
+                                    tickVisited[(x - 1) + (y + 1) * width] = epoch;
+                                } else if(canMoveBelowR) {
                                     if(tiles[(x + 1) + y * width].mat->physicsType == PhysicsType::AIR) {
                                         tiles[(x + 1) + y * width] = belowRTile;
-                                        dirty[(x + 1) + y * width] = true;
+                                        markDirty(x + 1, y);
                                         tiles[index] = Tiles::NOTHING;
-                                        dirty[index] = true;
+                                        markDirty(x, y);
                                     } else {
                                         tiles[index] = belowRTile;
-                                        dirty[index] = true;
-                                        tickVisited[index] = true;
+                                        markDirty(x, y);
                                     }
 
-                                    if(rand() % (20 * slipperyness) == 0) {
-                                        tile.moved = false;
-                                        #ifdef DEBUG_FRICTION
-                                        tile.color = 0xff000000;
-                                        #endif
-                                    }
                                     tiles[(x + 1) + (y + 1) * width] = tile;
-                                    dirty[(x + 1) + (y + 1) * width] = true;
-                                    tickVisited[(x + 1) + (y + 1) * width] = true;
-
-                                } else {
-                                    tiles[(x)+(y)*width].moved = false;
-                                    #ifdef DEBUG_FRICTION
-                                    tiles[(x)+(y)*width].color = 0xff000000;
-                                    dirty[(x) + (y) * width] = true;
-                                    #endif
-                                }
-                            } else if(type == PhysicsType::SOUP) {
-
-                                tile.fluidAmount += tile.fluidAmountDiff;
-                                tile.fluidAmountDiff = 0.0f;
-                                if(tile.fluidAmount < FLUID_MinValue) {
-                                    tiles[index] = Tiles::NOTHING;
-                                    dirty[index] = true;
-                                    tickVisited[index] = true;
-                                } else {
-                                    tiles[index] = tile;
-                                    /*uint8_t c = (1.0f - tile.fluidAmount / 8.0f) * 255;
-                                    int rgb = c;
-                                    rgb = (rgb << 8) + c;
-                                    rgb = (rgb << 8) + c;
-                                    tiles[index].color = rgb;*/
-                                    dirty[index] = true;
-                                    tickVisited[index] = true;
+                                    markDirty(x + 1, y + 1);
+                                    tickVisited[(x + 1) + (y + 1) * width] = epoch;
                                 }
+                            }*/
+                        } else if(type == PhysicsType::GAS) {
+                            //active[index] = true;
+                            int aboveL = physicsAt((x - 1) + (y - 1) * width);
+                            int aboveR = physicsAt((x + 1) + (y - 1) * width);
+
+                            if(aboveL == 0 && !(aboveR == 0 && rng.next() % 2 == 0)) {
+                                put(index, tiles[(x - 1) + (y - 1) * width]);
+                                markDirty(x, y);
+                                wake(x, y);
+
+                                put((x - 1) + (y - 1) * width, tile);
+                                markDirty(x - 1, y - 1);
+                                wake(x - 1, y - 1);
+                                tickVisited[(x - 1) + (y - 1) * width] = epoch;
+                            } else if(aboveR == 0) {
+                                put(index, tiles[(x + 1) + (y - 1) * width]);
+                                markDirty(x, y);
+                                wake(x, y);
+
+                                put((x + 1) + (y - 1) * width, tile);
+                                markDirty(x + 1, y - 1);
+                                wake(x + 1, y - 1);
+                                tickVisited[(x + 1) + (y - 1) * width] = epoch;
+                            }
+                        }
+                    }
+                }
+                EASY_END_BLOCK;
 
-                                // OLD:
-
-                                //active[index] = true;
-                                /*MaterialInstance belowLTile = tiles[(x - 1) + (y + 1) * width];
-                                int belowL = belowLTile.mat->physicsType;
-                                MaterialInstance belowRTile = tiles[(x + 1) + (y + 1) * width];
-                                int belowR = belowRTile.mat->physicsType;
-
-                                bool canMoveBelowL = (belowL == PhysicsType::AIR || (belowL != PhysicsType::SOLID && belowLTile.mat->density < tile.mat->density));
-                                bool canMoveBelowR = (belowR == PhysicsType::AIR || (belowR != PhysicsType::SOLID && belowRTile.mat->density < tile.mat->density));
-
-                                if(!(canMoveBelowL || canMoveBelowR)) continue;
-
-                                MaterialInstance lTile = tiles[(x - 1) + (y)* width];
-                                int l = lTile.mat->physicsType;
-                                MaterialInstance rTile = tiles[(x + 1) + (y)* width];
-                                int r = rTile.mat->physicsType;
-
-                                bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
-                                bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
-
-                                if(!((canMoveL || canMoveR) && rand() % 10 == 0)) {
-                                    if(canMoveBelowL && !(canMoveBelowR && rand() % 2 == 0)) {
-                                        if(tiles[(x - 1) + y * width].mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x - 1) + y * width] = belowLTile;
-                                            dirty[(x - 1) + y * width] = true;
-                                            tiles[index] = Tiles::NOTHING;
-                                            dirty[index] = true;
-                                        } else {
-                                            tiles[index] = belowLTile;
-                                            dirty[index] = true;
-                                        }
+                growSim();
+                EASY_BLOCK("iter 3");
+                for(int dy = sim.h - 1; dy >= 0; dy--) {
+                    int y = sim.y + dy;
+                    for(int dxf = 0; dxf < sim.w; dxf++) {
+                        int dx = reverseX ? (sim.w - 1) - dxf : dxf;
+                        int x = sim.x + dx;
+                        int index = x + y * width;
 
-                                        tiles[(x - 1) + (y + 1) * width] = tile;
-                                        dirty[(x - 1) + (y + 1) * width] = true;
-                                        tickVisited[(x - 1) + (y + 1) * width] = true;
-                                    } else if(canMoveBelowR) {
-                                        if(tiles[(x + 1) + y * width].mat->physicsType == PhysicsType::AIR) {
-                                            tiles[(x + 1) + y * width] = belowRTile;
-                                            dirty[(x + 1) + y * width] = true;
-                                            tiles[index] = Tiles::NOTHING;
-                                            dirty[index] = true;
-                                        } else {
-                                            tiles[index] = belowRTile;
-                                            dirty[index] = true;
-                                        }
+                        if(tickVisited[index] == epoch) continue;
 
-                                        tiles[(x + 1) + (y + 1) * width] = tile;
-                                        dirty[(x + 1) + (y + 1) * width] = true;
-                                        tickVisited[(x + 1) + (y + 1) * width] = true;
-                                    }
-                                }*/
-                            } else if(type == PhysicsType::GAS) {
-                                //active[index] = true;
-                                int aboveL = tiles[(x - 1) + (y - 1) * width].mat->physicsType;
-                                int aboveR = tiles[(x + 1) + (y - 1) * width].mat->physicsType;
-
-                                if(aboveL == 0 && !(aboveR == 0 && rand() % 2 == 0)) {
-                                    tiles[index] = tiles[(x - 1) + (y - 1) * width];
-                                    dirty[index] = true;
-
-                                    tiles[(x - 1) + (y - 1) * width] = tile;
-                                    dirty[(x - 1) + (y - 1) * width] = true;
-                                    tickVisited[(x - 1) + (y - 1) * width] = true;
-                                } else if(aboveR == 0) {
-                                    tiles[index] = tiles[(x + 1) + (y - 1) * width];
-                                    dirty[index] = true;
-
-                                    tiles[(x + 1) + (y - 1) * width] = tile;
-                                    dirty[(x + 1) + (y - 1) * width] = true;
-                                    tickVisited[(x + 1) + (y - 1) * width] = true;
-                                }
-                            }
+                        if(cellPlanes) {
+                            int t = physicsAt(index);
+                            if(t != PhysicsType::SOUP && t != PhysicsType::GAS) continue;
                         }
-                    }
-                    EASY_END_BLOCK;
 
-                    EASY_BLOCK("iter 3");
-                    for(int dy = CHUNK_H - 1; dy >= 0; dy--) {
-                        int y = cy + dy;
-                        for(int dxf = 0; dxf < CHUNK_W; dxf++) {
-                            int dx = reverseX ? (CHUNK_W - 1) - dxf : dxf;
-                            int x = cx + dx;
-                            int index = x + y * width;
-
-                            if(tickVisited[index]) continue;
-
-                            MaterialInstance tile = tiles[index];
-
-                            int type = tile.mat->physicsType;
-
-                            if(type == PhysicsType::SOUP) {
-                                //active[index] = true;
-
-                                /*MaterialInstance lTile = tiles[(x - 1) + (y)* width];
-                                int l = lTile.mat->physicsType;
-                                MaterialInstance rTile = tiles[(x + 1) + (y)* width];
-                                int r = rTile.mat->physicsType;
-
-                                bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
-                                bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
-
-                                if(canMoveL && !(canMoveR && rand() % 2 == 5)) {
-                                    tiles[index] = lTile;
-                                    dirty[index] = true;
-
-                                    tiles[(x - 1) + (y)* width] = tile;
-                                    dirty[(x - 1) + (y)* width] = true;
-                                    tickVisited[(x - 1) + (y)* width] = true;
-                                } else if(canMoveR) {
-                                    tiles[index] = rTile;
-                                    dirty[index] = true;
-
-                                    tiles[(x + 1) + (y)* width] = tile;
-                                    dirty[(x + 1) + (y)* width] = true;
-                                    tickVisited[(x + 1) + (y)* width] = true;
-                                }*/
-                            } else if(type == PhysicsType::GAS) {
-                                //active[index] = true;
-
-                                int l = tiles[(x - 1) + (y)* width].mat->physicsType;
-                                int r = tiles[(x + 1) + (y)* width].mat->physicsType;
-
-                                if(l == 0 && !(r == 0 && rand() % 2 == 0)) {
-                                    tiles[index] = getTile(x - 1, y);
-                                    dirty[index] = true;
-
-                                    tiles[(x - 1) + (y)* width] = tile;
-                                    dirty[(x - 1) + (y)* width] = true;
-                                    tickVisited[(x - 1) + (y)* width] = true;
-                                } else if(r == 0) {
-                                    tiles[index] = getTile(x + 1, y);
-                                    dirty[index] = true;
-
-                                    tiles[(x + 1) + (y)* width] = tile;
-                                    dirty[(x + 1) + (y)* width] = true;
-                                    tickVisited[(x + 1) + (y)* width] = true;
-                                } else {
-                                    if(tile.mat->id == Materials::STEAM.id) {
-                                        if(rand() % 10 == 0) {
-                                            tiles[index] = Tiles::createWater();
-                                            dirty[index] = true;
-                                        }
+                        MaterialInstance tile = tiles[index];
+
+                        int type = tile.mat->physicsType;
+
+                        if(type == PhysicsType::SOUP) {
+                            //active[index] = true;
+
+                            /*MaterialInstance lTile = tiles[(x - 1) + (y)* width];
+                            int l = lTile.mat->physicsType;
+                            MaterialInstance rTile = tiles[(x + 1) + (y)* width];
+                            int r = rTile.mat->physicsType;
+
+                            bool canMoveL = (l == PhysicsType::AIR || (l != PhysicsType::SOLID && lTile.mat->density < tile.mat->density));
+                            bool canMoveR = (r == PhysicsType::AIR || (r != PhysicsType::SOLID && rTile.mat->density < tile.mat->density));
+
+                            if(canMoveL && !(canMoveR && rand() % 2 == 5)) {
+                                tiles[index] = lTile;
+                                markDirty(x, y);
+
+                                tiles[(x - 1) + (y)* width] = tile;
+                                markDirty(x - 1, y);
+                                tickVisited[(x - 1) + (y)* width] = epoch;
+                            } else if(canMoveR) {
+                                tiles[index] = rTile;
+                                markDirty(x, y);
+
+                                tiles[(x + 1) + (y)* width] = tile;
+                                markDirty(x + 1, y);
+                                tickVisited[(x + 1) + (y)* width] = epoch;
+                            }*/
+                        } else if(type == PhysicsType::GAS) {
+                            //active[index] = true;
+
+                            int l = physicsAt((x - 1) + (y)* width);
+                            int r = physicsAt((x + 1) + (y)* width);
+
+                            if(l == 0 && !(r == 0 && rng.next() % 2 == 0)) {
+                                put(index, getTile(x - 1, y));
+                                markDirty(x, y);
+                                wake(x, y);
+
+                                put((x - 1) + (y)* width, tile);
+                                markDirty(x - 1, y);
+                                wake(x - 1, y);
+                                tickVisited[(x - 1) + (y)* width] = epoch;
+                            } else if(r == 0) {
+                                put(index, getTile(x + 1, y));
+                                markDirty(x, y);
+                                wake(x, y);
+
+                                put((x + 1) + (y)* width, tile);
+                                markDirty(x + 1, y);
+                                wake(x + 1, y);
+                                tickVisited[(x + 1) + (y)* width] = epoch;
+                            } else {
+                                if(tile.mat->id == Materials::STEAM.id) {
+                                    // trapped steam stays awake until it condenses
+                                    wake(x, y);
+                                    if(rng.next() % 10 == 0) {
+                                        put(index, Tiles::createWater());
+                                        markDirty(x, y);
+                                        wake(x, y);
                                     }
                                 }
                             }
                         }
                     }
-                    EASY_END_BLOCK;
-                    EASY_END_BLOCK;
-                    #ifdef DO_MULTITHREADING
-                    return parts;
-                    }));
-                    #endif
-                    EASY_END_BLOCK;
                 }
-            }
-        EASY_END_BLOCK;
+                EASY_END_BLOCK;
+                if(wakeMinX <= wakeMaxX) {
+                    *wokeRect = {wakeMinX, wakeMinY, wakeMaxX - wakeMinX + 1, wakeMaxY - wakeMinY + 1};
+                }
+                EASY_END_BLOCK;
+            };
 
+        EASY_BLOCK("run chunks");
         #ifdef DO_MULTITHREADING
-        EASY_BLOCK("wait for threads", THREAD_WAIT_PROFILER_COLOR);
-        for(int i = 0; i < results.size(); i++) {
-            EASY_BLOCK("get particles");
-            std::vector<Particle*> pts = results[i].get();
-            EASY_END_BLOCK;
-            EASY_BLOCK("insert particles");
-            particles.insert(particles.end(), pts.begin(), pts.end());
-            EASY_END_BLOCK;
-        }
-        tickVisitedDone.get();
-
-        whichTickVisited = !whichTickVisited;
+        tickScheduler->run(nWoke, tickChunk);
+        #else
+        for(int i = 0; i < nWoke; i++) tickChunk(i, 0);
+        #endif
+        EASY_END_BLOCK;
 
+        EASY_BLOCK("merge active");
+        for(int i = 0; i < nWoke; i++) {
+            if(woke[i].w > 0) markWoken((chunkTasks[i].cx / CHUNK_W) + (chunkTasks[i].cy / CHUNK_H) * activeW, woke[i]);
+        }
         EASY_END_BLOCK;
-        #endif
 
-        //while (tickPool->n_idle() != tickPool->size()) {
-        //	//printf("%d / %d", tickPool->n_idle(), tickPool->size());
-        //	auto n = tickPool->n_idle();
-        //	auto i = 0;
-        //}
         EASY_END_BLOCK;
         }
 
     }
 
+    if(liquidSolver) tickLiquids();
+
+    EASY_BLOCK("merge particles");
+    for(size_t w = 1; w < tickSpawned.size(); w++) {
+        tickSpawned[0].insert(tickSpawned[0].end(), tickSpawned[w].begin(), tickSpawned[w].end());
+        tickSpawned[w].clear();
+    }
+    std::stable_sort(tickSpawned[0].begin(), tickSpawned[0].end(), [](const std::pair<uint32_t, Particle>& a, const std::pair<uint32_t, Particle>& b) {
+        return a.first < b.first;
+    });
+    for(auto& p : tickSpawned[0]) particles.add(p.second);
+    tickSpawned[0].clear();
+    EASY_END_BLOCK;
+
+    for(auto& removed : tickSolidRemoved) {
+        solidRemoved.insert(solidRemoved.end(), removed.begin(), removed.end());
+        removed.clear();
+    }
+
     #undef DEBUG_FRICTION
     #undef DO_MULTITHREADING
     #undef DO_REVERSE
 
     tickCt++;
 
+    tickFinishPending = true;
+    if(!deferTickFinish) tickFinish();
+
+    /*std::fill(light, light + width * height, 0);
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            if (tiles[x + y * width].mat->physicsType == PhysicsType::AIR) {
+                applyLightRec(x, y, 1);
+            }
+        }
+    }*/
+
+}
+
+void World::tickFinish() {
+    tickFinishPending = false;
+    publishSnapshot();
+
+    // the main thread's rng is used by particles/entities/explosions after this, keep that reproducible too
+    RNG::local().setSeed(RNG::hash(tickCt));
+
+    if(Settings::tick_island_events) {
+        tickIslands();
+        return;
+    }
+    solidRemoved.clear();
+
     EASY_BLOCK("do physicsChecks");
     for(int i = 0; i < 1; i++) {
-        int randX = rand() % tickZone.w;
-        int randY = rand() % tickZone.h;
+        int randX = RNG::local().next() % tickZone.w;
+        int randY = RNG::local().next() % tickZone.h;
         //setTile(tickZone.x + randX, tickZone.y + randY, MaterialInstance(&Materials::GENERIC_SOLID, 0x00ff00ff));
         physicsCheck(tickZone.x + randX, tickZone.y + randY);
     }
     EASY_END_BLOCK;
+}
 
-    /*delete lastActive;
-    lastActive = active;
-    active = new bool[width * height];*/
+void World::tickIslands() {
+    EASY_FUNCTION(WORLD_PROFILER_COLOR);
+    if(solidRemoved.empty()) return;
+
+    // sorted so the order doesn't depend on which thread found what
+    std::sort(solidRemoved.begin(), solidRemoved.end());
+    solidRemoved.erase(std::unique(solidRemoved.begin(), solidRemoved.end()), solidRemoved.end());
+
+    // one stamp for the whole batch: anything a flood already reached (attached or not) isn't flooded again
+    uint32_t epoch = nextIslandEpoch();
+    for(int index : solidRemoved) {
+        int x = index % width;
+        int y = index / width;
+        const int dirs[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for(auto& d : dirs) {
+            int nx = x + d[0];
+            int ny = y + d[1];
+            if(nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+            if(islandVisited[nx + ny * width] == epoch) continue;
+            if(tiles[nx + ny * width].mat->physicsType != PhysicsType::SOLID) continue;
+
+            // physicsCheck takes its own stamp, carry whatever it reached over to this batch's
+            physicsCheck(nx, ny);
+            for(int i : islandCells) islandVisited[i] = epoch;
+        }
+    }
+    solidRemoved.clear();
+}
 
-    /*std::fill(light, light + width * height, 0);
-    for (int x = 0; x < width; x++) {
-        for (int y = 0; y < height; y++) {
-            if (tiles[x + y * width].mat->physicsType == PhysicsType::AIR) {
-                applyLightRec(x, y, 1);
+uint32_t World::nextIslandEpoch() {
+    islandEpoch++;
+    if(islandEpoch == 0) {
+        memset(islandVisited, 0, (size_t)width * height * sizeof(uint32_t));
+        islandEpoch = 1;
+    }
+    return islandEpoch;
+}
+
+void World::publishSnapshot() {
+    tickSnapshot.tickCt = tickCt;
+    tickSnapshot.particles = particles.size();
+    tickSnapshot.active.assign(active, active + activeW * activeH);
+}
+
+// true if the material (id) has a temperature reaction that the given temperature would trigger
+static bool temperatureReactionReady(int mat, int32_t temperature) {
+    int nRules;
+    const MaterialInteraction* rules = CellGrid::reactionRules(mat, &nRules);
+    for(int i = 0; i < nRules; i++) {
+        const MaterialInteraction& in = rules[i];
+        if((in.type == REACT_TEMPERATURE_BELOW && temperature < in.data1) || (in.type == REACT_TEMPERATURE_ABOVE && temperature > in.data1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// one row of the temperature stencil over the cell planes, writes dst[x0 + y * width] to dst[x1 - 1 + y * width]
+static void tickTemperatureRow(const int32_t* temp, const float* cond, const Uint16* mat, int32_t* dst, int width, int y, int x0, int x1) {
+    int x = x0;
+
+    #ifdef TEMPERATURE_SSE
+    // 4 cells at a time, each lane does exactly what the scalar version does (a neighbor at 0 adds 0 to both sums)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 inv64 = _mm_set1_ps(1.0f / 64.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    for(; x + 4 <= x1; x += 4) {
+        __m128 n = _mm_set1_ps(0.01f);
+        __m128 v = zero;
+        for(int xa = -1; xa <= 1; xa++) {
+            for(int ya = -1; ya <= 1; ya++) {
+                int i = (x + xa) + (y + ya) * width;
+                __m128 t = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)&temp[i]));
+                __m128 factor = _mm_mul_ps(_mm_mul_ps(_mm_and_ps(t, absMask), inv64), _mm_loadu_ps(&cond[i]));
+                v = _mm_add_ps(v, _mm_mul_ps(t, factor));
+                n = _mm_add_ps(n, factor);
+            }
+        }
+
+        int index = x + y * width;
+        __m128i selfI = _mm_loadu_si128((const __m128i*)&temp[index]);
+        __m128 self = _mm_cvtepi32_ps(selfI);
+        __m128 cs = _mm_set_ps(CellGrid::conductionSelf[mat[index + 3]], CellGrid::conductionSelf[mat[index + 2]], CellGrid::conductionSelf[mat[index + 1]], CellGrid::conductionSelf[mat[index]]);
+        __m128i addI = _mm_set_epi32(CellGrid::addTemp[mat[index + 3]], CellGrid::addTemp[mat[index + 2]], CellGrid::addTemp[mat[index + 1]], CellGrid::addTemp[mat[index]]);
+
+        __m128 conducted = _mm_add_ps(_mm_add_ps(_mm_cvtepi32_ps(addI), _mm_mul_ps(_mm_div_ps(v, n), cs)), _mm_mul_ps(self, _mm_sub_ps(one, cs)));
+        __m128i conductedI = _mm_cvttps_epi32(conducted);
+        __m128i stillI = _mm_add_epi32(addI, selfI);
+
+        __m128i mask = _mm_castps_si128(_mm_cmpneq_ps(v, zero));
+        _mm_storeu_si128((__m128i*)&dst[index], _mm_or_si128(_mm_and_si128(mask, conductedI), _mm_andnot_si128(mask, stillI)));
+    }
+    #endif
+
+    for(; x < x1; x++) {
+        float n = 0.01;
+        float v = 0;
+        for(int xa = -1; xa <= 1; xa++) {
+            for(int ya = -1; ya <= 1; ya++) {
+                int i = (x + xa) + (y + ya) * width;
+                if(temp[i]) {
+                    float factor = abs(temp[i]) / 64.0f * cond[i];
+                    v += temp[i] * factor;
+                    n += factor;
+                }
             }
         }
-    }*/
 
+        int index = x + y * width;
+        Uint16 m = mat[index];
+        if(v != 0) {
+            dst[index] = CellGrid::addTemp[m] + (v / n * CellGrid::conductionSelf[m]) + (temp[index] * (1 - CellGrid::conductionSelf[m]));
+        } else {
+            dst[index] = CellGrid::addTemp[m] + temp[index];
+        }
+    }
 }
 
 void World::tickTemperature() {
-    // TODO: multithread
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
 
+    // with the reactive set, cells that are ready to react go straight to tickReactive
+    const bool reactiveSet = reactiveSetEnabled();
+
+    if(Settings::tick_cell_planes) {
+        // split into horizontal bands on tickScheduler
+        // the gather has to be completely done before any band reads its neighbors' rows, so it's two passes
+        int nBands = tickScheduler->size();
+
+        EASY_BLOCK("gather");
+        int gatherY = tickZone.y - 1;
+        int gatherH = tickZone.h + 2;
+        int gatherBandH = (gatherH + nBands - 1) / nBands;
+        auto gatherBand = [&](int b, int worker) {
+            int y0 = gatherY + b * gatherBandH;
+            int y1 = std::min(y0 + gatherBandH, gatherY + gatherH);
+            if(y0 >= y1) return;
+            cells.gatherTemperature(tiles, width, tickZone.x - 1, y0, tickZone.w + 2, y1 - y0);
+        };
+        tickScheduler->run(nBands, gatherBand);
+        EASY_END_BLOCK;
+
+        EASY_BLOCK("iterate planes");
+        int bandH = (tickZone.h + nBands - 1) / nBands;
+        // markActive isn't thread safe, so each band collects its own
+        std::vector<std::vector<int>> reacting(nBands);
+        auto iterateBand = [&](int b, int worker) {
+            int y0 = tickZone.y + b * bandH;
+            int y1 = std::min(y0 + bandH, tickZone.y + tickZone.h);
+            std::vector<int>* bandReacting = &reacting[b];
+            for(int y = y0; y < y1; y++) {
+                tickTemperatureRow(cells.temperature, cells.conduction, cells.material, newTemps, width, y, tickZone.x, tickZone.x + tickZone.w);
+
+                // the stencil only reads the planes, so the tiles can be updated right away (no separate copy pass)
+                for(int x = tickZone.x; x < tickZone.x + tickZone.w; x++) {
+                    MaterialInstance& tile = tiles[x + y * width];
+                    tile.temperature = newTemps[x + y * width];
+                    Uint16 mat = cells.material[x + y * width];
+                    if((CellGrid::props[mat].flags & CELL_REACT) && (Settings::tick_sleep_chunks || reactiveSet) && temperatureReactionReady(mat, tile.temperature)) {
+                        bandReacting->push_back(x + y * width);
+                    }
+                }
+            }
+        };
+        tickScheduler->run(nBands, iterateBand);
+        EASY_END_BLOCK; // iterate planes
+
+        // the plane now has the current temperatures, and the old buffer gets reused next tick
+        std::swap(cells.temperature, newTemps);
+
+        // temperature reactions happen in tick(), so make sure a sleeping chunk notices
+        for(auto& band : reacting) {
+            if(reactiveSet) {
+                reactPending.insert(reactPending.end(), band.begin(), band.end());
+            } else {
+                for(int i : band) markActive(i % width, i / width);
+            }
+        }
+        return;
+    }
+
+    // without the planes, fall back to reading the MaterialInstances directly (single threaded)
     EASY_BLOCK("iterate");
     for(int y = (tickZone.y + tickZone.h) - 1; y >= tickZone.y; y--) {
         for(int x = tickZone.x; x < (tickZone.x + tickZone.w); x++) {
@@ -2133,10 +3165,21 @@ n += factor;\
         }
     }
     EASY_END_BLOCK; // iterate
+
     EASY_BLOCK("copy");
     for(int y = (tickZone.y + tickZone.h) - 1; y >= tickZone.y; y--) {
         for(int x = tickZone.x; x < (tickZone.x + tickZone.w); x++) {
-            tiles[x + y * width].temperature = newTemps[x + y * width];
+            MaterialInstance& tile = tiles[x + y * width];
+            tile.temperature = newTemps[x + y * width];
+
+            // temperature reactions happen in tick(), so make sure a sleeping chunk notices
+            if((CellGrid::props[tile.mat->id].flags & CELL_REACT) && (Settings::tick_sleep_chunks || reactiveSet) && temperatureReactionReady(tile.mat->id, tile.temperature)) {
+                if(reactiveSet) {
+                    reactPending.push_back(x + y * width);
+                } else {
+                    markActive(x, y);
+                }
+            }
         }
     }
     EASY_END_BLOCK; // copy
@@ -2145,143 +3188,110 @@ n += factor;\
 void World::renderParticles(unsigned char** texture) {
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
 
-    for(auto& cur : particles) {
-        if(cur->x < 0 || cur->x >= width || cur->y < 0 || cur->y >= height) continue;
+    for(size_t i = 0; i < particles.size(); i++) {
+        float px = particles.x[i];
+        float py = particles.y[i];
+        if(px < 0 || px >= width || py < 0 || py >= height) continue;
 
         float alphaMod = 1;
-        if(cur->temporary) {
-            if(cur->lifetime < cur->fadeTime) {
-                alphaMod = (cur->lifetime / (float)cur->fadeTime);
+        if(particles.flags[i] & PARTICLE_TEMPORARY) {
+            if(particles.lifetime[i] < particles.fadeTime[i]) {
+                alphaMod = (particles.lifetime[i] / (float)particles.fadeTime[i]);
             }
         }
-        //float alphaMod = 1;
-        EASY_BLOCK("particle render");
-        const unsigned int offset = (width * 4 * (int)cur->y) + (int)cur->x * 4;
-        Uint32 color = cur->tile.color;
+        const unsigned int offset = (width * 4 * (int)py) + (int)px * 4;
+        const MaterialInstance& tile = particles.tile[i];
+        Uint32 color = tile.color;
         (*texture)[offset + 2] = (color >> 0) & 0xff;        // b
         (*texture)[offset + 1] = (color >> 8) & 0xff;        // g
         (*texture)[offset + 0] = (color >> 16) & 0xff;        // r
-        (*texture)[offset + 3] = (Uint8)(cur->tile.mat->alpha * alphaMod);    // a
-        //SDL_SetRenderDrawColor(renderer, (cur->tile.color >> 16) & 0xff, (cur->tile.color >> 8) & 0xff, (cur->tile.color >> 0) & 0xff, (Uint8)(cur->tile.mat->alpha * alphaMod));
-        //SDL_RenderDrawPoint(renderer, (int)cur->x, (int)cur->y);
-        EASY_END_BLOCK;
+        (*texture)[offset + 3] = (Uint8)(tile.mat->alpha * alphaMod);    // a
     }
 }
 
 void World::tickParticles() {
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
 
-    /*SDL_Rect* fr = new SDL_Rect{ 0, 0, width, height };
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
-    SDL_RenderClear(renderer);
-    delete fr;*/
-
-    particles.erase(std::remove_if(particles.begin(), particles.end(), [&](Particle* cur) {
-        EASY_BLOCK("particle tick");
-
-        if(cur->temporary && cur->lifetime <= 0) {
-            cur->killCallback();
-            delete cur;
-            return true;
-        }
-
-        if(cur->targetForce != 0) {
-            float tdx = cur->targetX - cur->x;
-            float tdy = cur->targetY - cur->y;
-            float normFac = sqrtf(tdx * tdx + tdy * tdy);
-
-            cur->vx += tdx / normFac * cur->targetForce;
-            cur->vy += tdy / normFac * cur->targetForce;
-
-            if(normFac < 100) {
-                cur->vx *= 0.95f;
-                cur->vy *= 0.95f;
-            }
-
-        }
+    // forces/acceleration/expiry for everything at once, then the movement (which needs to look at the tiles) one by one
+    particles.integrate(width, height, tickZone);
 
-        int lx = cur->x;
-        int ly = cur->y;
+    EASY_BLOCK("move");
+    for(size_t i = 0; i < particles.size(); i++) {
+        if(particles.flags[i] & PARTICLE_DEAD) continue;
 
-        if((cur->x < 0 || (int)(cur->x) >= width || cur->y < 0 || (int)(cur->y) >= height)) {
-            cur->killCallback();
-            return true;
-        }
+        float& px = particles.x[i];
+        float& py = particles.y[i];
+        float& pvx = particles.vx[i];
+        float& pvy = particles.vy[i];
 
-        if(!(lx >= tickZone.x && ly >= tickZone.y && lx < tickZone.x + tickZone.w && ly < tickZone.y + tickZone.h)) return false;
+        int lx = px;
+        int ly = py;
 
-        cur->vx += cur->ax;
-        cur->vy += cur->ay;
+        if(!(lx >= tickZone.x && ly >= tickZone.y && lx < tickZone.x + tickZone.w && ly < tickZone.y + tickZone.h)) continue;
 
-        int div = (int)((abs(cur->vx) + abs(cur->vy)) + 1);
+        int div = (int)((abs(pvx) + abs(pvy)) + 1);
 
-        float dvx = cur->vx / div;
-        float dvy = cur->vy / div;
+        float dvx = pvx / div;
+        float dvy = pvy / div;
 
-        for(int i = 0; i < div; i++) {
-            cur->x += dvx;
-            cur->y += dvy;
+        bool stop = false;
+        for(int j = 0; j < div && !stop; j++) {
+            px += dvx;
+            py += dvy;
 
-            if((cur->x < 0 || (int)(cur->x) >= width || cur->y < 0 || (int)(cur->y) >= height)) {
-                cur->killCallback();
-                return true;
+            if((px < 0 || (int)(px) >= width || py < 0 || (int)(py) >= height)) {
+                particles.kill(i);
+                break;
             }
 
-            if(!cur->phase && tiles[(int)(cur->x) + (int)(cur->y) * width].mat->physicsType != PhysicsType::AIR) {
-                bool allowCollision = true;
-                bool isObject = tiles[(int)(cur->x) + (int)(cur->y) * width].mat->physicsType == PhysicsType::OBJECT;
+            if(!(particles.flags[i] & PARTICLE_PHASE) && tiles[(int)(px) + (int)(py) * width].mat->physicsType != PhysicsType::AIR) {
+                bool isObject = tiles[(int)(px) + (int)(py) * width].mat->physicsType == PhysicsType::OBJECT;
 
-                switch(cur->inObjectState) {
+                Uint8& inObjectState = particles.inObjectState[i];
+                switch(inObjectState) {
                     case 0: // first frame of particle's life
                         if(isObject) {
-                            cur->inObjectState = 1;
+                            inObjectState = 1;
                         } else {
-                            cur->inObjectState = 2;
+                            inObjectState = 2;
                         }
                         break;
                     case 1: // particle spawned in object and was in object last tick
-                        if(!isObject) cur->inObjectState = 2;
+                        if(!isObject) inObjectState = 2;
                         break;
                 }
 
-                if(!isObject || cur->inObjectState == 2) {
-                    if(cur->temporary) {
-                        cur->killCallback();
-                        delete cur;
-                        return true;
+                if(!isObject || inObjectState == 2) {
+                    stop = true;
+
+                    if(particles.flags[i] & PARTICLE_TEMPORARY) {
+                        particles.kill(i);
+                        break;
                     }
 
+                    const MaterialInstance& tile = particles.tile[i];
                     if(tiles[(int)(lx)+(int)(ly)*width].mat->physicsType != PhysicsType::AIR) {
-                        /*for (int y = 0; y < 40; y++) {
-                            if (tiles[(int)(cur->x) + (int)(cur->y - y) * width].mat->physicsType == PhysicsType::AIR) {
-                                tiles[(int)(cur->x) + (int)(cur->y - y) * width] = cur->tile;
-                                dirty[(int)(cur->x) + (int)(cur->y - y) * width] = true;
-                                break;
-                            }
-                        }*/
-
                         bool succeeded = false;
                         {
-                            //printf("=========");
                             int X = 32;
                             int Y = 32;
                             int x = 0, y = 0, dx = 0, dy = -1;
                             int t = max(X, Y);
                             int maxI = t * t;
 
-                            for(int j = 0; j < maxI; j++) {
+                            for(int k = 0; k < maxI; k++) {
                                 if((-X / 2 <= x) && (x <= X / 2) && (-Y / 2 <= y) && (y <= Y / 2)) {
-                                    //printf("%d, %d", x, y);
-                                    //DO STUFF
-                                    if(tiles[(int)(cur->x + x) + (int)(cur->y + y) * width].mat->physicsType == PhysicsType::AIR) {
-                                        tiles[(int)(cur->x + x) + (int)(cur->y + y) * width] = cur->tile;
-                                        dirty[(int)(cur->x + x) + (int)(cur->y + y) * width] = true;
+                                    if(tiles[(int)(px + x) + (int)(py + y) * width].mat->physicsType == PhysicsType::AIR) {
+                                        tiles[(int)(px + x) + (int)(py + y) * width] = tile;
+                                        markDirty((int)(px + x), (int)(py + y));
+                                        markActive((int)(px + x), (int)(py + y));
                                         succeeded = true;
                                         break;
-                                    } else if(cur->tile.mat->physicsType == PhysicsType::SOUP && cur->tile.mat == tiles[(int)(cur->x + x) + (int)(cur->y + y) * width].mat) {
+                                    } else if(tile.mat->physicsType == PhysicsType::SOUP && tile.mat == tiles[(int)(px + x) + (int)(py + y) * width].mat) {
 
-                                        tiles[(int)(cur->x + x) + (int)(cur->y + y) * width].fluidAmount += cur->tile.fluidAmount;
-                                        dirty[(int)(cur->x + x) + (int)(cur->y + y) * width] = true;
+                                        tiles[(int)(px + x) + (int)(py + y) * width].fluidAmount += tile.fluidAmount;
+                                        markDirty((int)(px + x), (int)(py + y));
+                                        markActive((int)(px + x), (int)(py + y));
                                         succeeded = true;
                                         break;
                                     }
@@ -2295,55 +3305,43 @@ void World::tickParticles() {
                         }
 
                         if(succeeded) {
-                            cur->killCallback();
-                            delete cur;
-                            return true;
+                            particles.kill(i);
                         } else {
-                            cur->vy = -4;
-                            cur->y -= 16;
-                            return false;
+                            pvy = -4;
+                            py -= 16;
                         }
                     } else {
-                        tiles[(int)(lx)+(int)(ly)*width] = cur->tile;
-                        dirty[(int)(lx)+(int)(ly)*width] = true;
-                        cur->killCallback();
-                        delete cur;
-                        return true;
+                        tiles[(int)(lx)+(int)(ly)*width] = tile;
+                        markDirty((int)(lx), (int)(ly));
+                        markActive((int)(lx), (int)(ly));
+                        particles.kill(i);
                     }
                 }
             }
         }
 
-        if(cur->lifetime > 0) {
-            cur->lifetime--;
+        if(!stop && !(particles.flags[i] & PARTICLE_DEAD) && particles.lifetime[i] > 0) {
+            particles.lifetime[i]--;
         }
+    }
+    EASY_END_BLOCK;
 
-        EASY_END_BLOCK;
-        return false;
-    }), particles.end());
-
-    //std::for_each(particles.begin(), particles.end(), [](Particle* cur) {
-    //	cur->vx += cur->ax;
-    //	cur->vy += cur->ay;
-    //	cur->x += cur->vx;
-    //	cur->y += cur->vy;
-
-    //	//return cur->y > height;
-    //});
-
-    //std::remove_if(particles.begin(), particles.end(), [&](Particle* cur) {
-    //	return cur->y > height;
-    //});
-
+    particles.compact();
 }
 
 void World::tickObjectsMesh() {
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
+    finishHitboxJobs(false);
+
     std::vector<RigidBody*> rbs = rigidBodies;
     for(int i = 0; i < rbs.size(); i++) {
         RigidBody* cur = rbs[i];
         if(cur->needsUpdate && cur->body->IsEnabled()) {
-            updateRigidBodyHitbox(cur);
+            if(!Settings::tick_hitbox_async) {
+                updateRigidBodyHitbox(cur);
+            } else if(cur->hitboxJob == 0) {
+                queueHitbox(cur);
+            }
         }
     }
 }
@@ -2422,13 +3420,12 @@ void World::tickObjects() {
 
 }
 
-void World::addParticle(Particle* particle) {
-    EASY_FUNCTION(WORLD_PROFILER_COLOR);
-    particles.push_back(particle);
+ParticleHandle World::addParticle(const Particle& particle) {
+    return particles.add(particle);
 }
 
 void World::explosion(int cx, int cy, int radius) {
-    audioEngine->PlayEvent("event:/Explode");
+    if(audioEngine != nullptr) audioEngine->PlayEvent("event:/Explode");
 
     int outerRadius = radius * 2;
     for(int x = cx - outerRadius; x < cx + outerRadius; x++) {
@@ -2439,7 +3436,7 @@ void World::explosion(int cx, int cy, int radius) {
             int dx = x - cx;
             int dy = y - cy;
             if(dx*dx + dy * dy < radius * radius) {
-                if(tile.mat->physicsType == PhysicsType::SOLID || rand() % 10 < 6) {
+                if(tile.mat->physicsType == PhysicsType::SOLID || RNG::local().next() % 10 < 6) {
                     setTile(x, y, Tiles::NOTHING);
                 } else {
 
@@ -2453,11 +3450,11 @@ void World::explosion(int cx, int cy, int radius) {
 
                     tile.color = rgb;
 
-                    particles.push_back(new Particle(tile, x, y + 1, dx / 10.0f + (rand() % 10 - 5) / 10.0f, dy / 6.0f + (rand() % 10 - 5) / 10.0f, 0, 0.1f));
+                    particles.add(Particle(tile, x, y + 1, dx / 10.0f + (RNG::local().next() % 10 - 5) / 10.0f, dy / 6.0f + (RNG::local().next() % 10 - 5) / 10.0f, 0, 0.1f));
                     setTile(x, y, Tiles::NOTHING);
                 }
             } else if(dx*dx + dy * dy < outerRadius * outerRadius && tile.mat->physicsType != PhysicsType::SOLID) {
-                particles.push_back(new Particle(tile, x, y, dx / 10.0f + (rand() % 10 - 5) / 10.0f, dy / 6.0f + (rand() % 10 - 5) / 10.0f, 0, 0.1f));
+                particles.add(Particle(tile, x, y, dx / 10.0f + (RNG::local().next() % 10 - 5) / 10.0f, dy / 6.0f + (RNG::local().next() % 10 - 5) / 10.0f, 0, 0.1f));
                 setTile(x, y, Tiles::NOTHING);
             }
         }
@@ -2527,20 +3524,24 @@ void World::frame() {
         Chunk* merge = readyToMerge[0];
         readyToMerge.pop_front();
 
-        for(int x = 0; x < CHUNK_W; x++) {
-            for(int y = 0; y < CHUNK_H; y++) {
-                int tx = merge->x * CHUNK_W + loadZone.x + x;
-                int ty = merge->y * CHUNK_H + loadZone.y + y;
-                if(tx < 0 || tx >= width || ty < 0 || ty >= height) continue;
-
-                tiles[tx + ty * width] = merge->tiles[x + y * CHUNK_W];
-                dirty[tx + ty * width] = true;
-                layer2[tx + ty * width] = merge->layer2[x + y * CHUNK_W];
-                layer2Dirty[tx + ty * width] = true;
-                background[tx + ty * width] = merge->background[x + y * CHUNK_W];
-                backgroundDirty[tx + ty * width] = true;
+        SDL_Rect r;
+        if(chunkGridRect(merge->x, merge->y, &r)) {
+            EASY_BLOCK("merge chunk");
+            int ofsX = r.x - (merge->x * CHUNK_W + loadZone.x);
+            int ofsY = r.y - (merge->y * CHUNK_H + loadZone.y);
+            for(int y = 0; y < r.h; y++) {
+                int src = ofsX + (ofsY + y) * CHUNK_W;
+                int dst = r.x + (r.y + y) * width;
+                std::copy(merge->tiles + src, merge->tiles + src + r.w, tiles + dst);
+                std::copy(merge->layer2 + src, merge->layer2 + src + r.w, layer2 + dst);
+                std::copy(merge->background + src, merge->background + src + r.w, background + dst);
             }
+            markDirty(r.x, r.y, r.w, r.h);
+            markLayer2Dirty(r.x, r.y, r.w, r.h);
+            markBackgroundDirty(r.x, r.y, r.w, r.h);
+            EASY_END_BLOCK;
         }
+        markActive(merge->x * CHUNK_W + loadZone.x, merge->y * CHUNK_H + loadZone.y, CHUNK_W, CHUNK_H);
 
         //delete prop;
     }
@@ -2560,6 +3561,7 @@ void World::tickChunkGeneration() {
             Chunk* m = p2.second;
 
             if(abs(m->x - cenX) >= CHUNK_UNLOAD_DIST || abs(m->y - cenY) >= CHUNK_UNLOAD_DIST) {
+                releaseChunkMesh(m);
                 unloadChunk(m);
                 continue;
             }
@@ -2586,7 +3588,7 @@ void World::tickChunkGeneration() {
             m->generationPhase++;
             populateChunk(m, m->generationPhase, true);
 
-            m->write(m->tiles, m->layer2, m->background);
+            if(!noSaveLoad) chunkWriter->queue(m);
             //std::async(&Chunk::write, m, m->tiles);
 
             if(n++ > 4) {
@@ -2610,24 +3612,12 @@ void World::tickChunks() {
         int changeY = loadZone.y - lastLoadZone.y;
 
         if(changeX != 0 || changeY != 0) {
-            EASY_BLOCK("iterate");
-            bool revX = changeX > 0;
-            bool revY = changeY > 0;
-
-            for(int y = 0; y < height; y++) {
-                int oldY = (revY ? (height - y - 1) : y);
-                int newY = oldY + changeY;
-                if(newY < 0 || newY >= height) continue;
-                for(int x = 0; x < width; x++) {
-                    int oldX = (revX ? (width - x - 1) : x);
-                    int newX = oldX + changeX;
-                    if(newX >= 0 && newX < width) {
-                        tiles[newX + newY * width] = tiles[oldX + oldY * width];
-                        background[newX + newY * width] = background[oldX + oldY * width];
-                        layer2[newX + newY * width] = layer2[oldX + oldY * width];
-                    }
-                }
-            }
+            EASY_BLOCK("shift");
+            shiftGrid(tiles, sizeof(MaterialInstance), width, height, changeX, changeY);
+            shiftGrid(cells.material, sizeof(Uint16), width, height, changeX, changeY);
+            shiftGrid(background, sizeof(Uint32), width, height, changeX, changeY);
+            shiftGrid(layer2, sizeof(MaterialInstance), width, height, changeX, changeY);
+            shiftReactive(changeX, changeY);
             EASY_END_BLOCK;
 
             if(changeX < 0) {
@@ -2726,10 +3716,21 @@ void World::tickChunks() {
                 }
             }
 
-            for(int i = 0; i < particles.size(); i++) {
-                particles[i]->x += changeX;
-                particles[i]->y += changeY;
+            EASY_BLOCK("shift active rects");
+            // the tiles moved, so the active rects have to move with them (and get re-split into the new chunks)
+            std::vector<SDL_Rect> oldActive(activeW * activeH * 2);
+            for(int i = 0; i < activeW * activeH; i++) {
+                oldActive[i] = active[i];
+                oldActive[i + activeW * activeH] = lastActive[i];
+                active[i] = {0, 0, 0, 0};
+                lastActive[i] = {0, 0, 0, 0};
             }
+            for(auto& r : oldActive) {
+                if(r.w > 0 && r.h > 0) markActive(r.x + changeX, r.y + changeY, r.w, r.h);
+            }
+            EASY_END_BLOCK;
+
+            particles.translate(changeX, changeY);
 
             for(int i = 0; i < rigidBodies.size(); i++) {
                 RigidBody cur = *rigidBodies[i];
@@ -2742,6 +3743,67 @@ void World::tickChunks() {
     }
 }
 
+void World::shiftGrid(void* data, size_t elemSize, int w, int h, int dx, int dy) {
+    if(abs(dx) >= w || abs(dy) >= h) return;
+
+    char* bytes = (char*)data;
+    size_t stride = elemSize * w;
+    size_t rowBytes = elemSize * (w - abs(dx));
+    size_t dstOfs = elemSize * std::max(dx, 0);
+    size_t srcOfs = elemSize * std::max(-dx, 0);
+
+    // go against the shift so rows aren't overwritten before they're copied
+    int rows = h - abs(dy);
+    for(int i = 0; i < rows; i++) {
+        int srcY = dy > 0 ? (rows - 1 - i) : (i - dy);
+        int dstY = srcY + dy;
+        memmove(bytes + (size_t)dstY * stride + dstOfs, bytes + (size_t)srcY * stride + srcOfs, rowBytes);
+    }
+}
+
+// marks every tile of the rect in `flags` and every DIRTY_TILE_SIZE tile it touches in `tileFlags`
+static void markDirtyRect(bool* flags, bool* tileFlags, int width, int tilesW, int x, int y, int w, int h) {
+    for(int yy = y; yy < y + h; yy++) {
+        memset(&flags[x + yy * width], true, w);
+    }
+    for(int ty = y >> DIRTY_TILE_SHIFT; ty <= (y + h - 1) >> DIRTY_TILE_SHIFT; ty++) {
+        for(int tx = x >> DIRTY_TILE_SHIFT; tx <= (x + w - 1) >> DIRTY_TILE_SHIFT; tx++) {
+            tileFlags[tx + ty * tilesW] = true;
+        }
+    }
+}
+
+void World::markDirty(int x, int y, int w, int h) {
+    markDirtyRect(dirty, dirtyTiles, width, dirtyTilesW, x, y, w, h);
+}
+
+void World::markLayer2Dirty(int x, int y, int w, int h) {
+    markDirtyRect(layer2Dirty, layer2DirtyTiles, width, dirtyTilesW, x, y, w, h);
+}
+
+void World::markBackgroundDirty(int x, int y, int w, int h) {
+    markDirtyRect(backgroundDirty, backgroundDirtyTiles, width, dirtyTilesW, x, y, w, h);
+}
+
+void World::takeDirtyRects(bool* tileFlags, std::vector<SDL_Rect>& rects) {
+    for(int ty = 0; ty < dirtyTilesH; ty++) {
+        int y = ty * DIRTY_TILE_SIZE;
+        int h = std::min(DIRTY_TILE_SIZE, height - y);
+        for(int tx = 0; tx < dirtyTilesW; tx++) {
+            if(!tileFlags[tx + ty * dirtyTilesW]) continue;
+
+            int startX = tx;
+            while(tx < dirtyTilesW && tileFlags[tx + ty * dirtyTilesW]) {
+                tileFlags[tx + ty * dirtyTilesW] = false;
+                tx++;
+            }
+
+            int x = startX * DIRTY_TILE_SIZE;
+            rects.push_back({x, y, std::min(tx * DIRTY_TILE_SIZE, (int)width) - x, h});
+        }
+    }
+}
+
 void World::queueLoadChunk(int cx, int cy, bool populate, bool render) {
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
     //toLoad.push_back(LoadChunkParams(cx, cy, populate, 0));
@@ -2810,19 +3872,13 @@ void World::queueLoadChunk(int cx, int cy, bool populate, bool render) {
     }
 
     EASY_BLOCK("fill temp tiles");
-    for(int x = 0; x < CHUNK_W; x++) {
-        int tx = cx * CHUNK_W + loadZone.x + x;
-        if(tx < 0) continue;
-        if(tx >= width) break;
-        for(int y = 0; y < CHUNK_H; y++) {
-            int ty = cy * CHUNK_H + loadZone.y + y;
-            if(ty < 0) continue;
-            if(ty >= height) break;
-
-            tiles[tx + ty * width] = Tiles::TEST_SOLID;
-            //dirty[tx + ty * width] = true;
+    SDL_Rect r;
+    if(chunkGridRect(cx, cy, &r)) {
+        for(int y = r.y; y < r.y + r.h; y++) {
+            std::fill(tiles + r.x + y * width, tiles + r.x + r.w + y * width, Tiles::TEST_SOLID);
         }
     }
+    markActive(cx * CHUNK_W + loadZone.x, cy * CHUNK_H + loadZone.y, CHUNK_W, CHUNK_H);
     EASY_END_BLOCK;
     //loadChunk(cx, cy, populate);
 }
@@ -2834,6 +3890,9 @@ Chunk* World::loadChunk(Chunk* ch, bool populate, bool render) {
 
     ch->pleaseDelete = false;
 
+    // make sure an unload that's still waiting to be written doesn't get read back stale
+    if(!ch->hasTileCache && !noSaveLoad) chunkWriter->waitFor(ch->x, ch->y);
+
     if(ch->hasTileCache) {
         //prop = ch->tiles;
     } else if(ch->hasFile() && !noSaveLoad) {
@@ -2843,7 +3902,7 @@ Chunk* World::loadChunk(Chunk* ch, bool populate, bool render) {
         ch->generationPhase = 0;
         ch->hasTileCache = true;
         populateChunk(ch, 0, false);
-        if(!noSaveLoad) ch->write(ch->tiles, ch->layer2, ch->background);
+        if(!noSaveLoad) chunkWriter->queue(ch);
     }
 
     //if (populate) {
@@ -2923,24 +3982,50 @@ void World::unloadChunk(Chunk* ch) {
 }
 
 void World::writeChunkToDisk(Chunk* ch) {
-    ch->write(ch->tiles, ch->layer2, ch->background);
+    chunkWriter->queue(ch);
 }
 
 void World::chunkSaveCache(Chunk* ch) {
-    for (int x = 0; x < CHUNK_W; x++) {
-    	for (int y = 0; y < CHUNK_H; y++) {
-    		int tx = ch->x * CHUNK_W + loadZone.x + x;
-    		int ty = ch->y * CHUNK_H + loadZone.y + y;
-    		if (tx < 0 || tx >= width || ty < 0 || ty >= height) continue;
-            if(tiles[tx + ty * width] == Tiles::TEST_SOLID) continue;
-    		ch->tiles[x + y * CHUNK_W] = tiles[tx + ty * width];
-    		ch->layer2[x + y * CHUNK_W] = layer2[tx + ty * width];
-    		ch->background[x + y * CHUNK_W] = background[tx + ty * width];
-    	}
+    SDL_Rect r;
+    if(!chunkGridRect(ch->x, ch->y, &r)) return;
+
+    int ofsX = r.x - (ch->x * CHUNK_W + loadZone.x);
+    int ofsY = r.y - (ch->y * CHUNK_H + loadZone.y);
+    for(int y = 0; y < r.h; y++) {
+        int src = r.x + (r.y + y) * width;
+        int dst = ofsX + (ofsY + y) * CHUNK_W;
+
+        // copy runs between the placeholder tiles queueLoadChunk fills unloaded chunks with (they aren't saved)
+        int x = 0;
+        while(x < r.w) {
+            if(tiles[src + x] == Tiles::TEST_SOLID) {
+                x++;
+                continue;
+            }
+            int x0 = x;
+            while(x < r.w && !(tiles[src + x] == Tiles::TEST_SOLID)) x++;
+            std::copy(tiles + src + x0, tiles + src + x, ch->tiles + dst + x0);
+            std::copy(layer2 + src + x0, layer2 + src + x, ch->layer2 + dst + x0);
+            std::copy(background + src + x0, background + src + x, ch->background + dst + x0);
+        }
     }
 }
 
+bool World::chunkGridRect(int cx, int cy, SDL_Rect* r) {
+    int x0 = cx * CHUNK_W + loadZone.x;
+    int y0 = cy * CHUNK_H + loadZone.y;
+    int x1 = std::max(x0, 0);
+    int y1 = std::max(y0, 0);
+    int x2 = std::min(x0 + CHUNK_W, (int)width);
+    int y2 = std::min(y0 + CHUNK_H, (int)height);
+    if(x1 >= x2 || y1 >= y2) return false;
+
+    *r = {x1, y1, x2 - x1, y2 - y1};
+    return true;
+}
+
 void World::generateChunk(Chunk* ch) {
+    RNG::local().setSeed(RNG::hash(noise.GetSeed(), ch->x, ch->y));
     gen->generateChunk(this, ch);
 }
 
@@ -3008,7 +4093,8 @@ void World::addStructure(PlacedStructure str) {
             //if(ch.e)
             if(dx >= 0 && dy >= 0 && dx < width && dy < height) {
                 tiles[dx + dy * width] = str.base.tiles[x + y * str.base.w];
-                dirty[dx + dy * width] = true;
+                markDirty(dx, dy);
+                markActive(dx, dy);
             }
         }
     }
@@ -3077,6 +4163,8 @@ void World::populateChunk(Chunk* ch, int phase, bool render) {
 
     long long start = Time::millis();
 
+    RNG::local().setSeed(RNG::hash(noise.GetSeed(), ch->x, ch->y, phase));
+
     int ax = (ch->x - phase);
     int ay = (ch->y - phase);
     int aw = 1 + (phase * 2);
@@ -3120,7 +4208,7 @@ void World::populateChunk(Chunk* ch, int phase, bool render) {
         for(int y = 0; y < ah; y++) {
             if(dirtyChunk[x + y * aw]) {
                 if(x != aw / 2 && y != ah / 2) {
-                    chs[x + y * aw]->write(chs[x + y * aw]->tiles, chs[x + y * aw]->layer2, chs[x + y * aw]->background);
+                    if(!noSaveLoad) chunkWriter->queue(chs[x + y * aw]);
                     if(render) {
                         for(int i = 0; i < readyToMerge.size(); i++) {
                             if(readyToMerge[i] == chs[x + y * aw]) {
@@ -3208,9 +4296,10 @@ void World::tickEntities(GPU_Target* t) {
                                 } else {
                                     MaterialInstance tp = tiles[sx + sy * width];
                                     if(tp.mat->physicsType == PhysicsType::SAND) {
-                                        addParticle(new Particle(tp, sx, sy, (rand() % 10 - 5) / 10.0f + 0.5f, (rand() % 10 - 5) / 10.0f, 0, 0.1f));
+                                        addParticle(Particle(tp, sx, sy, (RNG::local().next() % 10 - 5) / 10.0f + 0.5f, (RNG::local().next() % 10 - 5) / 10.0f, 0, 0.1f));
                                         tiles[sx + sy * width] = Tiles::NOTHING;
-                                        dirty[sx + sy * width] = true;
+                                        markDirty(sx, sy);
+                                        markActive(sx, sy);
 
                                         cur->vx *= 0.99;
                                     } else {
@@ -3262,9 +4351,10 @@ void World::tickEntities(GPU_Target* t) {
                                 } else {
                                     MaterialInstance tp = tiles[sx + sy * width];
                                     if(tp.mat->physicsType == PhysicsType::SAND) {
-                                        addParticle(new Particle(tp, sx, sy, (rand() % 10 - 5) / 10.0f - 0.5f, (rand() % 10 - 5) / 10.0f, 0, 0.1f));
+                                        addParticle(Particle(tp, sx, sy, (RNG::local().next() % 10 - 5) / 10.0f - 0.5f, (RNG::local().next() % 10 - 5) / 10.0f, 0, 0.1f));
                                         tiles[sx + sy * width] = Tiles::NOTHING;
-                                        dirty[sx + sy * width] = true;
+                                        markDirty(sx, sy);
+                                        markActive(sx, sy);
 
                                         cur->vx *= 0.99;
                                     } else {
@@ -3332,9 +4422,10 @@ void World::tickEntities(GPU_Target* t) {
                             if(tiles[sx + sy * width].mat->physicsType == PhysicsType::SOLID || tiles[sx + sy * width].mat->physicsType == PhysicsType::SAND || tiles[sx + sy * width].mat->physicsType == PhysicsType::OBJECT) {
                                 MaterialInstance tp = tiles[sx + sy * width];
                                 if(tp.mat->physicsType == PhysicsType::SAND) {
-                                    addParticle(new Particle(tp, sx, sy, (rand() % 10 - 5) / 10.0f, (rand() % 10 - 5) / 10.0f - 0.5f, 0, 0.1f));
+                                    addParticle(Particle(tp, sx, sy, (RNG::local().next() % 10 - 5) / 10.0f, (RNG::local().next() % 10 - 5) / 10.0f - 0.5f, 0, 0.1f));
                                     tiles[sx + sy * width] = Tiles::NOTHING;
-                                    dirty[sx + sy * width] = true;
+                                    markDirty(sx, sy);
+                                    markActive(sx, sy);
 
                                     cur->vy *= 0.99;
                                 } else {
@@ -3441,46 +4532,32 @@ void World::forLineCornered(int x0, int y0, int x1, int y1, std::function<bool(i
 
 RigidBody* World::physicsCheck(int x, int y) {
     EASY_FUNCTION(WORLD_PROFILER_COLOR);
+    islandCells.clear();
     if(getTile(x, y).mat->physicsType != PhysicsType::SOLID) return nullptr;
 
-    EASY_BLOCK("alloc");
-    static bool* visited = new bool[width * height];
-    EASY_END_BLOCK;
-    EASY_BLOCK("memset");
-    memset(visited, false, (size_t)width * height);
-    EASY_END_BLOCK;
-
-    EASY_BLOCK("alloc");
-    static uint32* cols = new uint32[width * height];
-    EASY_END_BLOCK;
-    EASY_BLOCK("memset");
-    memset(cols, 0x00, (size_t)width * height * sizeof(uint32)); // init to all 0s
-    EASY_END_BLOCK;
-
-    int count = 0;
     int minX = width;
     int maxX = 0;
     int minY = height;
     int maxY = 0;
 
     EASY_BLOCK("Do physicsCheck_flood");
-    physicsCheck_flood(x, y, visited, &count, cols, &minX, &maxX, &minY, &maxY);
+    bool small = physicsCheck_flood(x, y, 1000, &minX, &maxX, &minY, &maxY);
     EASY_END_BLOCK;
+    int count = (int)islandCells.size();
 
-    if(count > 0 && count <= 1000) {
+    if(small && count > 0) {
         if(count > 10) {
             EASY_BLOCK("SDL_CreateRGBSurfaceWithFormat", SDL_PROFILER_COLOR);
             SDL_Surface* tex = SDL_CreateRGBSurfaceWithFormat(0, maxX - minX + 1, maxY - minY + 1, 32, SDL_PIXELFORMAT_ARGB8888);
             EASY_END_BLOCK;
             EASY_BLOCK("iterate");
-            for(int yy = minY; yy <= maxY; yy++) {
-                for(int xx = minX; xx <= maxX; xx++) {
-                    if(visited[xx + yy * width]) {
-                        PIXEL(tex, (unsigned long long)(xx) - minX, yy - minY) = cols[xx + yy * width];
-                        tiles[xx + yy * width] = Tiles::NOTHING;
-                        dirty[xx + yy * width] = true;
-                    }
-                }
+            for(int i : islandCells) {
+                int xx = i % width;
+                int yy = i / width;
+                PIXEL(tex, (unsigned long long)(xx) - minX, yy - minY) = tiles[i].color;
+                tiles[i] = Tiles::NOTHING;
+                markDirty(xx, yy);
+                markActive(xx, yy);
             }
             EASY_END_BLOCK;
 
@@ -3497,7 +4574,7 @@ RigidBody* World::physicsCheck(int x, int y) {
             bf.maskBits = 0xffff;
             rb->body->GetFixtureList()[0].SetFilterData(bf);
 
-            rb->body->SetLinearVelocity({(float)((rand() % 100) / 100.0 - 0.5), (float)((rand() % 100) / 100.0 - 0.5)});
+            rb->body->SetLinearVelocity({(float)((RNG::local().next() % 100) / 100.0 - 0.5), (float)((RNG::local().next() % 100) / 100.0 - 0.5)});
 
             rigidBodies.push_back(rb);
             updateRigidBodyHitbox(rb);
@@ -3512,7 +4589,7 @@ RigidBody* World::physicsCheck(int x, int y) {
                 for (int xx = minX; xx <= maxX; xx++) {
                     if (visited[xx + yy * width]) {
                         tiles[xx + yy * width] = Tiles::NOTHING;
-                        dirty[xx + yy * width] = true;
+                        markDirty(xx, yy);
                     }
                 }
             }
@@ -3527,26 +4604,55 @@ RigidBody* World::physicsCheck(int x, int y) {
     return nullptr;
 }
 
-// Helper for World::physicsCheck that does the 4-way recursive flood fill
-void World::physicsCheck_flood(int x, int y, bool* visited, int* count, uint32* cols, int* minX, int* maxX, int* minY, int* maxY) {
-    if(*count > 1000 || x < 0 || x >= width || y < 0 || y >= height) return;
-    if(!visited[x + y * width] && getTile(x, y).mat->physicsType == PhysicsType::SOLID) {
-        if(x < *minX) *minX = x;
-        if(x > *maxX) *maxX = x;
-        if(y < *minY) *minY = y;
-        if(y > *maxY) *maxY = y;
-
-        visited[x + y * width] = true;
-        (*count)++;
-        //setTile(x, y, MaterialInstance(&Materials::GENERIC_SOLID, 0xff00ffff));
-
-        cols[x + y * width] = tiles[x + y * width].color;
-
-        physicsCheck_flood(x + 1, y, visited, count, cols, minX, maxX, minY, maxY);
-        physicsCheck_flood(x, y + 1, visited, count, cols, minX, maxX, minY, maxY);
-        physicsCheck_flood(x - 1, y, visited, count, cols, minX, maxX, minY, maxY);
-        physicsCheck_flood(x, y - 1, visited, count, cols, minX, maxX, minY, maxY);
+// Helper for World::physicsCheck
+// fills whole runs of a row at once and only pushes the start of each run above/below it, so the stack stays small
+bool World::physicsCheck_flood(int x, int y, int maxCells, int* minX, int* maxX, int* minY, int* maxY) {
+    uint32_t epoch = nextIslandEpoch();
+    islandCells.clear();
+    islandStack.clear();
+
+    auto open = [&](int i) {
+        return islandVisited[i] != epoch && tiles[i].mat->physicsType == PhysicsType::SOLID;
+    };
+
+    if(x < 0 || x >= width || y < 0 || y >= height) return true;
+    islandStack.push_back(x + y * width);
+    while(!islandStack.empty()) {
+        int i = islandStack.back();
+        islandStack.pop_back();
+        if(!open(i)) continue;
+
+        int sy = i / width;
+        int lx = i % width;
+        int rx = lx;
+        while(lx > 0 && open(lx - 1 + sy * width)) lx--;
+        while(rx < width - 1 && open(rx + 1 + sy * width)) rx++;
+
+        // touching the edge of the grid counts as attached, it may go on in chunks that aren't loaded
+        if(lx == 0 || rx == width - 1 || sy == 0 || sy == height - 1) return false;
+
+        for(int sx = lx; sx <= rx; sx++) {
+            islandVisited[sx + sy * width] = epoch;
+            islandCells.push_back(sx + sy * width);
+        }
+        if((int)islandCells.size() > maxCells) return false;
+
+        *minX = std::min(*minX, lx);
+        *maxX = std::max(*maxX, rx);
+        *minY = std::min(*minY, sy);
+        *maxY = std::max(*maxY, sy);
+
+        for(int ny = sy - 1; ny <= sy + 1; ny += 2) {
+            if(ny < 0 || ny >= height) continue;
+            bool inRun = false;
+            for(int sx = lx; sx <= rx; sx++) {
+                bool o = open(sx + ny * width);
+                if(o && !inRun) islandStack.push_back(sx + ny * width);
+                inRun = o;
+            }
+        }
     }
+    return true;
 }
 
 WorldMeta WorldMeta::loadWorldMeta(std::string worldFileName) {
@@ -3622,26 +4728,32 @@ World::~World() {
     delete[] flowY;
     delete[] layer2;
     delete[] background;
+    delete[] dirtyTiles;
+    delete[] layer2DirtyTiles;
+    delete[] backgroundDirtyTiles;
 
-    for(auto& v : particles) {
-        delete v;
-    }
     particles.clear();
 
-    tickPool->clear_queue();
+    // the jobs only touch their own copies, so they just have to be done before they're freed
+    for(HitboxJob* job : hitboxJobs) {
+        job->done.wait();
+        delete job;
+    }
+    hitboxJobs.clear();
+
     loadChunkPool->clear_queue();
-    tickVisitedPool->clear_queue();
     updateRigidBodyHitboxPool->clear_queue();
 
+    // finishes writing everything that's queued
+    delete chunkWriter;
+    if(!noSaveLoad) Regions::close(worldName);
+
     /*tickPool->stop(false);
     delete tickPool;
 
     loadChunkPool->stop(false);
     delete loadChunkPool;
 
-    tickVisitedPool->stop(false);
-    delete tickVisitedPool;
-
     updateRigidBodyHitboxPool->stop(false);
     delete updateRigidBodyHitboxPool;*/
 
@@ -3652,8 +4764,9 @@ World::~World() {
     delete[] backgroundDirty;
     delete[] lastActive;
     delete[] active;
-    delete[] tickVisited1;
-    delete[] tickVisited2;
+    delete[] tickVisited;
+    delete[] fireListed;
+    delete[] islandVisited;
 
     delete b2world;
 
@@ -3670,6 +4783,10 @@ World::~World() {
         delete v;
     }
     worldRigidBodies.clear();
+    for(auto& v : meshTempChunks) {
+        delete v;
+    }
+    meshTempChunks.clear();
 
     toLoad.clear();
 
@@ -17,9 +17,13 @@
 #include "RigidBody.hpp"
 #endif
 #include "PlacedStructure.hpp"
+#include "CellGrid.hpp"
+#include "ChunkWriter.hpp"
+#include "TickScheduler.hpp"
 #include "ChunkReadyToMerge.hpp"
 #include <future>
 #include <unordered_map>
+#include <functional>
 #include "lib/FastNoiseSIMD/FastNoiseSIMD.h"
 #include "lib/FastNoise/FastNoise.h"
 #include "lib/sparsehash/dense_hash_map.h"
@@ -45,6 +49,16 @@
 
 #define CHUNK_UNLOAD_DIST 16
 
+// dirty flags are also tracked per DIRTY_TILE_SIZE*DIRTY_TILE_SIZE tile (must be a power of 2)
+#define DIRTY_TILE_SHIFT 5
+#define DIRTY_TILE_SIZE (1 << DIRTY_TILE_SHIFT)
+
+// World::chunkLod, value is log2 of how many ticks apart the chunk ticks
+#define LOD_FULL    0
+#define LOD_HALF    1
+#define LOD_QUARTER 2
+#define LOD_SETTLE  3 // every 4th tick, only while active
+
 class Populator;
 class WorldGenerator;
 class Player;
@@ -86,6 +100,56 @@ public:
 // Adjusts flow speed (0.0f - 1.0f)
 #define FLUID_FlowSpeed 1.0f
 
+float CalculateVerticalFlowValue(float remainingLiquid, float destLiquid);
+
+// the parts of World::tick's state the renderer looks at, copied by tickFinish on the main thread
+// tick() can run on Game's sim thread while the frame is rendered, so overlays read this instead of the live world
+class TickSnapshot {
+public:
+    int tickCt = 0;
+    size_t particles = 0;
+    std::vector<SDL_Rect> active; // lastActive of the next tick (what it's going to simulate)
+};
+
+// one body split off by HitboxJob::build, pixels are w * h of the trimmed body
+class HitboxFragment {
+public:
+    std::vector<b2PolygonShape> triangles;
+    std::vector<Uint32> pixels;
+    bool weld = false;
+};
+
+// the geometry part of World::updateRigidBodyHitbox (mask -> simplified outlines -> triangles -> fragments)
+// build() only reads the copy of the body's pixels made by World::snapshotHitbox, so it can run on updateRigidBodyHitboxPool
+//   while the body keeps simulating, and World::applyHitbox swaps the bodies in on the main thread
+class HitboxJob {
+public:
+    RigidBody* rb = nullptr;
+    uint32_t id = 0;
+    std::future<void> done;
+    // rb->tilesVersion when the pixels were copied
+    uint32_t tilesVersion = 0;
+
+    // (alpha << 24) + color of every tile, srcW * srcH
+    std::vector<Uint32> pixels;
+    int srcW = 0;
+    int srcH = 0;
+    int weldX = -1;
+    int weldY = -1;
+
+    // bounds of the opaque pixels (w or h <= 0 if there aren't any)
+    int minX = 0;
+    int minY = 0;
+    int w = 0;
+    int h = 0;
+    std::list<TPPLPoly> outline;
+    std::vector<HitboxFragment> fragments;
+    // each fragment needs its own pass
+    bool split = false;
+
+    void build();
+};
+
 class World {
 public:
 
@@ -96,13 +160,15 @@ public:
     GPU_Target* target = nullptr;
 
     MaterialInstance* tiles = nullptr;
+    // SoA copy of tiles (the material plane is kept in sync by tick(), see CellGrid)
+    CellGrid cells;
     float* flowX = nullptr;
     float* flowY = nullptr;
     float* prevFlowX = nullptr;
     float* prevFlowY = nullptr;
     MaterialInstance* layer2 = nullptr;
     Uint32* background = nullptr;
-    std::vector<Particle *> particles;
+    ParticleSystem particles;
     uint16_t width = 0;
     uint16_t height = 0;
     void init(std::string worldPath, uint16_t w, uint16_t h, GPU_Target* renderer, CAudioEngine* audioEngine, int netMode, WorldGenerator* generator);
@@ -112,16 +178,74 @@ public:
     MaterialInstance getTileLayer2(int x, int y);
     void setTileLayer2(int x, int y, MaterialInstance type);
     int tickCt = 0;
-    static ctpl::thread_pool* tickPool;
-    static ctpl::thread_pool* tickVisitedPool;
+    static TickScheduler* tickScheduler;
     static ctpl::thread_pool* updateRigidBodyHitboxPool;
     static ctpl::thread_pool* loadChunkPool;
 
     GPU_Image* fireTex = nullptr;
-    bool* tickVisited1 = nullptr;
-    bool* tickVisited2 = nullptr;
+    // tick() stamps cells that already moved during the current pass with tickVisitedEpoch
+    uint16_t* tickVisited = nullptr;
+    uint16_t tickVisitedEpoch = 0;
+    // bumps tickVisitedEpoch (clearing tickVisited when it wraps)
+    uint16_t nextTickEpoch();
 
     void tick();
+    // only written by tickFinish, which never overlaps the sim thread, so render code can read it at any time
+    TickSnapshot tickSnapshot;
+    inline const TickSnapshot& snapshot() const {
+        return tickSnapshot;
+    }
+    void publishSnapshot();
+    // the end of tick() that has to happen on the main thread (reseeds its RNG, physicsCheck makes rigid bodies)
+    // tick() runs it itself unless deferTickFinish is set, then whoever ran tick() calls it once the tiles are plain terrain again
+    // (Game stamps rigid bodies into the grid for tick(), and picks them back up before this)
+    void tickFinish();
+    bool deferTickFinish = false;
+    bool tickFinishPending = false;
+    // particles spawned by tick() on each tickScheduler thread (tagged with a sort key so merging them is deterministic)
+    std::vector<std::vector<std::pair<uint32_t, Particle>>> tickSpawned;
+
+    // liquid solver (Settings::tick_liquid_solver), called at the end of tick()
+    // runs Settings::tick_liquid_substeps substeps over only the unsettled liquid in the active rects
+    void tickLiquids();
+    // per chunk (indexed like active), cells that are still flowing / flow that spilled into other chunks during a substep
+    std::vector<std::vector<int>> liquidCells;
+    std::vector<std::vector<int>> liquidSpill;
+
+    // sparse set of fire and reacting cells (Settings::tick_reactive_set), called at the start of tick()
+    // burning fire stays in its chunk's list (and doesn't keep the chunk awake), so fire costs as much as the burning front
+    // temperature reactions only look at the cells tickTemperature found to be ready (reactPending)
+    void tickReactive();
+    // keeps the fire lists pointing at the same tiles when tickChunks shifts the grid
+    void shiftReactive(int dx, int dy);
+    std::vector<std::vector<int>> fireCells;
+    std::vector<std::vector<int>> fireSpill;
+    Uint8* fireListed = nullptr; // 1 if the cell is in one of the fire lists (or firePending)
+    std::vector<int> firePending; // fire that spread into chunks outside tickZone
+    std::vector<int> reactPending;
+
+    // distance based level of detail (Settings::tick_lod), updated by updateLod at the start of tick()
+    // chunks within a chunk of lodFocus tick every tick, the next ring every 2nd tick, the next two every 4th
+    //   (each chunk on its own phase so the work is spread out), and anything further only settles:
+    //   it ticks every 4th tick while it's active but can't wake other settling chunks
+    // chunks that are skipped keep their active rect until their turn
+    SDL_Rect lodFocus {}; // in tile coords (Game sets it to what's on screen), w == 0 for all of tickZone
+    std::vector<Uint8> chunkLod; // LOD_* of each chunk (indexed like active)
+    std::vector<Uint8> chunkTicking; // 1 if the chunk ticks this tick
+    void updateLod();
+    // chunkInTickZone and LOD says it ticks this tick
+    inline bool chunkTicksNow(int ci) {
+        return chunkTicking[ci] && chunkInTickZone(ci);
+    }
+    // markActive for a rect woken by chunk ci (keeps settling chunks from waking each other)
+    void markWoken(int ci, const SDL_Rect& r);
+
+    // index (into active) of a chunk is in tickZone
+    bool chunkInTickZone(int ci);
+    // runs step(ci, tk, task, worker) for every chunk ticking this tick with anything in lists[ci] on tickScheduler, returning the rect it woke
+    // uses the same checkerboard as tick(), and in between moves everything in spill[] to the list of the chunk it's in
+    //   (or passes it to dropped if that chunk isn't in tickZone)
+    void runChunkLists(std::vector<std::vector<int>>& lists, std::vector<std::vector<int>>& spill, std::function<SDL_Rect(int ci, int tk, int task, int worker)> step, std::function<void(int index)> dropped);
 
     void tickTemperature();
     int32_t* newTemps = nullptr;
@@ -132,15 +256,51 @@ public:
     void tickObjects();
     void tickObjectsMesh();
     void tickChunks();
+    // shifts a w*h grid of elemSize byte elements by dx,dy with one memmove per row
+    // the newly exposed strips are left as they were
+    static void shiftGrid(void* data, size_t elemSize, int w, int h, int dx, int dy);
     void tickChunkGeneration();
     bool needToTickGeneration = false;
-    void addParticle(Particle* particle);
+    ParticleHandle addParticle(const Particle& particle);
     void explosion(int x, int y, int radius);
     bool* dirty = nullptr;
-    bool* active = nullptr;
-    bool* lastActive = nullptr;
+    // per-chunk rects (in tile coords) of tiles that need to be simulated
+    // tick() only looks at tiles inside lastActive/active, so settled chunks are skipped entirely
+    SDL_Rect* active = nullptr;
+    SDL_Rect* lastActive = nullptr;
+    int activeW = 0;
+    int activeH = 0;
+    void markActive(int x, int y);
+    void markActive(int x, int y, int w, int h);
     bool* layer2Dirty = nullptr;
     bool* backgroundDirty = nullptr;
+    // one flag per DIRTY_TILE_SIZE tile that has anything set in dirty/layer2Dirty/backgroundDirty
+    // so the renderer only has to repack and upload those tiles
+    // always go through markDirty etc. so the two stay in sync
+    bool* dirtyTiles = nullptr;
+    bool* layer2DirtyTiles = nullptr;
+    bool* backgroundDirtyTiles = nullptr;
+    int dirtyTilesW = 0;
+    int dirtyTilesH = 0;
+    inline void markDirty(int x, int y) {
+        dirty[x + y * width] = true;
+        dirtyTiles[(x >> DIRTY_TILE_SHIFT) + (y >> DIRTY_TILE_SHIFT) * dirtyTilesW] = true;
+    }
+    inline void markLayer2Dirty(int x, int y) {
+        layer2Dirty[x + y * width] = true;
+        layer2DirtyTiles[(x >> DIRTY_TILE_SHIFT) + (y >> DIRTY_TILE_SHIFT) * dirtyTilesW] = true;
+    }
+    inline void markBackgroundDirty(int x, int y) {
+        backgroundDirty[x + y * width] = true;
+        backgroundDirtyTiles[(x >> DIRTY_TILE_SHIFT) + (y >> DIRTY_TILE_SHIFT) * dirtyTilesW] = true;
+    }
+    // same as calling markDirty etc. for every tile in the rect (which has to be inside the grid), one row at a time
+    void markDirty(int x, int y, int w, int h);
+    void markLayer2Dirty(int x, int y, int w, int h);
+    void markBackgroundDirty(int x, int y, int w, int h);
+    // appends the flagged tiles of `tileFlags` (one of the arrays above) to `rects` in tile coords and clears the flags
+    // horizontally adjacent tiles are merged into one rect
+    void takeDirtyRects(bool* tileFlags, std::vector<SDL_Rect>& rects);
     SDL_Rect loadZone {};
     SDL_Rect lastLoadZone {};
     SDL_Rect tickZone {};
@@ -155,11 +315,34 @@ public:
 
     RigidBody* makeRigidBody(b2BodyType type, float x, float y, float angle, b2PolygonShape shape, float density, float friction, SDL_Surface* texture);
     RigidBody* makeRigidBodyMulti(b2BodyType type, float x, float y, float angle, std::vector<b2PolygonShape> shape, float density, float friction, SDL_Surface* texture);
+    // rebuilds the body's hitbox right away (replaces it with new bodies, rb is deleted)
     void updateRigidBodyHitbox(RigidBody* rb);
+    // hitboxes being built on updateRigidBodyHitboxPool (Settings::tick_hitbox_async), applied by tickObjectsMesh
+    std::vector<HitboxJob*> hitboxJobs;
+    uint32_t nextHitboxJob = 0;
+    void snapshotHitbox(RigidBody* rb, HitboxJob& job);
+    void queueHitbox(RigidBody* rb);
+    // applies every job that finished (or all of them if wait is set)
+    void finishHitboxJobs(bool wait);
+    // async leaves the pieces of a split body to the next tickObjectsMesh instead of rebuilding them right away
+    void applyHitbox(RigidBody* rb, HitboxJob& job, bool async);
 
     std::vector<std::vector<b2Vec2>> worldMeshes;
     std::vector<std::vector<b2Vec2>> worldTris;
+    // rebuilds the chunk's polys only if its solid mask changed (by chunkSolidHash), otherwise just moves its body with loadZone
     void updateChunkMesh(Chunk* chunk);
+    // marching squares outlines, triangulated
+    void buildChunkPolys(Chunk* chunk, int chTx, int chTy);
+    // axis aligned boxes made by merging runs of solid cells down the rows (Settings::tick_box_colliders)
+    void buildChunkBoxes(Chunk* chunk, int chTx, int chTy);
+    uint64_t chunkSolidHash(int chTx, int chTy);
+    // destroys the chunk's body (its polys stay cached)
+    void releaseChunkMesh(Chunk* chunk);
+    // chunks with a body, and the updateWorldMesh pass that last saw each of them in meshZone (Chunk::meshStamp)
+    std::vector<Chunk*> meshChunks;
+    int meshStamp = 0;
+    // temporary chunks from getChunk that have a body until the next updateWorldMesh
+    std::vector<Chunk*> meshTempChunks;
     void updateWorldMesh();
     std::vector<RigidBody*> worldRigidBodies;
 
@@ -168,9 +351,15 @@ public:
     std::deque<Chunk*> readyToMerge;
     void queueLoadChunk(int cx, int cy, bool populate, bool render);
     Chunk* loadChunk(Chunk*, bool populate, bool render);
+    // doesn't touch the chunk's body (it can run on other threads), call releaseChunkMesh on the main thread first
     void unloadChunk(Chunk* ch);
     void writeChunkToDisk(Chunk* ch);
+    // all chunk writes go through this so they don't block the main thread (flushed when the world is deleted)
+    ChunkWriter* chunkWriter = nullptr;
     void chunkSaveCache(Chunk* ch);
+    // the part of chunk (cx, cy) that's currently in the grid (in tile coords), false if none of it is
+    // chunks are CHUNK_W*CHUNK_H row-major blocks, so each row of this rect is one contiguous run in both
+    bool chunkGridRect(int cx, int cy, SDL_Rect* r);
     WorldGenerator* gen = nullptr;
     void generateChunk(Chunk* ch);
     Biome* getBiomeAt(int x, int y);
@@ -203,8 +392,24 @@ public:
     void forLine(int x0, int y0, int x1, int y1, std::function<bool(int)> fn);
     void forLineCornered(int x0, int y0, int x1, int y1, std::function<bool(int)> fn);
 
+    // turns the solid island at (x, y) into a rigid body if it has more than 10 and at most 1000 cells
     RigidBody* physicsCheck(int x, int y);
-    void physicsCheck_flood(int x, int y, bool* visited, int* count, uint32* cols, int* minX, int* maxX, int* minY, int* maxY);
+    // iterative scanline flood fill over SOLID tiles from (x, y), stamping islandVisited with islandEpoch
+    // leaves the cells in islandCells, returns false (and stops early) if there are more than maxCells
+    bool physicsCheck_flood(int x, int y, int maxCells, int* minX, int* maxX, int* minY, int* maxY);
+    uint32_t* islandVisited = nullptr;
+    uint32_t islandEpoch = 0;
+    std::vector<int> islandCells;
+    std::vector<int> islandStack;
+    // bumps islandEpoch (clearing islandVisited when it wraps)
+    uint32_t nextIslandEpoch();
+
+    // detached islands are found from where solid tiles were removed (Settings::tick_island_events)
+    // tick() collects those cells (from its kernels, reactions, and anything written outside of it that it gathers),
+    //   tickIslands (from tickFinish) checks the solids next to them, everything touched in one call is only flooded once
+    std::vector<int> solidRemoved;
+    std::vector<std::vector<int>> tickSolidRemoved; // per tickScheduler thread, merged into solidRemoved at the end of tick()
+    void tickIslands();
 
     ~World();
 